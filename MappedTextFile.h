@@ -0,0 +1,335 @@
+#pragma once
+/*
+MIT License
+
+Copyright (c) 2022 Morgan McGuire and Zander Majercik
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "SIMDString.h"
+#include <vector>
+#include <thread>
+#include <string_view>
+
+#ifdef _WIN32
+#   ifndef NOMINMAX
+#       define NOMINMAX
+#   endif
+#   include <windows.h>
+#else
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <fcntl.h>
+#   include <unistd.h>
+#endif
+
+/**
+   \brief Read-only memory-mapped view of a text file, split into lines.
+
+   Opening the file builds an index of line endings with a SIMD scan, after which each line is
+   available as a std::string_view into the mapping without copying. With Options::terminateLines,
+   the file is mapped copy-on-write and each delimiter is overwritten with '\0' in the private
+   copy, so lines can also be returned as borrowed SIMDStrings (see SIMDString::borrow()).
+
+   Lines follow getline() conventions: the delimiter is not included, and a final line
+   without a delimiter is still a line, while a trailing delimiter does not start a new one.
+*/
+class MappedTextFile {
+public:
+
+    /** Access pattern hint passed to madvise() */
+    enum Access {
+        ACCESS_NORMAL,
+        ACCESS_SEQUENTIAL,
+        ACCESS_RANDOM
+    };
+
+    struct Options {
+        char    delimiter = '\n';
+
+        /** Exclude a '\r' before the delimiter from the line */
+        bool    stripCarriageReturn = true;
+
+        /** Replace delimiters with '\0' in a private copy-on-write mapping so that lineString()
+            can borrow instead of copy. This dirties every page of the file that contains a delimiter. */
+        bool    terminateLines = false;
+
+        Access  access = ACCESS_SEQUENTIAL;
+    };
+
+    class const_iterator {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = std::string_view;
+        using reference = std::string_view;
+        using pointer = void;
+        using difference_type = ptrdiff_t;
+    private:
+        const MappedTextFile*   m_file;
+        size_t                  m_index;
+    public:
+        const_iterator(const MappedTextFile* file, size_t index) : m_file(file), m_index(index) {}
+
+        inline std::string_view operator*() const { return m_file->line(m_index); }
+        inline std::string_view operator[](difference_type i) const { return m_file->line(m_index + i); }
+        inline const_iterator& operator++() { ++m_index; return *this; }
+        inline const_iterator operator++(int) { const_iterator tmp(*this); ++m_index; return tmp; }
+        inline const_iterator& operator--() { --m_index; return *this; }
+        inline const_iterator operator--(int) { const_iterator tmp(*this); --m_index; return tmp; }
+        inline const_iterator& operator+=(difference_type rhs) { m_index += rhs; return *this; }
+        inline const_iterator& operator-=(difference_type rhs) { m_index -= rhs; return *this; }
+        inline const_iterator operator+(difference_type rhs) const { return const_iterator(m_file, m_index + rhs); }
+        inline const_iterator operator-(difference_type rhs) const { return const_iterator(m_file, m_index - rhs); }
+        inline difference_type operator-(const const_iterator& rhs) const { return difference_type(m_index - rhs.m_index); }
+        inline bool operator==(const const_iterator& rhs) const { return m_index == rhs.m_index; }
+        inline bool operator!=(const const_iterator& rhs) const { return m_index != rhs.m_index; }
+        inline bool operator<(const const_iterator& rhs) const { return m_index < rhs.m_index; }
+    };
+
+protected:
+
+    /** Set on an m_lineEnds entry when the delimiter was preceded by a stripped '\r' */
+    static constexpr uint64_t CR_FLAG = uint64_t(1) << 63;
+
+    char*                   m_data = nullptr;
+    size_t                  m_size = 0;
+    Options                 m_options;
+
+    /** Offset of the delimiter ending each line, or m_size for an unterminated last line, with CR_FLAG */
+    std::vector<uint64_t>   m_lineEnds;
+    bool                    m_lastLineTerminated = true;
+
+#   ifdef _WIN32
+        HANDLE              m_fileHandle = INVALID_HANDLE_VALUE;
+        HANDLE              m_mappingHandle = nullptr;
+#   endif
+
+    inline void addLineEnd(size_t pos) {
+        uint64_t entry = pos;
+        if (m_options.stripCarriageReturn && (pos > lineStart(m_lineEnds.size())) && (m_data[pos - 1] == '\r')) {
+            entry |= CR_FLAG;
+            if (m_options.terminateLines) { m_data[pos - 1] = '\0'; }
+        }
+        if (m_options.terminateLines) { m_data[pos] = '\0'; }
+        m_lineEnds.push_back(entry);
+    }
+
+    void buildIndex() {
+        const char delim = m_options.delimiter;
+        // Typical text files average well over 16 bytes per line
+        m_lineEnds.reserve(m_size / 32);
+
+        size_t i = 0;
+#       ifdef SIMDSTRING_SSE2
+            const __m128i delimVec = _mm_set1_epi8(delim);
+            for (; i + 16 <= m_size; i += 16) {
+                const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(m_data + i));
+                unsigned int mask = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(block, delimVec));
+                while (mask) {
+                    addLineEnd(i + countTrailingZeros(mask));
+                    mask &= mask - 1;
+                }
+            }
+#       endif
+        while (i < m_size) {
+            const char* found = static_cast<const char*>(::memchr(m_data + i, delim, m_size - i));
+            if (! found) { break; }
+            addLineEnd(size_t(found - m_data));
+            i = size_t(found - m_data) + 1;
+        }
+
+        m_lastLineTerminated = m_lineEnds.empty() ? (m_size == 0) : ((m_lineEnds.back() & ~CR_FLAG) == m_size - 1);
+        if (! m_lastLineTerminated) {
+            // The final line has no delimiter, but is still a line
+            m_lineEnds.push_back(m_size);
+        }
+    }
+
+    inline size_t lineStart(size_t i) const {
+        return i ? size_t(m_lineEnds[i - 1] & ~CR_FLAG) + 1 : 0;
+    }
+
+public:
+
+    MappedTextFile() {}
+
+    explicit MappedTextFile(const char* filename) {
+        open(filename, Options());
+    }
+
+    MappedTextFile(const char* filename, const Options& options) {
+        open(filename, options);
+    }
+
+    MappedTextFile(const MappedTextFile&) = delete;
+    MappedTextFile& operator=(const MappedTextFile&) = delete;
+
+    ~MappedTextFile() {
+        close();
+    }
+
+    /** Returns false if the file could not be opened or mapped */
+    bool open(const char* filename) {
+        return open(filename, Options());
+    }
+
+    bool open(const char* filename, const Options& options) {
+        close();
+        m_options = options;
+
+#       ifdef _WIN32
+            m_fileHandle = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                       (options.access == ACCESS_SEQUENTIAL) ? FILE_FLAG_SEQUENTIAL_SCAN :
+                                       (options.access == ACCESS_RANDOM) ? FILE_FLAG_RANDOM_ACCESS : FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (m_fileHandle == INVALID_HANDLE_VALUE) { return false; }
+
+            LARGE_INTEGER fileSize;
+            if (! GetFileSizeEx(m_fileHandle, &fileSize)) { close(); return false; }
+            m_size = size_t(fileSize.QuadPart);
+
+            if (m_size) {
+                m_mappingHandle = CreateFileMappingA(m_fileHandle, nullptr, options.terminateLines ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, nullptr);
+                if (! m_mappingHandle) { close(); return false; }
+                m_data = static_cast<char*>(MapViewOfFile(m_mappingHandle, options.terminateLines ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0));
+                if (! m_data) { close(); return false; }
+            }
+#       else
+            const int fd = ::open(filename, O_RDONLY);
+            if (fd < 0) { return false; }
+
+            struct stat st;
+            if (::fstat(fd, &st) != 0) { ::close(fd); return false; }
+            m_size = size_t(st.st_size);
+
+            if (m_size) {
+                void* ptr = ::mmap(nullptr, m_size, options.terminateLines ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_PRIVATE, fd, 0);
+                if (ptr == MAP_FAILED) { ::close(fd); m_size = 0; return false; }
+                m_data = static_cast<char*>(ptr);
+                ::madvise(ptr, m_size, (options.access == ACCESS_SEQUENTIAL) ? MADV_SEQUENTIAL :
+                                       (options.access == ACCESS_RANDOM) ? MADV_RANDOM : MADV_NORMAL);
+            }
+            // The mapping keeps its own reference to the file
+            ::close(fd);
+#       endif
+
+        buildIndex();
+        if (m_data && options.terminateLines) {
+            registerBorrowedBuffer(m_data, m_size);
+        }
+        return true;
+    }
+
+    void close() {
+        if (m_data && m_options.terminateLines) {
+            unregisterBorrowedBuffer(m_data);
+        }
+#       ifdef _WIN32
+            if (m_data) { UnmapViewOfFile(m_data); }
+            if (m_mappingHandle) { CloseHandle(m_mappingHandle); }
+            if (m_fileHandle != INVALID_HANDLE_VALUE) { CloseHandle(m_fileHandle); }
+            m_mappingHandle = nullptr;
+            m_fileHandle = INVALID_HANDLE_VALUE;
+#       else
+            if (m_data) { ::munmap(m_data, m_size); }
+#       endif
+        m_data = nullptr;
+        m_size = 0;
+        m_lineEnds.clear();
+        m_lastLineTerminated = true;
+    }
+
+    /** Re-advises the kernel on the access pattern for the whole mapping. No-op on Windows. */
+    void advise(Access access) const {
+#       ifndef _WIN32
+            if (m_data) {
+                ::madvise(m_data, m_size, (access == ACCESS_SEQUENTIAL) ? MADV_SEQUENTIAL :
+                                          (access == ACCESS_RANDOM) ? MADV_RANDOM : MADV_NORMAL);
+            }
+#       endif
+    }
+
+    /** All bytes of the file. Delimiters are '\0' if Options::terminateLines was set. */
+    inline const char* data() const {
+        return m_data;
+    }
+
+    inline size_t size() const {
+        return m_size;
+    }
+
+    inline size_t lineCount() const {
+        return m_lineEnds.size();
+    }
+
+    inline std::string_view line(size_t i) const {
+        assert(i < m_lineEnds.size()); // "Line index out of bounds"
+        const size_t start = lineStart(i);
+        const uint64_t end = m_lineEnds[i];
+        return std::string_view(m_data + start, size_t(end & ~CR_FLAG) - start - ((end & CR_FLAG) ? 1 : 0));
+    }
+
+    /** Returns line i as a SIMDString that borrows from the mapping when Options::terminateLines
+        was set, and otherwise copies it. The result must not outlive this file. */
+    template<class StringType = SIMDString<>>
+    StringType lineString(size_t i) const {
+        const std::string_view v = line(i);
+        if (m_options.terminateLines && ((i + 1 < m_lineEnds.size()) || m_lastLineTerminated)) {
+            return StringType::borrow(v.data(), v.size());
+        } else {
+            return StringType(v.data(), v.size());
+        }
+    }
+
+    inline const_iterator begin() const {
+        return const_iterator(this, 0);
+    }
+
+    inline const_iterator end() const {
+        return const_iterator(this, m_lineEnds.size());
+    }
+
+    /** Calls fn(lineIndex, std::string_view line) for every line, splitting contiguous blocks of lines
+        across threadCount threads (0 = hardware concurrency). fn must be safe to call concurrently. */
+    template<class Function>
+    void parallelForEachLine(Function fn, unsigned int threadCount = 0) const {
+        if (! threadCount) { threadCount = std::max(1u, std::thread::hardware_concurrency()); }
+        const size_t n = lineCount();
+        threadCount = (unsigned int)std::min<size_t>(threadCount, std::max<size_t>(n, 1));
+        const size_t blockSize = (n + threadCount - 1) / threadCount;
+
+        auto runBlock = [this, &fn, n, blockSize](unsigned int t) {
+            const size_t last = std::min(n, (t + 1) * blockSize);
+            for (size_t i = t * blockSize; i < last; ++i) {
+                fn(i, line(i));
+            }
+        };
+
+        std::vector<std::thread> threads;
+        threads.reserve(threadCount - 1);
+        for (unsigned int t = 1; t < threadCount; ++t) {
+            threads.emplace_back(runBlock, t);
+        }
+        // The calling thread takes the first block
+        runBlock(0);
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    }
+};
@@ -22,8 +22,16 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
 
+#include "SIMDString.h"
 #include <stdint.h>
 #include <cstdlib>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
 
 #ifdef _WIN32
 #   define OS_WINDOWS
@@ -73,3 +81,211 @@ bool inConstSegment(const char* c) {
     return (std::labs(static_cast<long>(uintptr_t(c) - PROBED_CONST_SEG_ADDR)) < 5000000L);
 #endif
 }
+
+
+#if SIMDSTRING_TRACK_BORROWS
+namespace {
+    struct BorrowedBuffer {
+        const char* begin;
+        // Inclusive, because a borrowed string's '\0' may be the last byte of the buffer
+        const char* end;
+        // Order of unregistration, for forgetting the oldest
+        uint64_t    sequence;
+    };
+
+    // Unregistered buffers whose records are kept to catch stale reads. Beyond this, the oldest is
+    // forgotten, so that a long session that keeps loading and unloading files uses bounded memory.
+    constexpr size_t MAX_UNLOADED_BORROWED_BUFFERS = 256;
+
+    // Reads through const strings take it shared, and only registration takes it exclusively
+    std::shared_mutex           borrowedBufferMutex;
+    std::vector<BorrowedBuffer> liveBorrowedBuffers;
+    // Sorted by begin and disjoint, for a binary search on every read of a const string
+    std::vector<BorrowedBuffer> unloadedBorrowedBuffers;
+    uint64_t                    unloadSequence = 0;
+
+    // Lets borrowedPointerIsLive() skip the lock in the common case where nothing has been unloaded
+    std::atomic<size_t>         unloadedBorrowedBufferCount(0);
+
+    bool overlaps(const BorrowedBuffer& b, const char* begin, const char* end) {
+        return (b.begin <= end) && (begin <= b.end);
+    }
+}
+#endif
+
+void registerBorrowedBuffer(const char* begin, size_t size) {
+#if SIMDSTRING_TRACK_BORROWS
+    std::unique_lock<std::shared_mutex> lock(borrowedBufferMutex);
+    const char* end = begin + size;
+
+    // The memory may have been reused from an unloaded buffer, so forget any overlapping records
+    auto overlapping = [&](const BorrowedBuffer& b) { return overlaps(b, begin, end); };
+    liveBorrowedBuffers.erase(std::remove_if(liveBorrowedBuffers.begin(), liveBorrowedBuffers.end(), overlapping), liveBorrowedBuffers.end());
+    unloadedBorrowedBuffers.erase(std::remove_if(unloadedBorrowedBuffers.begin(), unloadedBorrowedBuffers.end(), overlapping), unloadedBorrowedBuffers.end());
+    unloadedBorrowedBufferCount = unloadedBorrowedBuffers.size();
+    liveBorrowedBuffers.push_back(BorrowedBuffer{begin, end, 0});
+#else
+    (void)begin;
+    (void)size;
+#endif
+}
+
+void unregisterBorrowedBuffer(const char* begin) {
+#if SIMDSTRING_TRACK_BORROWS
+    std::unique_lock<std::shared_mutex> lock(borrowedBufferMutex);
+    const auto live = std::find_if(liveBorrowedBuffers.begin(), liveBorrowedBuffers.end(), [&](const BorrowedBuffer& b) { return b.begin == begin; });
+    if (live == liveBorrowedBuffers.end()) {
+        return;
+    }
+
+    // Keep the record so that later reads through stale strings can be detected
+    BorrowedBuffer unloaded = *live;
+    unloaded.sequence = ++unloadSequence;
+    liveBorrowedBuffers.erase(live);
+    const auto position = std::lower_bound(unloadedBorrowedBuffers.begin(), unloadedBorrowedBuffers.end(), unloaded,
+        [](const BorrowedBuffer& a, const BorrowedBuffer& b) { return a.begin < b.begin; });
+    unloadedBorrowedBuffers.insert(position, unloaded);
+
+    if (unloadedBorrowedBuffers.size() > MAX_UNLOADED_BORROWED_BUFFERS) {
+        const auto oldest = std::min_element(unloadedBorrowedBuffers.begin(), unloadedBorrowedBuffers.end(),
+            [](const BorrowedBuffer& a, const BorrowedBuffer& b) { return a.sequence < b.sequence; });
+        unloadedBorrowedBuffers.erase(oldest);
+    }
+    unloadedBorrowedBufferCount = unloadedBorrowedBuffers.size();
+#else
+    (void)begin;
+#endif
+}
+
+bool borrowedPointerIsLive(const char* c) {
+#if SIMDSTRING_TRACK_BORROWS
+    if (! unloadedBorrowedBufferCount.load(std::memory_order_relaxed)) {
+        return true;
+    }
+
+    std::shared_lock<std::shared_mutex> lock(borrowedBufferMutex);
+    // The last unloaded buffer that begins at or before c is the only one that can contain it
+    const auto after = std::upper_bound(unloadedBorrowedBuffers.begin(), unloadedBorrowedBuffers.end(), c,
+        [](const char* p, const BorrowedBuffer& b) { return p < b.begin; });
+    if ((after != unloadedBorrowedBuffers.begin()) && (c <= (after - 1)->end)) {
+        return false;
+    }
+#else
+    (void)c;
+#endif
+    return true;
+}
+
+namespace {
+    struct ParallelJob {
+        void                (*fn)(void*, size_t);
+        void*               context;
+        size_t              taskCount;
+        std::atomic<size_t> nextTask{0};
+
+        void run() {
+            for (size_t task = nextTask++; task < taskCount; task = nextTask++) {
+                fn(context, task);
+            }
+        }
+    };
+
+    /** Worker threads that sleep until runParallelTasks() posts a job. One job runs at a time, and the
+        tasks beyond the number of workers are taken by whichever thread finishes first. */
+    class ParallelTaskPool {
+        static constexpr size_t     MAX_WORKERS = 63;
+
+        std::mutex                  m_callMutex;
+
+        std::mutex                  m_mutex;
+        std::condition_variable     m_wake;
+        std::condition_variable     m_idle;
+        ParallelJob*                m_job = nullptr;
+        uint64_t                    m_generation = 0;
+        // Workers that hold a pointer to m_job
+        unsigned int                m_busy = 0;
+        bool                        m_stop = false;
+
+        std::vector<std::thread>    m_workers;
+
+        void work() {
+            uint64_t seen = 0;
+            for (;;) {
+                ParallelJob* job;
+                {
+                    std::unique_lock<std::mutex> lock(m_mutex);
+                    m_wake.wait(lock, [&] { return m_stop || (m_generation != seen); });
+                    if (m_stop) { return; }
+                    seen = m_generation;
+                    job = m_job;
+                    if (! job) { continue; }
+                    ++m_busy;
+                }
+                job->run();
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    --m_busy;
+                }
+                m_idle.notify_all();
+            }
+        }
+
+    public:
+        ~ParallelTaskPool() {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stop = true;
+            }
+            m_wake.notify_all();
+            for (std::thread& worker : m_workers) {
+                worker.join();
+            }
+        }
+
+        void run(size_t taskCount, void (*fn)(void*, size_t), void* context) {
+            ParallelJob job;
+            job.fn = fn;
+            job.context = context;
+            job.taskCount = taskCount;
+
+            // Nested and concurrent calls run on their own thread rather than wait
+            std::unique_lock<std::mutex> call(m_callMutex, std::try_to_lock);
+            if (! call.owns_lock()) {
+                job.run();
+                return;
+            }
+
+            // One worker per task after the caller's, up to the most requested so far
+            while ((m_workers.size() + 1 < taskCount) && (m_workers.size() < MAX_WORKERS)) {
+                m_workers.emplace_back([this] { work(); });
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_job = &job;
+                ++m_generation;
+            }
+            m_wake.notify_all();
+            job.run();
+
+            // Every task has been claimed, so wait for the workers still running one
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_job = nullptr;
+            m_idle.wait(lock, [&] { return m_busy == 0; });
+        }
+    };
+
+    ParallelTaskPool& parallelTaskPool() {
+        static ParallelTaskPool pool;
+        return pool;
+    }
+}
+
+unsigned int parallelHardwareThreads() {
+    static const unsigned int count = std::max(1u, std::thread::hardware_concurrency());
+    return count;
+}
+
+void runParallelTasks(size_t taskCount, void (*fn)(void* context, size_t task), void* context) {
+    parallelTaskPool().run(taskCount, fn, context);
+}
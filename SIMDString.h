@@ -29,6 +29,7 @@ SOFTWARE.
 #include <stdint.h>
 #include <assert.h>
 #include <algorithm>
+#include <atomic>
 #include <cstring>
 #include <iterator>
 #include <cstddef>
@@ -37,8 +38,36 @@ SOFTWARE.
 #include <iostream>
 #include <string_view>
 #include <initializer_list>
+#include <charconv>
 #include <errno.h>
 
+#if defined(_MSC_VER)
+#   include <intrin.h>
+#endif
+
+// Instruction sets that the optional headers' vector paths may use, from the compiler's target flags.
+// MSVC has no SSSE3 macro, but defines __AVX__ under /arch:AVX, which implies SSSE3. x64 alone only
+// guarantees SSE2.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#   include <emmintrin.h>
+#   define SIMDSTRING_SSE2
+#endif
+#if defined(__SSSE3__) || defined(__AVX__)
+#   include <tmmintrin.h>
+#   define SIMDSTRING_SSSE3
+#endif
+
+/** Index of the lowest set bit of mask, which must not be 0, as from a _mm_movemask_epi8() result */
+inline unsigned int countTrailingZeros(unsigned int mask) {
+#   ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward(&index, mask);
+        return (unsigned int)index;
+#   else
+        return (unsigned int)__builtin_ctz(mask);
+#   endif
+}
+
 #if defined(USE_SSE_MEMCPY) && USE_SSE_MEMCPY
 #   if defined(__i386__) || defined(_M_IX86) || defined(__x86_64__) || defined(_M_X64)
 #       define SSE_x64
@@ -62,8 +91,656 @@ SOFTWARE.
 
 bool inConstSegment(const char* c);
 
+/** In debug builds, SIMDString checks that strings created by SIMDString::borrow() are not read after
+    their buffer has been passed to unregisterBorrowedBuffer(). Define SIMDSTRING_TRACK_BORROWS=0 or 1
+    to override, with the same value for SIMDString.cpp as for its callers. When 0, the registration
+    functions do nothing. */
+#ifndef SIMDSTRING_TRACK_BORROWS
+#   ifdef NDEBUG
+#       define SIMDSTRING_TRACK_BORROWS 0
+#   else
+#       define SIMDSTRING_TRACK_BORROWS 1
+#   endif
+#endif
+
+/** to_string() of integers in [0, SIMDSTRING_SMALL_INT_COUNT) returns a constant string that points into a
+    precomputed read-only table, without formatting or copying. The table holds SIMDSTRING_SMALL_INT_COUNT
+    entries of (digits + 1) bytes, about 50 kB for the default. Define as 0 to disable, or up to 100000, beyond
+    which compilers' constant-evaluation loop limits are exceeded. Must have the same value in every
+    translation unit, because the table is an inline variable shared across them. */
+#ifndef SIMDSTRING_SMALL_INT_COUNT
+#   define SIMDSTRING_SMALL_INT_COUNT 10000
+#endif
+
+/** Declares that [begin, begin + size) is a long-lived caller-owned buffer whose strings may be
+    referenced with SIMDString::borrow(). Only used for debug lifetime tracking, and free otherwise. */
+void registerBorrowedBuffer(const char* begin, size_t size);
+
+/** Declares that the buffer previously registered at begin is about to be unloaded. In debug builds,
+    later reads through any SIMDString still borrowing from it will assert, for up to the 256 most
+    recently unloaded buffers. */
+void unregisterBorrowedBuffer(const char* begin);
+
+/** Returns false if c points into a buffer that was registered and has since been unregistered.
+    Always true when SIMDSTRING_TRACK_BORROWS is 0. Lock-free until a buffer has been unregistered, and
+    after that a binary search of the unloaded buffers under a shared lock. */
+bool borrowedPointerIsLive(const char* c);
+
+/** Strings of at least this many bytes are split across threads by the SIMDStringParallel overloads.
+    Shorter ones are processed serially, because waking threads would cost more than it saves. */
+#ifndef SIMDSTRING_PARALLEL_THRESHOLD
+#   define SIMDSTRING_PARALLEL_THRESHOLD (1 << 20)
+#endif
+
+/** Selects the multithreaded overloads of SIMDString::find(), rfind(), count(), append(), and the copy
+    constructor, for multi-megabyte strings */
+struct SIMDStringParallel {
+    /** Most threads to use, including the calling one, or 0 for all hardware threads */
+    unsigned int threadCount = 0;
+};
+
+/** Runs fn(context, task) for every task in [0, taskCount) on SIMDString's internal worker threads and
+    the calling thread, and returns when all have finished. Workers are started as needed, up to one
+    per task after the first. If they are busy with another call, the tasks run on the calling thread. */
+void runParallelTasks(size_t taskCount, void (*fn)(void* context, size_t task), void* context);
+
+/** std::thread::hardware_concurrency(), or 1 if that is unknown */
+unsigned int parallelHardwareThreads();
+
 constexpr size_t SSO_ALIGNMENT = 16;
 
+/** Number of tasks to split size bytes of work into: one per thread, each of at least a quarter of
+    SIMDSTRING_PARALLEL_THRESHOLD bytes, or 1 below the threshold */
+inline size_t parallel_task_count(size_t size, const SIMDStringParallel& parallel) {
+    if (size < SIMDSTRING_PARALLEL_THRESHOLD) {
+        return 1;
+    }
+    const size_t threads = parallel.threadCount ? parallel.threadCount : parallelHardwareThreads();
+    return std::max<size_t>(1, std::min<size_t>(threads, size / (SIMDSTRING_PARALLEL_THRESHOLD / 4)));
+}
+
+/** Calls fn(task) for every task in [0, taskCount) through runParallelTasks() */
+template<class Function>
+void parallel_for_tasks(size_t taskCount, Function& fn) {
+    if (taskCount == 1) {
+        fn(size_t(0));
+    } else {
+        runParallelTasks(taskCount, [](void* context, size_t task) { (*static_cast<Function*>(context))(task); }, &fn);
+    }
+}
+
+/** memcpy() in one slice per task */
+inline void parallel_memcpy(void* dst, const void* src, size_t count, const SIMDStringParallel& parallel) {
+    const size_t tasks = parallel_task_count(count, parallel);
+    if (tasks == 1) {
+        if (count) { ::memcpy(dst, src, count); }
+        return;
+    }
+    // Whole cache lines per slice
+    const size_t slice = ((count + tasks - 1) / tasks + 63) & ~size_t(63);
+    auto copySlice = [&](size_t t) {
+        const size_t begin = std::min(count, t * slice);
+        const size_t end = std::min(count, begin + slice);
+        if (end > begin) {
+            ::memcpy(static_cast<char*>(dst) + begin, static_cast<const char*>(src) + begin, end - begin);
+        }
+    };
+    parallel_for_tasks(tasks, copySlice);
+}
+
+/** Number of occurrences of c in [begin, end) */
+inline size_t count_char(const char* begin, const char* end, char c) {
+    size_t n = 0;
+#   ifdef SSE_x64
+        const __m128i target = _mm_set1_epi8(c);
+        while (end - begin >= 16) {
+            // Count in bytes, which hold up to 255, then add the bytes with SAD
+            const size_t blocks = std::min<size_t>(size_t(end - begin) / 16, 255);
+            __m128i counts = _mm_setzero_si128();
+            for (size_t i = 0; i < blocks; ++i, begin += 16) {
+                counts = _mm_sub_epi8(counts, _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(begin)), target));
+            }
+            const __m128i sums = _mm_sad_epu8(counts, _mm_setzero_si128());
+            n += size_t(_mm_cvtsi128_si32(sums)) + size_t(_mm_extract_epi16(sums, 4));
+        }
+#   endif
+    for (; begin < end; ++begin) {
+        n += (*begin == c);
+    }
+    return n;
+}
+
+/** Case conversion and comparison that fold only the ASCII letters A-Z and a-z. Other bytes, including
+    the bytes of UTF-8 sequences, are compared exactly. */
+constexpr inline char ascii_tolower(char c) {
+    return ((c >= 'A') && (c <= 'Z')) ? char(c + ('a' - 'A')) : c;
+}
+
+constexpr inline char ascii_toupper(char c) {
+    return ((c >= 'a') && (c <= 'z')) ? char(c - ('a' - 'A')) : c;
+}
+
+#ifdef SSE_x64
+/** ascii_tolower() of 16 bytes. Adding 0x80 - 'A' maps A-Z, and only those, to the 26 smallest signed
+    bytes. */
+inline __m128i ascii_tolower_epi8(__m128i v) {
+    const __m128i isUpper = _mm_cmplt_epi8(_mm_add_epi8(v, _mm_set1_epi8(char(0x80 - 'A'))), _mm_set1_epi8(char(-128 + 26)));
+    return _mm_or_si128(v, _mm_and_si128(isUpper, _mm_set1_epi8(0x20)));
+}
+
+inline __m128i ascii_toupper_epi8(__m128i v) {
+    const __m128i isLower = _mm_cmplt_epi8(_mm_add_epi8(v, _mm_set1_epi8(char(0x80 - 'a'))), _mm_set1_epi8(char(-128 + 26)));
+    return _mm_andnot_si128(_mm_and_si128(isLower, _mm_set1_epi8(0x20)), v);
+}
+#endif
+
+/** Converts count bytes at s to lower case in place, 32 bytes per step with AVX2 and 16 with SSE2 */
+inline void ascii_tolower(char* s, size_t count) {
+    size_t i = 0;
+#   ifdef SSE_x64
+#       ifdef __AVX2__
+            for (; i + 32 <= count; i += 32) {
+                const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i));
+                const __m256i isUpper = _mm256_cmpgt_epi8(_mm256_set1_epi8(char(-128 + 26)), _mm256_add_epi8(v, _mm256_set1_epi8(char(0x80 - 'A'))));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(s + i), _mm256_or_si256(v, _mm256_and_si256(isUpper, _mm256_set1_epi8(0x20))));
+            }
+#       endif
+        for (; i + 16 <= count; i += 16) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(s + i), ascii_tolower_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i))));
+        }
+#   endif
+    for (; i < count; ++i) {
+        s[i] = ascii_tolower(s[i]);
+    }
+}
+
+inline void ascii_toupper(char* s, size_t count) {
+    size_t i = 0;
+#   ifdef SSE_x64
+#       ifdef __AVX2__
+            for (; i + 32 <= count; i += 32) {
+                const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i));
+                const __m256i isLower = _mm256_cmpgt_epi8(_mm256_set1_epi8(char(-128 + 26)), _mm256_add_epi8(v, _mm256_set1_epi8(char(0x80 - 'a'))));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(s + i), _mm256_andnot_si256(_mm256_and_si256(isLower, _mm256_set1_epi8(0x20)), v));
+            }
+#       endif
+        for (; i + 16 <= count; i += 16) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(s + i), ascii_toupper_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i))));
+        }
+#   endif
+    for (; i < count; ++i) {
+        s[i] = ascii_toupper(s[i]);
+    }
+}
+
+/** True if the count bytes at a and b are equal after ascii_tolower() */
+inline bool ascii_iequal(const char* a, const char* b, size_t count) {
+    size_t i = 0;
+#   ifdef SSE_x64
+        for (; i + 16 <= count; i += 16) {
+            const __m128i x = ascii_tolower_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i)));
+            const __m128i y = ascii_tolower_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i)));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(x, y)) != 0xFFFF) { return false; }
+        }
+#   endif
+    for (; i < count; ++i) {
+        if (ascii_tolower(a[i]) != ascii_tolower(b[i])) { return false; }
+    }
+    return true;
+}
+
+/** Compares like memcmp() and then by length, after ascii_tolower() */
+inline int ascii_icompare(const char* a, size_t alen, const char* b, size_t blen) {
+    const size_t count = std::min(alen, blen);
+    size_t i = 0;
+#   ifdef SSE_x64
+        for (; i + 16 <= count; i += 16) {
+            const __m128i x = ascii_tolower_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i)));
+            const __m128i y = ascii_tolower_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i)));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(x, y)) != 0xFFFF) { break; }
+        }
+#   endif
+    for (; i < count; ++i) {
+        const uint8_t x = uint8_t(ascii_tolower(a[i]));
+        const uint8_t y = uint8_t(ascii_tolower(b[i]));
+        if (x != y) { return int(x) - int(y); }
+    }
+    return (alen < blen) ? -1 : (alen > blen) ? 1 : 0;
+}
+
+/** Hash of the count bytes at s after ascii_tolower(), so that strings that are ascii_iequal() hash
+    equally. Lowers eight bytes at a time in a 64-bit register instead of copying the string. */
+inline size_t ascii_ihash(const char* s, size_t count) {
+    // Sets bit 5 of each byte in A-Z: the high bit of the sum with 0x80 - 'A' is set for bytes >= 'A',
+    // and with 0x80 - 'Z' - 1 for bytes > 'Z', counting only the low seven bits of each byte
+    constexpr uint64_t ONES = 0x0101010101010101ULL;
+    auto lowerWord = [](uint64_t w) {
+        const uint64_t low7 = w & (0x7F * ONES);
+        const uint64_t upper = ((low7 + (0x80 - 'A') * ONES) ^ (low7 + (0x80 - 'Z' - 1) * ONES)) & ~w & (0x80 * ONES);
+        return w | (upper >> 2);
+    };
+    auto mix = [](uint64_t h, uint64_t w) {
+        h = (h ^ w) * 0xBF58476D1CE4E5B9ULL;
+        return h ^ (h >> 31);
+    };
+
+    uint64_t h = 0x9E3779B97F4A7C15ULL ^ uint64_t(count);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        uint64_t w;
+        ::memcpy(&w, s + i, 8);
+        h = mix(h, lowerWord(w));
+    }
+    if (i < count) {
+        uint64_t w = 0;
+        ::memcpy(&w, s + i, count - i);
+        h = mix(h, lowerWord(w));
+    }
+    h = (h ^ (h >> 27)) * 0x94D049BB133111EBULL;
+    return size_t(h ^ (h >> 31));
+}
+
+template<size_t INTERNAL_SIZE, class Allocator> class SIMDString;
+
+/**
+   \brief A substring search for one needle, prepared once and run on many haystacks.
+
+   Build one per needle that is searched for in many strings, as in log filters and asset scans, and
+   call find_in(), rfind_in() and count_in() on each haystack. The constructor picks a strategy:
+
+   - FILTER: compare the needle's first and last bytes against 16 candidate positions at once with
+     SSE2, and memcmp() only the candidates where both match. This is the fastest on text, where the
+     needle's bytes are common in the haystack.
+   - HORSPOOL: skip ahead by a per-byte shift of up to the needle's length. Chosen when the shifts of
+     the needle's own bytes average at least HORSPOOL_MIN_SHIFT, so that it skips more than a block of
+     the filter per step.
+   - TWO_WAY: for needles of at least TWO_WAY_MIN_LENGTH bytes that Horspool would also suit. Uses the
+     same shifts, and never compares a haystack byte more than twice, so that it takes linear time.
+
+   For needles of at least TWO_WAY_MIN_LENGTH bytes the filter also stays linear: once verifying
+   candidates has cost more than the bytes scanned, it continues with Two-Way. rfind_in() uses the
+   filter or Horspool in reverse.
+
+   SIMDString::find() and rfind() call the static find() and rfind(), which run the filter without
+   building the tables, and compute them only if falling back to Two-Way.
+*/
+class SIMDStringSearcher {
+public:
+    static constexpr size_t npos = size_t(-1);
+    static constexpr size_t TWO_WAY_MIN_LENGTH = 256;
+    static constexpr size_t HORSPOOL_MIN_SHIFT = 32;
+
+    enum class Strategy { EMPTY, BYTE, FILTER, HORSPOOL, TWO_WAY };
+
+protected:
+    /** Horspool shifts and Two-Way critical factorization of a needle */
+    struct Tables {
+        /** Horspool shift for each byte in the last position of the window */
+        size_t      shift[256];
+
+        /** The needle factors into [0, split] and (split, size), with split == npos for an empty left
+            half */
+        size_t      split;
+        size_t      period;
+
+        /** Bytes known to match after a shift by period, nonzero only for periodic needles */
+        size_t      memory;
+    };
+
+    std::string     m_needle;
+    Strategy        m_strategy;
+
+    /** Computed for needles longer than HORSPOOL_MIN_SHIFT */
+    Tables          m_tables;
+
+    /** Horspool shift for each byte in the first position of the window, for rfind_in() */
+    size_t          m_reverseShift[256];
+
+    static inline unsigned int highestBit(unsigned int mask) {
+#       ifdef _MSC_VER
+            unsigned long index;
+            _BitScanReverse(&index, mask);
+            return (unsigned int)index;
+#       else
+            return 31u - (unsigned int)__builtin_clz(mask);
+#       endif
+    }
+
+    static void computeTables(const char* needle, size_t m, Tables& tables) {
+        const uint8_t* x = reinterpret_cast<const uint8_t*>(needle);
+        std::fill(tables.shift, tables.shift + 256, m);
+        for (size_t k = 0; k + 1 < m; ++k) {
+            tables.shift[x[k]] = m - 1 - k;
+        }
+
+        // Crochemore-Perrin critical factorization, from the larger of the maximal suffixes under the
+        // two byte orders
+        size_t suffix[2], suffixPeriod[2];
+        for (int order = 0; order < 2; ++order) {
+            // i is one before the candidate suffix, starting at npos and wrapping back to 0
+            size_t i = npos, j = 0, k = 1, p = 1;
+            while (j + k < m) {
+                const uint8_t a = x[i + k];
+                const uint8_t b = x[j + k];
+                if (a == b) {
+                    if (k == p) {
+                        j += p;
+                        k = 1;
+                    } else {
+                        ++k;
+                    }
+                } else if ((a > b) == (order == 0)) {
+                    j += k;
+                    k = 1;
+                    p = j - i;
+                } else {
+                    i = j++;
+                    k = p = 1;
+                }
+            }
+            suffix[order] = i;
+            suffixPeriod[order] = p;
+        }
+        const int larger = (suffix[1] + 1 > suffix[0] + 1) ? 1 : 0;
+        tables.split = suffix[larger];
+        tables.period = suffixPeriod[larger];
+
+        if (::memcmp(x, x + tables.period, tables.split + 1) != 0) {
+            // Not periodic: any shift up to the longer half is safe
+            tables.period = std::max(tables.split + 1, m - tables.split - 1);
+            tables.memory = 0;
+        } else {
+            tables.memory = m - tables.period;
+        }
+    }
+
+    static size_t twoWayFind(const char* h, size_t n, size_t pos, const char* x, size_t m, const Tables& tables) {
+        const uint8_t lastByte = uint8_t(x[m - 1]);
+        size_t memory = 0;
+        for (size_t i = pos; i <= n - m; ) {
+            const uint8_t c = uint8_t(h[i + m - 1]);
+            if (c != lastByte) {
+                i += std::max(tables.shift[c], memory);
+                memory = 0;
+                continue;
+            }
+
+            // Right half, then left half
+            size_t k = std::max(tables.split + 1, memory);
+            while ((k < m) && (x[k] == h[i + k])) { ++k; }
+            if (k < m) {
+                i += k - tables.split;
+                memory = 0;
+                continue;
+            }
+            k = tables.split + 1;
+            while ((k > memory) && (x[k - 1] == h[i + k - 1])) { --k; }
+            if (k <= memory) { return i; }
+            i += tables.period;
+            memory = tables.memory;
+        }
+        return npos;
+    }
+
+    /** twoWayFind(), computing the tables if there are none */
+    static size_t twoWayFind(const char* h, size_t n, size_t pos, const char* x, size_t m, const Tables* tables) {
+        if (tables) {
+            return twoWayFind(h, n, pos, x, m, *tables);
+        }
+        Tables computed;
+        computeTables(x, m, computed);
+        return twoWayFind(h, n, pos, x, m, computed);
+    }
+
+    /** First-and-last-byte filter for needles of at least 2 bytes, falling back to Two-Way for needles
+        of at least TWO_WAY_MIN_LENGTH bytes. tables may be null. */
+    static size_t filterFind(const char* h, size_t n, size_t pos, const char* x, size_t m, const Tables* tables) {
+        const size_t last = n - m;
+        const bool bounded = (m >= TWO_WAY_MIN_LENGTH);
+        // Bytes that verifying candidates may have compared, charging the whole needle per candidate
+        size_t compared = 0;
+        size_t i = pos;
+#       ifdef SSE_x64
+            const __m128i first = _mm_set1_epi8(x[0]);
+            const __m128i lastByte = _mm_set1_epi8(x[m - 1]);
+            for (; i + 15 <= last; i += 16) {
+                const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(h + i));
+                const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(h + i + m - 1));
+                unsigned int mask = (unsigned int)_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, lastByte)));
+                while (mask) {
+                    const size_t j = i + countTrailingZeros(mask);
+                    if (bounded && ((compared += m) > j - pos + 4 * m)) { return twoWayFind(h, n, j, x, m, tables); }
+                    if (::memcmp(h + j + 1, x + 1, m - 2) == 0) { return j; }
+                    mask &= mask - 1;
+                }
+            }
+#       endif
+        for (; i <= last; ++i) {
+            if ((h[i] == x[0]) && (h[i + m - 1] == x[m - 1])) {
+                if (bounded && ((compared += m) > i - pos + 4 * m)) { return twoWayFind(h, n, i, x, m, tables); }
+                if (::memcmp(h + i + 1, x + 1, m - 2) == 0) { return i; }
+            }
+        }
+        return npos;
+    }
+
+    /** filterFind() from the candidate at hi down to 0 */
+    static size_t filterFindReverse(const char* h, size_t hi, const char* x, size_t m) {
+        size_t i = hi + 1;
+#       ifdef SSE_x64
+            const __m128i first = _mm_set1_epi8(x[0]);
+            const __m128i lastByte = _mm_set1_epi8(x[m - 1]);
+            for (; i >= 16; i -= 16) {
+                const char* block = h + i - 16;
+                const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block));
+                const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + m - 1));
+                unsigned int mask = (unsigned int)_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, lastByte)));
+                while (mask) {
+                    const unsigned int j = highestBit(mask);
+                    if (::memcmp(block + j + 1, x + 1, m - 2) == 0) { return i - 16 + j; }
+                    mask ^= 1u << j;
+                }
+            }
+#       endif
+        while (i-- > 0) {
+            if ((h[i] == x[0]) && (h[i + m - 1] == x[m - 1]) && (::memcmp(h + i + 1, x + 1, m - 2) == 0)) { return i; }
+        }
+        return npos;
+    }
+
+    static size_t horspoolFind(const char* h, size_t n, size_t pos, const char* x, size_t m, const size_t* shift) {
+        const uint8_t lastByte = uint8_t(x[m - 1]);
+        for (size_t i = pos; i <= n - m; ) {
+            const uint8_t c = uint8_t(h[i + m - 1]);
+            if ((c == lastByte) && (::memcmp(h + i, x, m - 1) == 0)) { return i; }
+            i += shift[c];
+        }
+        return npos;
+    }
+
+    static size_t horspoolFindReverse(const char* h, size_t hi, const char* x, size_t m, const size_t* reverseShift) {
+        const uint8_t first = uint8_t(x[0]);
+        for (size_t i = hi; ; ) {
+            const uint8_t c = uint8_t(h[i]);
+            if ((c == first) && (::memcmp(h + i + 1, x + 1, m - 1) == 0)) { return i; }
+            if (i < reverseShift[c]) { return npos; }
+            i -= reverseShift[c];
+        }
+    }
+
+public:
+
+    explicit SIMDStringSearcher(std::string_view needle) : m_needle(needle) {
+        const size_t m = m_needle.size();
+        if (m == 0) {
+            m_strategy = Strategy::EMPTY;
+        } else if (m == 1) {
+            m_strategy = Strategy::BYTE;
+        } else if (m <= HORSPOOL_MIN_SHIFT) {
+            m_strategy = Strategy::FILTER;
+        } else {
+            computeTables(m_needle.data(), m, m_tables);
+            std::fill(m_reverseShift, m_reverseShift + 256, m);
+            for (size_t k = m - 1; k > 0; --k) {
+                m_reverseShift[uint8_t(m_needle[k])] = k;
+            }
+
+            // Expected Horspool shift if the haystack's bytes are distributed like the needle's
+            size_t totalShift = 0;
+            for (const char c : m_needle) {
+                totalShift += m_tables.shift[uint8_t(c)];
+            }
+            if (totalShift < HORSPOOL_MIN_SHIFT * m) {
+                m_strategy = Strategy::FILTER;
+            } else {
+                m_strategy = (m < TWO_WAY_MIN_LENGTH) ? Strategy::HORSPOOL : Strategy::TWO_WAY;
+            }
+        }
+    }
+
+    explicit SIMDStringSearcher(const char* needle) : SIMDStringSearcher(std::string_view(needle)) {}
+
+    explicit SIMDStringSearcher(const std::string& needle) : SIMDStringSearcher(std::string_view(needle)) {}
+
+    template<size_t INTERNAL_SIZE, class Allocator>
+    explicit SIMDStringSearcher(const SIMDString<INTERNAL_SIZE, Allocator>& needle) : SIMDStringSearcher(std::string_view(needle.data(), needle.size())) {}
+
+    inline std::string_view needle() const {
+        return m_needle;
+    }
+
+    inline Strategy strategy() const {
+        return m_strategy;
+    }
+
+    /** Position of the first occurrence of the needle in haystack at or after pos, or npos */
+    size_t find_in(std::string_view haystack, size_t pos = 0) const {
+        const size_t n = haystack.size();
+        const size_t m = m_needle.size();
+        if ((pos > n) || (m > n - pos)) { return npos; }
+        const char* h = haystack.data();
+        switch (m_strategy) {
+        case Strategy::EMPTY:
+            return pos;
+        case Strategy::BYTE:
+            {
+                const void* found = ::memchr(h + pos, m_needle[0], n - pos);
+                return found ? size_t(static_cast<const char*>(found) - h) : npos;
+            }
+        case Strategy::FILTER:
+            return filterFind(h, n, pos, m_needle.data(), m, &m_tables);
+        case Strategy::HORSPOOL:
+            return horspoolFind(h, n, pos, m_needle.data(), m, m_tables.shift);
+        default:
+            return twoWayFind(h, n, pos, m_needle.data(), m, m_tables);
+        }
+    }
+
+    /** Position of the last occurrence of the needle in haystack that starts at or before pos, or npos */
+    size_t rfind_in(std::string_view haystack, size_t pos = npos) const {
+        const size_t n = haystack.size();
+        const size_t m = m_needle.size();
+        if (m > n) { return npos; }
+        const size_t hi = std::min(pos, n - m);
+        const char* h = haystack.data();
+        switch (m_strategy) {
+        case Strategy::EMPTY:
+            return hi;
+        case Strategy::BYTE:
+            for (size_t i = hi + 1; i-- > 0; ) {
+                if (h[i] == m_needle[0]) { return i; }
+            }
+            return npos;
+        case Strategy::FILTER:
+            return filterFindReverse(h, hi, m_needle.data(), m);
+        default:
+            return horspoolFindReverse(h, hi, m_needle.data(), m, m_reverseShift);
+        }
+    }
+
+    /** Number of non-overlapping occurrences of the needle in haystack, as replaced by
+        SIMDString::replace_all(). The empty needle occurs haystack.size() + 1 times. */
+    size_t count_in(std::string_view haystack) const {
+        const size_t m = m_needle.size();
+        if (m_strategy == Strategy::EMPTY) { return haystack.size() + 1; }
+        if (m_strategy == Strategy::BYTE) { return count_char(haystack.data(), haystack.data() + haystack.size(), m_needle[0]); }
+        size_t n = 0;
+        for (size_t i = find_in(haystack, 0); i != npos; i = find_in(haystack, i + m)) {
+            ++n;
+        }
+        return n;
+    }
+
+    template<size_t INTERNAL_SIZE, class Allocator>
+    size_t find_in(const SIMDString<INTERNAL_SIZE, Allocator>& haystack, size_t pos = 0) const {
+        return find_in(std::string_view(haystack.data(), haystack.size()), pos);
+    }
+
+    template<size_t INTERNAL_SIZE, class Allocator>
+    size_t rfind_in(const SIMDString<INTERNAL_SIZE, Allocator>& haystack, size_t pos = npos) const {
+        return rfind_in(std::string_view(haystack.data(), haystack.size()), pos);
+    }
+
+    template<size_t INTERNAL_SIZE, class Allocator>
+    size_t count_in(const SIMDString<INTERNAL_SIZE, Allocator>& haystack) const {
+        return count_in(std::string_view(haystack.data(), haystack.size()));
+    }
+
+    /** One-shot search for needle in haystack at or after pos, without building a searcher */
+    static size_t find(const char* haystack, size_t n, size_t pos, const char* needle, size_t m) {
+        if ((pos > n) || (m > n - pos)) { return npos; }
+        if (m == 0) { return pos; }
+        if (m == 1) {
+            const void* found = ::memchr(haystack + pos, needle[0], n - pos);
+            return found ? size_t(static_cast<const char*>(found) - haystack) : npos;
+        }
+        return filterFind(haystack, n, pos, needle, m, nullptr);
+    }
+
+    /** One-shot search for the last needle in haystack that starts at or before pos */
+    static size_t rfind(const char* haystack, size_t n, size_t pos, const char* needle, size_t m) {
+        if (m > n) { return npos; }
+        const size_t hi = std::min(pos, n - m);
+        if (m == 0) { return hi; }
+        if (m == 1) {
+            for (size_t i = hi + 1; i-- > 0; ) {
+                if (haystack[i] == needle[0]) { return i; }
+            }
+            return npos;
+        }
+        return filterFindReverse(haystack, hi, needle, m);
+    }
+
+    /** One-shot find() that compares after ascii_tolower(), with the filter on lowered blocks */
+    static size_t ifind(const char* haystack, size_t n, size_t pos, const char* needle, size_t m) {
+        if ((pos > n) || (m > n - pos)) { return npos; }
+        if (m == 0) { return pos; }
+        const char* h = haystack;
+        const char first = ascii_tolower(needle[0]);
+        const char lastChar = ascii_tolower(needle[m - 1]);
+        const size_t last = n - m;
+        size_t i = pos;
+#       ifdef SSE_x64
+            const __m128i firstByte = _mm_set1_epi8(first);
+            const __m128i lastByte = _mm_set1_epi8(lastChar);
+            for (; i + 15 <= last; i += 16) {
+                const __m128i a = ascii_tolower_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(h + i)));
+                const __m128i b = ascii_tolower_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(h + i + m - 1)));
+                unsigned int mask = (unsigned int)_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, firstByte), _mm_cmpeq_epi8(b, lastByte)));
+                while (mask) {
+                    const size_t j = i + countTrailingZeros(mask);
+                    if ((m < 3) || ascii_iequal(h + j + 1, needle + 1, m - 2)) { return j; }
+                    mask &= mask - 1;
+                }
+            }
+#       endif
+        for (; i <= last; ++i) {
+            if ((ascii_tolower(h[i]) == first) && (ascii_tolower(h[i + m - 1]) == lastChar) && ((m < 3) || ascii_iequal(h + i + 1, needle + 1, m - 2))) { return i; }
+        }
+        return npos;
+    }
+};
+
 /**
    \brief Very fast string class that follows the std::string/std::basic_string interface.
 
@@ -174,6 +851,9 @@ public:
     typedef std::reverse_iterator<const_iterator>    const_reverse_iterator;
     typedef std::reverse_iterator<iterator>          reverse_iterator;
 
+    /** Prepared search for one needle in many strings. See SIMDStringSearcher. */
+    typedef SIMDStringSearcher                       Searcher;
+
 protected:
     // Throw compile time error if INTERNAL_SIZE is not a multiple of SSO_ALIGNMENT
     static_assert(INTERNAL_SIZE % SSO_ALIGNMENT == 0, "SIMDString Internal Size must be a multiple of 16");
@@ -223,6 +903,13 @@ protected:
         return !(m_allocatedSize - INTERNAL_SIZE);
     }
 
+    /** Catches reads through borrowed strings whose buffer has been unregistered. No-op in release builds. */
+    constexpr inline void checkBorrowIsLive() const {
+#       if SIMDSTRING_TRACK_BORROWS
+            assert(!inConst() || borrowedPointerIsLive(m_ptr)); // "Use of a borrowed SIMDString after its buffer was unregistered"
+#       endif
+    }
+
     /** Requires 128-bit alignment */
     constexpr inline static void swapBuffer(void* buf1, void* buf2) {
 #       if USE_SSE_MEMCPY
@@ -547,6 +1234,18 @@ public:
         }
     }
 
+    /** Copies multi-megabyte strings in slices on several threads */
+    SIMDString(const SIMDString& str, const SIMDStringParallel& parallel) : SIMDString() {
+        if (str.inConst() || (str.m_length < SIMDSTRING_PARALLEL_THRESHOLD)) {
+            *this = str;
+        } else {
+            m_allocatedSize = chooseAllocationSize(str.m_length + 1);
+            pointer const dataPtr = alloc(m_allocatedSize);
+            parallel_memcpy(dataPtr, str.data(), str.m_length, parallel);
+            dataPtr[m_length = str.m_length] = '\0';
+        }
+    }
+
     constexpr SIMDString(const SIMDString& str, size_type pos, size_type count) {
         // cannot point to const string 
         m_length = (count == npos || pos + count >= str.size()) ? str.size() - pos : count;
@@ -650,6 +1349,100 @@ public:
         dataPtr[m_length] = '\0';
     }
 
+    /** Creates a string that references s directly instead of copying it, using the same storage mode
+        as constant segment strings: copies share the pointer, and the first mutation copies the
+        characters into the internal buffer or the heap. Intended for string tables in long-lived
+        buffers, such as those loaded from asset packs, that inConstSegment() does not recognize.
+
+        s[count] must be readable. If it is not '\0' the characters are copied, because c_str() requires
+        a terminator. The caller must keep the buffer alive and unchanged while any string borrows from it;
+        see registerBorrowedBuffer() for debug checking. */
+    static SIMDString borrow(const_pointer s, size_type count) {
+        SIMDString result;
+        if (s[count] == '\0') {
+            result.m_ptr = const_cast<pointer>(s);
+            result.m_length = count;
+            result.m_allocatedSize = 0;
+        } else {
+            result.assign(s, count);
+        }
+        return result;
+    }
+
+    static SIMDString borrow(const_pointer s) {
+        return borrow(s, ::strlen(s));
+    }
+
+    /** True if this string references external memory, either the constant segment or a borrowed buffer,
+        and will copy on its first mutation */
+    constexpr bool is_borrowed() const {
+        return inConst();
+    }
+
+    /** A string_view implicitly constructible from any string type, for arguments that accept all of
+        them without an overload per type: the elements of join(), so that a braced list can mix
+        SIMDStrings, std::strings, string_views, and literals, and the SIMDStringParallel and
+        case-insensitive overloads. */
+    struct StringViewArg : public std::string_view {
+        StringViewArg(std::string_view sv) : std::string_view(sv) {}
+        StringViewArg(const_pointer s) : std::string_view(s) {}
+        StringViewArg(const std::string& s) : std::string_view(s) {}
+
+        template<size_t N, class A>
+        StringViewArg(const ::SIMDString<N, A>& s) : std::string_view(s.data(), s.size()) {}
+    };
+
+    /** Concatenates the strings in pieces with separator between them. The lengths are summed in a
+        first pass so that the result is allocated exactly once, in the internal buffer if it fits,
+        and the characters are copied in a second pass. pieces must be a forward range, such as
+        std::vector<SIMDString> or std::vector<std::string_view>.
+
+        \code
+        SIMDString<> row = SIMDString<>::join(fields, ",");
+        SIMDString<> path = SIMDString<>::join({ directory, name, ".glsl" }, "/");
+        \endcode
+    */
+    template<class Range>
+    static SIMDString join(const Range& pieces, std::string_view separator = std::string_view()) {
+        size_type total = 0;
+        size_type count = 0;
+        for (const auto& piece : pieces) {
+            total += StringViewArg(piece).size();
+            ++count;
+        }
+        if (count > 1) {
+            total += (count - 1) * separator.size();
+        }
+
+        SIMDString result;
+        if (total == 0) {
+            return result;
+        }
+
+        result.resize_and_overwrite(total, [&](pointer dst, size_type) {
+            pointer const start = dst;
+            bool first = true;
+            for (const auto& piece : pieces) {
+                if (! first && ! separator.empty()) {
+                    ::memcpy(dst, separator.data(), separator.size());
+                    dst += separator.size();
+                }
+                first = false;
+                const StringViewArg view(piece);
+                if (! view.empty()) {
+                    ::memcpy(dst, view.data(), view.size());
+                    dst += view.size();
+                }
+            }
+            return size_type(dst - start);
+        });
+        return result;
+    }
+
+    static SIMDString join(std::initializer_list<StringViewArg> pieces, std::string_view separator = std::string_view()) {
+        return join<std::initializer_list<StringViewArg>>(pieces, separator);
+    }
+
     ~SIMDString() {
         if (inHeap()) {
             // Note that this calls the method, not ::free 
@@ -861,10 +1654,12 @@ public:
      * __get_pointer: https://github.com/llvm-mirror/libcxx/blob/78d6a7767ed57b50122a161b91f59f19c9bd0d19/include/string#L1513
      */
     constexpr const_pointer data() const noexcept {
+        checkBorrowIsLive();
         return inBuffer() ?  m_buffer : m_ptr;
     }
 
     constexpr pointer data() noexcept {
+        checkBorrowIsLive();
         return inBuffer() ?  m_buffer : m_ptr;
     }
 
@@ -1144,6 +1939,34 @@ public:
         }
     }
 
+    /** C++23 resize_and_overwrite. Ensures there is room for count characters, calls
+     *  op(data(), count) to write them directly into the inline or heap storage, and then
+     *  sets the length to the value returned by op, which must not exceed count.
+     *  Unlike resize(), the characters are not initialized before op is called. */
+    template<class Operation>
+    constexpr void resize_and_overwrite(size_type count, Operation op) {
+        // Only the first count characters are kept, so copy no more than that when moving
+        if (count < m_length) {
+            m_length = count;
+        }
+        pointer dataPtr = data();
+        if (m_allocatedSize < count + 1) {
+            // Move const strings to mutable storage and grow to exactly count + 1, because count is the
+            // final size rather than a step in a series of appends that ensureAllocation doubles for
+            const bool wasInHeap = inHeap();
+            pointer const old = dataPtr;
+            const size_type oldSize = m_allocatedSize;
+            m_allocatedSize = (count + 1 <= INTERNAL_SIZE) ? INTERNAL_SIZE : count + 1;
+            dataPtr = (m_allocatedSize > INTERNAL_SIZE) ? m_allocator.allocate(m_allocatedSize) : m_buffer;
+            ::memcpy(dataPtr, old, m_length);
+            if (m_allocatedSize > INTERNAL_SIZE) { m_ptr = dataPtr; }
+            if (wasInHeap) { free(old, oldSize); }
+        }
+        const size_type newLength = static_cast<size_type>(std::move(op)(dataPtr, count));
+        assert(newLength <= count); // "resize_and_overwrite operation wrote past count"
+        dataPtr[m_length = newLength] = '\0';
+    }
+
     constexpr size_type copy(pointer dest, size_type count, size_type pos = 0) const {
         size_type cpyCount = pos + count > m_length ? m_length - pos : count;
 
@@ -1289,6 +2112,66 @@ public:
         return replace(pos, count, sv.begin() + pos2, count2);
     }
 
+    /** Replaces every non-overlapping occurrence of from, scanning left to right, with to. Unlike a loop
+     *  of find() and replace(), which moves the tail of the string for each occurrence, this is linear:
+     *  when to is not longer than from the characters are compacted in place in one pass, and otherwise
+     *  the occurrences are counted first and the result is built in a single allocation.
+     *  from and to must not refer to this string's characters. An empty from changes nothing. */
+    constexpr SIMDString& replace_all(std::string_view from, std::string_view to) {
+        if (from.empty()) return *this;
+
+        size_type pos = find(from.data(), 0, from.size());
+        if (pos == npos) return *this;
+
+        if (to.size() <= from.size()) {
+            // The write position never passes the read position, and find() only reads ahead of it
+            pointer const dataPtr = prepareToMutate();
+            size_type read = 0;
+            size_type write = 0;
+            while (pos != npos) {
+                ::memmove(dataPtr + write, dataPtr + read, pos - read);
+                write += pos - read;
+                if (! to.empty()) {
+                    ::memcpy(dataPtr + write, to.data(), to.size());
+                    write += to.size();
+                }
+                read = pos + from.size();
+                pos = find(from.data(), read, from.size());
+            }
+            ::memmove(dataPtr + write, dataPtr + read, m_length - read);
+            write += m_length - read;
+            dataPtr[m_length = write] = '\0';
+            return *this;
+        }
+
+        // Remember the first occurrences so that the copy pass does not search for them again
+        constexpr size_type CACHED_COUNT = 64;
+        size_type cached[CACHED_COUNT];
+        size_type count = 0;
+        for (size_type p = pos; p != npos; p = find(from.data(), p + from.size(), from.size())) {
+            if (count < CACHED_COUNT) { cached[count] = p; }
+            ++count;
+        }
+        const size_type newLength = m_length + count * (to.size() - from.size());
+
+        SIMDString result;
+        result.resize_and_overwrite(newLength, [&](pointer dst, size_type) {
+            const_pointer const src = data();
+            size_type read = 0;
+            for (size_type i = 0; i < count; ++i) {
+                const size_type p = (i < CACHED_COUNT) ? cached[i] : find(from.data(), read, from.size());
+                ::memcpy(dst, src + read, p - read);
+                dst += p - read;
+                ::memcpy(dst, to.data(), to.size());
+                dst += to.size();
+                read = p + from.size();
+            }
+            ::memcpy(dst, src + read, m_length - read);
+            return newLength;
+        });
+        return (*this = std::move(result));
+    }
+
     constexpr void clear() {
         if (inConst()) {
             // switch to inBuffer
@@ -1538,6 +2421,47 @@ public:
         return this->append(sv.data());
     }
 
+    /** append(), copying multi-megabyte strings in slices on several threads, including the existing
+        contents when the string must grow */
+    SIMDString& append(StringViewArg sv, const SIMDStringParallel& parallel) {
+        const size_type count = sv.size();
+        if (m_allocatedSize < m_length + count + 1) {
+            SIMDString grown;
+            grown.m_allocatedSize = chooseAllocationSize(m_length + count + 1);
+            pointer const grownPtr = grown.alloc(grown.m_allocatedSize);
+            parallel_memcpy(grownPtr, data(), m_length, parallel);
+            // Copy sv before the swap, which moves the inline buffer that sv may point into. grown then
+            // holds the old storage until it goes out of scope.
+            parallel_memcpy(grownPtr + m_length, sv.data(), count, parallel);
+            grownPtr[grown.m_length = m_length + count] = '\0';
+            swap(grown);
+            return *this;
+        }
+        pointer const dst = append_uninitialized(count);
+        parallel_memcpy(dst, sv.data(), count, parallel);
+        commit_append(count);
+        return *this;
+    }
+
+    /** Ensures room for count more characters and returns a pointer to data() + size(),
+     *  where the caller may write up to count characters. The length does not change until
+     *  commit_append() is called, so producers that do not know their final length in
+     *  advance can write directly into the inline or heap storage and commit only what
+     *  they wrote. Any mutation of the string before the commit invalidates the pointer. */
+    constexpr pointer append_uninitialized(size_type count) {
+        // ensureAllocation also moves const strings to mutable storage
+        pointer const dataPtr = ensureAllocation(m_length + count + 1);
+        dataPtr[m_length] = '\0';
+        return dataPtr + m_length;
+    }
+
+    /** Extends the length by count characters that were written through the pointer returned
+     *  by the last append_uninitialized() call, which must have reserved at least count. */
+    constexpr void commit_append(size_type count) {
+        assert(!inConst() && m_length + count < m_allocatedSize); // "commit_append without append_uninitialized"
+        data()[m_length += count] = '\0';
+    }
+
     constexpr void swap(SIMDString& str) {
         std::swap<size_type>(m_allocatedSize, str.m_allocatedSize);
         std::swap<Allocator>(m_allocator, str.m_allocator);
@@ -1599,24 +2523,12 @@ public:
         return find(s, pos, ::strlen(s));
     }
 
+    /** Uses SIMDStringSearcher::find(). Build a Searcher to search for the same needle repeatedly. */
     constexpr size_type find(const_pointer s, size_type pos, size_type count) const
     {
         if (pos + count > m_length) return npos; 
 
-        if (count == 0) return pos;
-        
-        const_pointer const dataPtr = data();
-        const_pointer pFound = static_cast<const_pointer>(memchr(dataPtr + pos, *s, m_length - pos));
-        size_type i = static_cast<size_type>(pFound - data());
-
-        while (pFound && (i + count) <= m_length) {
-            if (memcmp(pFound, s, count) == 0) {
-                return i;
-            }
-            pFound = static_cast<const_pointer>(memchr(pFound + 1, *s, m_length - i - 1));
-            i = static_cast<size_type>(pFound - dataPtr);
-        }
-        return npos;
+        return SIMDStringSearcher::find(data(), m_length, pos, s, count);
     }
 
     constexpr size_type find(value_type c, size_type pos = 0) const {
@@ -1631,6 +2543,32 @@ public:
         return find(sv.begin(), pos, sv.size());
     }
 
+    /** find(), searching one slice of the possible positions per thread. Each slice also reads the
+        sv.size() - 1 characters after it, so that matches across slice boundaries are found, and a
+        slice is skipped if an earlier one has already matched. */
+    size_type find(StringViewArg sv, size_type pos, const SIMDStringParallel& parallel) const {
+        if ((pos > m_length) || (sv.size() > m_length - pos)) return npos;
+        const size_type starts = m_length - pos - sv.size() + 1;
+        const size_t tasks = sv.empty() ? 1 : parallel_task_count(starts, parallel);
+        if (tasks == 1) return find(sv, pos);
+
+        const_pointer const dataPtr = data();
+        const size_type slice = (starts + tasks - 1) / tasks;
+        std::atomic<size_type> best(npos);
+        auto search = [&](size_t t) {
+            const size_type begin = pos + std::min(starts, t * slice);
+            const size_type end = pos + std::min(starts, (t + 1) * slice);
+            if ((begin == end) || (best.load(std::memory_order_relaxed) < begin)) return;
+            const size_type i = SIMDStringSearcher::find(dataPtr + begin, end - begin + sv.size() - 1, 0, sv.data(), sv.size());
+            if (i != npos) {
+                size_type current = best.load(std::memory_order_relaxed);
+                while ((begin + i < current) && ! best.compare_exchange_weak(current, begin + i, std::memory_order_relaxed)) {}
+            }
+        };
+        parallel_for_tasks(tasks, search);
+        return best.load(std::memory_order_relaxed);
+    }
+
     constexpr size_type rfind(const SIMDString& str, size_type pos = npos) const {
         return rfind(str.data(), pos, str.m_length);
     }
@@ -1642,23 +2580,7 @@ public:
     constexpr size_type rfind(const_pointer s, size_type pos, size_type count) const {
         if (!m_length || count > m_length) return npos; 
 
-        size_type n_1 = count - 1;
-        size_type i = std::min(m_length - count, pos);
-        const_pointer const dataPtr = data(); 
-        const_pointer leftBound = dataPtr + n_1;
-        value_type endVal = *(s + n_1);
-
-        if (count == 0) {
-            return i;
-        }
-
-        do {
-            if (*(leftBound + i) == endVal && !memcmp(dataPtr + i, s, count)) {
-                return i;
-            }
-        } while (i--);
-
-        return npos;
+        return SIMDStringSearcher::rfind(data(), m_length, pos, s, count);
     }
 
     constexpr size_type rfind(value_type c, size_type pos = npos) const {
@@ -1676,6 +2598,87 @@ public:
         return rfind(sv.begin(), pos, sv.size());
     }
 
+    /** rfind(), searching one slice of the possible positions per thread like the parallel find() */
+    size_type rfind(StringViewArg sv, size_type pos, const SIMDStringParallel& parallel) const {
+        if (sv.size() > m_length) return npos;
+        const size_type starts = std::min(pos, m_length - sv.size()) + 1;
+        const size_t tasks = sv.empty() ? 1 : parallel_task_count(starts, parallel);
+        if (tasks == 1) return rfind(sv, pos);
+
+        const_pointer const dataPtr = data();
+        const size_type slice = (starts + tasks - 1) / tasks;
+        // One more than the best match, so that 0 means none
+        std::atomic<size_type> best(0);
+        auto search = [&](size_t t) {
+            const size_type begin = std::min(starts, t * slice);
+            const size_type end = std::min(starts, (t + 1) * slice);
+            if ((begin == end) || (best.load(std::memory_order_relaxed) > end)) return;
+            const size_type i = SIMDStringSearcher::rfind(dataPtr + begin, end - begin + sv.size() - 1, npos, sv.data(), sv.size());
+            if (i != npos) {
+                size_type current = best.load(std::memory_order_relaxed);
+                while ((begin + i + 1 > current) && ! best.compare_exchange_weak(current, begin + i + 1, std::memory_order_relaxed)) {}
+            }
+        };
+        parallel_for_tasks(tasks, search);
+        const size_type found = best.load(std::memory_order_relaxed);
+        return found ? found - 1 : npos;
+    }
+
+    /** Number of occurrences of c */
+    size_type count(value_type c) const {
+        return count_char(data(), data() + m_length, c);
+    }
+
+    /** count(), counting one slice per thread */
+    size_type count(value_type c, const SIMDStringParallel& parallel) const {
+        const size_t tasks = parallel_task_count(m_length, parallel);
+        if (tasks == 1) return count(c);
+
+        const_pointer const dataPtr = data();
+        const size_type slice = (m_length + tasks - 1) / tasks;
+        std::atomic<size_type> total(0);
+        auto countSlice = [&](size_t t) {
+            const size_type begin = std::min(m_length, t * slice);
+            const size_type end = std::min(m_length, (t + 1) * slice);
+            total.fetch_add(count_char(dataPtr + begin, dataPtr + end, c), std::memory_order_relaxed);
+        };
+        parallel_for_tasks(tasks, countSlice);
+        return total.load(std::memory_order_relaxed);
+    }
+
+    /** Converts A-Z to a-z in place, 16 or 32 bytes at a time. Other bytes, including UTF-8 sequences,
+        are unchanged. */
+    SIMDString& to_lower() {
+        if (m_length) { ascii_tolower(prepareToMutate(), m_length); }
+        return *this;
+    }
+
+    /** Converts a-z to A-Z in place */
+    SIMDString& to_upper() {
+        if (m_length) { ascii_toupper(prepareToMutate(), m_length); }
+        return *this;
+    }
+
+    /** Equality ignoring the case of ASCII letters, without making lower-case copies */
+    bool iequals(StringViewArg sv) const {
+        return (sv.size() == m_length) && ascii_iequal(data(), sv.data(), m_length);
+    }
+
+    /** compare() ignoring the case of ASCII letters, which orders as if both strings were lower case */
+    int icompare(StringViewArg sv) const {
+        return ascii_icompare(data(), m_length, sv.data(), sv.size());
+    }
+
+    /** find() ignoring the case of ASCII letters */
+    size_type ifind(StringViewArg sv, size_type pos = 0) const {
+        return SIMDStringSearcher::ifind(data(), m_length, pos, sv.data(), sv.size());
+    }
+
+    /** Hash that is equal for strings that are iequals(). Differs from std::hash. */
+    size_t ihash() const {
+        return ascii_ihash(data(), m_length);
+    }
+
     constexpr size_type find_first_of(const_pointer s, size_type pos, size_type count) const {
         if (pos >= m_length) return npos;
 
@@ -1949,57 +2952,153 @@ __attribute__((__aligned__(SSO_ALIGNMENT)))
 #endif
 ;
 
+/** Exposes the protected get area of any std::streambuf. Pointers to inherited members formed through a
+    derived class have base class type, so they may legally be applied to any std::streambuf. */
+class SIMDStringStreambufAccess : public std::streambuf {
+public:
+    static inline char* getAreaBegin(std::streambuf* buf) {
+        return (buf->*(&SIMDStringStreambufAccess::gptr))();
+    }
+
+    static inline char* getAreaEnd(std::streambuf* buf) {
+        return (buf->*(&SIMDStringStreambufAccess::egptr))();
+    }
+
+    static inline void consume(std::streambuf* buf, int count) {
+        (buf->*(&SIMDStringStreambufAccess::gbump))(count);
+    }
+};
+
+/** Returns the first ' ', '\t', '\n', '\v', '\f' or '\r' in [begin, end), or end. These are exactly the
+    whitespace characters of the classic "C" locale. */
+inline const char* find_ascii_space(const char* begin, const char* end) {
+#   ifdef SSE_x64
+        const __m128i space = _mm_set1_epi8(' ');
+        const __m128i tab = _mm_set1_epi8('\t');
+        const __m128i controlRange = _mm_set1_epi8('\r' - '\t');
+        for (; begin + 16 <= end; begin += 16) {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+            // '\t' <= c <= '\r' as an unsigned range test: min(c - '\t', 4) == c - '\t'
+            const __m128i offset = _mm_sub_epi8(v, tab);
+            const __m128i isControl = _mm_cmpeq_epi8(_mm_min_epu8(offset, controlRange), offset);
+            const int mask = _mm_movemask_epi8(_mm_or_si128(isControl, _mm_cmpeq_epi8(v, space)));
+            if (mask) {
+                for (int i = 0; ; ++i) {
+                    if (mask & (1 << i)) { return begin + i; }
+                }
+            }
+        }
+#   endif
+    for (; begin < end; ++begin) {
+        if ((*begin == ' ') || (static_cast<unsigned char>(*begin - '\t') <= static_cast<unsigned char>('\r' - '\t'))) {
+            return begin;
+        }
+    }
+    return end;
+}
+
+/** Appends characters from buf to str until findEnd(begin, end) returns a position before end, n characters
+    have been appended, or the input is exhausted. Whole spans of the stream buffer's get area are scanned
+    and appended at once; unbuffered stream buffers fall back to one character at a time using isEnd(c).
+    Returns the number of characters appended and sets c to the next character, which is not extracted,
+    or to EOF. */
+template<class StringType, class FindEnd, class IsEnd>
+typename StringType::size_type streambuf_append_until(std::streambuf* buf, StringType& str, typename StringType::size_type n,
+    FindEnd findEnd, IsEnd isEnd, std::streambuf::int_type& c) {
+    typedef typename StringType::size_type size_type;
+    typedef std::streambuf::traits_type traits_type;
+    size_type count = 0;
+
+    while (count < n) {
+        const char* const begin = SIMDStringStreambufAccess::getAreaBegin(buf);
+        const char* const end = SIMDStringStreambufAccess::getAreaEnd(buf);
+
+        if (begin < end) {
+            // gbump takes an int
+            const size_type available = std::min(std::min(size_type(end - begin), n - count), size_type(std::numeric_limits<int>::max()));
+            const char* const stop = findEnd(begin, begin + available);
+            const size_type len = size_type(stop - begin);
+            str.append(begin, len);
+            SIMDStringStreambufAccess::consume(buf, int(len));
+            count += len;
+            if (stop < begin + available) {
+                c = traits_type::to_int_type(*stop);
+                return count;
+            }
+        } else {
+            // Refill the get area
+            c = buf->sgetc();
+            if (traits_type::eq_int_type(c, traits_type::eof())) {
+                return count;
+            } else if (SIMDStringStreambufAccess::getAreaBegin(buf) == SIMDStringStreambufAccess::getAreaEnd(buf)) {
+                // Unbuffered
+                if (isEnd(traits_type::to_char_type(c))) {
+                    return count;
+                }
+                str += traits_type::to_char_type(c);
+                ++count;
+                buf->sbumpc();
+            }
+        }
+    }
+    c = buf->sgetc();
+    return count;
+}
+
+/** Writes count copies of c with bulk sputn calls. Returns false if the stream buffer failed. */
+inline bool streambuf_fill(std::streambuf* buf, char c, std::streamsize count) {
+    char fill[64];
+    ::memset(fill, c, std::min(count, std::streamsize(sizeof(fill))));
+    while (count > 0) {
+        const std::streamsize n = std::min(count, std::streamsize(sizeof(fill)));
+        if (buf->sputn(fill, n) != n) {
+            return false;
+        }
+        count -= n;
+    }
+    return true;
+}
+
 TEMPLATE
 std::ostream& operator<<(std::ostream& os, const SIMDString<INTERNAL_SIZE, Allocator>& str) {
     std::ostream::sentry sen(os);
     if (sen) {
         try {
             const std::streamsize w = os.width();
+            const std::streamsize size = (std::streamsize) str.size();
 
-            if (w > (std::streamsize) str.size()) {
+            if (w > size) {
                 const bool left = ((os.flags() & std::ostream::adjustfield) == std::ostream::left);
 
-                if (!left) {    
-                    const typename SIMDString<INTERNAL_SIZE, Allocator>::value_type c = os.fill();
-                    for (std::streamsize fillN = w - str.size(); fillN > 0; --fillN)
-                    {
-                        if (os.rdbuf()->sputc(c) == EOF) {
-                            os.setstate(std::ostream::badbit);
-                            break;
-                        }
-                    }
+                if (!left && !streambuf_fill(os.rdbuf(), os.fill(), w - size)) {
+                    os.setstate(std::ostream::badbit);
                 }
 
-                if (os.good() && (os.rdbuf()->sputn(str.data(), str.size()) != str.size())){
+                if (os.good() && (os.rdbuf()->sputn(str.data(), size) != size)){
                     os.setstate(std::ostream::badbit);
                 }
                 
-                if (left && os.good()){
-                    const typename SIMDString<INTERNAL_SIZE, Allocator>::value_type c = os.fill();
-                    for (std::streamsize fillN = w - str.size(); fillN > 0; --fillN)
-                    {
-                        if (os.rdbuf()->sputc(c) == EOF) {
-                            os.setstate(std::ostream::badbit);
-                            break;
-                        }
-                    }
+                if (left && os.good() && !streambuf_fill(os.rdbuf(), os.fill(), w - size)) {
+                    os.setstate(std::ostream::badbit);
                 }
-		    } else if (os.rdbuf()->sputn(str.data(), str.size()) != str.size()){
+            } else if (os.rdbuf()->sputn(str.data(), size) != size){
                 os.setstate(std::ostream::badbit);
             }
-	        os.width(0);
-	    }
-	    catch(...)
-	    { 
+            os.width(0);
+        }
+        catch(...)
+        { 
             os.setstate(std::ostream::badbit); 
         }
-	}
+    }
     return os;
 }
 
 TEMPLATE
 std::istream& operator>>(std::istream& is, SIMDString<INTERNAL_SIZE, Allocator>& str) {
-    typename SIMDString<INTERNAL_SIZE, Allocator>::size_type numExtracted = 0;
+    typedef typename SIMDString<INTERNAL_SIZE, Allocator>::size_type size_type;
+    typedef typename SIMDString<INTERNAL_SIZE, Allocator>::traits_type traits_type;
+    size_type numExtracted = 0;
     std::istream::ios_base::iostate err = std::istream::ios_base::goodbit;
     std::istream::sentry sen(is);
 
@@ -2007,18 +3106,21 @@ std::istream& operator>>(std::istream& is, SIMDString<INTERNAL_SIZE, Allocator>&
         try
         {
             str.erase();
-            const typename SIMDString<INTERNAL_SIZE, Allocator>::size_type n =
-                is.width() > 0 ? static_cast<typename SIMDString<INTERNAL_SIZE, Allocator>::size_type>(is.width())
-                    : str.max_size();
-            typename SIMDString<INTERNAL_SIZE, Allocator>::value_type c = is.rdbuf()->sgetc();
+            const size_type n = is.width() > 0 ? static_cast<size_type>(is.width()) : str.max_size();
+            typename traits_type::int_type c;
 
-            while (numExtracted < n && c != EOF && !std::isspace(c, is.getloc())) {
-                str += c;
-                ++numExtracted;
-                c = is.rdbuf()->snextc();
+            if (is.getloc() == std::locale::classic()) {
+                // Locale-free ASCII classification
+                numExtracted = streambuf_append_until(is.rdbuf(), str, n, find_ascii_space,
+                    [](char ch) { return find_ascii_space(&ch, &ch + 1) != &ch + 1; }, c);
+            } else {
+                const std::ctype<char>& ct = std::use_facet<std::ctype<char>>(is.getloc());
+                numExtracted = streambuf_append_until(is.rdbuf(), str, n,
+                    [&ct](const char* begin, const char* end) { return ct.scan_is(std::ctype_base::space, begin, end); },
+                    [&ct](char ch) { return ct.is(std::ctype_base::space, ch); }, c);
             }
 
-            if (numExtracted < n && c == EOF) {
+            if (numExtracted < n && traits_type::eq_int_type(c, traits_type::eof())) {
                 err |= std::istream::ios_base::eofbit;
             }
             is.width(0);
@@ -2042,7 +3144,9 @@ std::istream& operator>>(std::istream& is, SIMDString<INTERNAL_SIZE, Allocator>&
 TEMPLATE
 std::istream& getline(
     std::istream& is, SIMDString<INTERNAL_SIZE, Allocator>& str, typename SIMDString<INTERNAL_SIZE, Allocator>::value_type delim = '\n') {
-    typename SIMDString<INTERNAL_SIZE, Allocator>::size_type numExtracted = 0;
+    typedef typename SIMDString<INTERNAL_SIZE, Allocator>::size_type size_type;
+    typedef typename SIMDString<INTERNAL_SIZE, Allocator>::traits_type traits_type;
+    size_type numExtracted = 0;
     std::istream::ios_base::iostate  err = std::istream::ios_base::goodbit;
     std::istream::sentry sen(is, true);
 
@@ -2050,18 +3154,19 @@ std::istream& getline(
         try
         {
             str.erase();
-            const typename SIMDString<INTERNAL_SIZE, Allocator>::size_type n = str.max_size();
-            typename SIMDString<INTERNAL_SIZE, Allocator>::value_type c = is.rdbuf()->sgetc();
+            const size_type n = str.max_size();
+            typename traits_type::int_type c;
 
-            while (numExtracted < n && c != EOF && c != delim) {
-                str += c;
-                ++numExtracted;
-                c = is.rdbuf()->snextc();
-            }
+            numExtracted = streambuf_append_until(is.rdbuf(), str, n,
+                [delim](const char* begin, const char* end) {
+                    const char* found = static_cast<const char*>(::memchr(begin, delim, end - begin));
+                    return found ? found : end;
+                },
+                [delim](char ch) { return ch == delim; }, c);
 
-            if (c == EOF) {
+            if (traits_type::eq_int_type(c, traits_type::eof())) {
                 err |= std::istream::ios_base::eofbit;
-            } else if (c == delim) {
+            } else if (traits_type::eq_int_type(c, traits_type::to_int_type(delim))) {
                 ++numExtracted;
                 is.rdbuf()->sbumpc();
             } else {
@@ -2084,181 +3189,429 @@ std::istream& getline(
     return is;
 }
 
+/** True for ' ', '\t', '\n', '\v', '\f' and '\r', the whitespace of the classic "C" locale */
+constexpr bool is_ascii_space(char c) {
+    return (c == ' ') || (static_cast<unsigned char>(c - '\t') <= static_cast<unsigned char>('\r' - '\t'));
+}
 
-TEMPLATE 
-inline int stoi(
-    const SIMDString<INTERNAL_SIZE, Allocator> &str, typename SIMDString<INTERNAL_SIZE, Allocator>::size_type* pos = nullptr, int base = 10) {
-    typename SIMDString<INTERNAL_SIZE, Allocator>::pointer end;
-    int answer = ::strtol(str.data(), &end, base);
-    if ( end == str.data() ) {
-        throw std::invalid_argument("invalid stof argument");
-    }
+/** Returns the first character in [begin, end) that is not is_ascii_space(), or end */
+inline const char* skip_ascii_space(const char* begin, const char* end) {
+    while ((begin < end) && is_ascii_space(*begin)) { ++begin; }
+    return begin;
+}
 
-    if (errno == ERANGE) {
-        throw std::out_of_range("stof argument out of range");
-    }
+#if (defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)) || defined(_M_IX86) || defined(_M_X64) || defined(_M_ARM64)
+#   define SIMDSTRING_LITTLE_ENDIAN 1
+#endif
 
-    if (pos) {
-        *pos = end - str.data();
+/** Parses the longest run of decimal digits at [begin, end), eight at a time with SWAR arithmetic on
+    64-bit words where possible. Returns the end of the run. Sets overflow if the value does not fit in
+    64 bits, in which case value is unspecified but the whole run is still consumed, as strtoull does. */
+inline const char* parse_decimal_digits(const char* begin, const char* end, uint64_t& value, bool& overflow) {
+    uint64_t v = 0;
+    overflow = false;
+
+#   ifdef SIMDSTRING_LITTLE_ENDIAN
+        // At most 16 digits here, so that v cannot overflow before the checked loop below
+        for (int block = 0; (block < 2) && (end - begin >= 8); ++block) {
+            uint64_t chunk;
+            ::memcpy(&chunk, begin, 8);
+            // Every byte is in '0'..'9' iff neither adding 0x46 nor subtracting 0x30 sets its high bit
+            if (((chunk + 0x4646464646464646ull) | (chunk - 0x3030303030303030ull)) & 0x8080808080808080ull) { break; }
+
+            // Combine adjacent digits into pairs, pairs into quads, and quads into the eight-digit value
+            chunk -= 0x3030303030303030ull;
+            chunk = (chunk * 10) + (chunk >> 8);
+            chunk = (((chunk & 0x000000FF000000FFull) * (100 + (1000000ull << 32))) +
+                     (((chunk >> 16) & 0x000000FF000000FFull) * (1 + (10000ull << 32)))) >> 32;
+            v = v * 100000000u + uint32_t(chunk);
+            begin += 8;
+        }
+#   endif
+
+    constexpr uint64_t cutoff = std::numeric_limits<uint64_t>::max() / 10;
+    constexpr unsigned cutoffDigit = unsigned(std::numeric_limits<uint64_t>::max() % 10);
+    for (; (begin < end) && (static_cast<unsigned char>(*begin - '0') <= 9); ++begin) {
+        const unsigned digit = unsigned(*begin - '0');
+        if ((v > cutoff) || ((v == cutoff) && (digit > cutoffDigit))) {
+            overflow = true;
+        } else {
+            v = v * 10 + digit;
+        }
     }
-
-    return answer;
+    value = v;
+    return begin;
 }
 
-TEMPLATE 
-inline long stol(
-    const SIMDString<INTERNAL_SIZE, Allocator> &str, typename SIMDString<INTERNAL_SIZE, Allocator>::size_type* pos = nullptr, int base = 10) {
-    typename SIMDString<INTERNAL_SIZE, Allocator>::pointer end;
-    long answer = ::strtol(str.data(), &end, base);
-    if ( end == str.data() ) {
-        throw std::invalid_argument("invalid stof argument");
+/**
+   Locale-independent replacement for strtol and strtoul that does not need a null-terminated string
+   and never touches errno. Accepts the same syntax: leading whitespace, an optional sign, and for
+   base 0 or 16 an optional 0x prefix, with base 0 choosing 8 for a leading 0. As in strtoul, a '-'
+   negates the value of an unsigned type.
+
+   Returns std::errc::invalid_argument with ptr == begin if there are no digits, and
+   std::errc::result_out_of_range with ptr after the digits if the value does not fit in IntType.
+*/
+template<typename IntType>
+std::from_chars_result parse_integer(const char* begin, const char* end, IntType& value, int base = 10) {
+    using UIntType = std::make_unsigned_t<IntType>;
+    const char* p = skip_ascii_space(begin, end);
+
+    bool negative = false;
+    if ((p < end) && ((*p == '+') || (*p == '-'))) {
+        negative = (*p == '-');
+        ++p;
+    }
+
+    if (((base == 0) || (base == 16)) && (end - p >= 3) && (p[0] == '0') && ((p[1] | 0x20) == 'x') &&
+        (static_cast<unsigned char>(p[2] - '0') <= 9 || static_cast<unsigned char>((p[2] | 0x20) - 'a') <= 5)) {
+        p += 2;
+        base = 16;
+    } else if (base == 0) {
+        base = ((p < end) && (*p == '0')) ? 8 : 10;
+    }
+
+    uint64_t magnitude = 0;
+    bool overflow = false;
+    const char* digitsEnd;
+    if (base == 10) {
+        digitsEnd = parse_decimal_digits(p, end, magnitude, overflow);
+    } else {
+        const std::from_chars_result result = std::from_chars(p, end, magnitude, base);
+        digitsEnd = result.ptr;
+        overflow = (result.ec == std::errc::result_out_of_range);
     }
 
-    if (errno == ERANGE) {
-        throw std::out_of_range("stof argument out of range");
+    if (digitsEnd == p) {
+        return { begin, std::errc::invalid_argument };
     }
 
-    if (pos) {
-        *pos = end - str.data();
+    uint64_t limit = uint64_t(std::numeric_limits<IntType>::max());
+    if (std::is_signed_v<IntType> && negative) { ++limit; }
+    if (overflow || (magnitude > limit)) {
+        return { digitsEnd, std::errc::result_out_of_range };
     }
 
-    return answer;
+    value = negative ? IntType(UIntType(0) - UIntType(magnitude)) : IntType(magnitude);
+    return { digitsEnd, std::errc() };
 }
 
-TEMPLATE 
-inline long long stoll(
-    const SIMDString<INTERNAL_SIZE, Allocator> &str, typename SIMDString<INTERNAL_SIZE, Allocator>::size_type* pos = nullptr, int base = 10) {
-    typename SIMDString<INTERNAL_SIZE, Allocator>::pointer end;
-    long long answer = ::strtoll(str.data(), &end, base);
-    if ( end == str.data() ) {
-        throw std::invalid_argument("invalid stof argument");
+/**
+   Locale-independent replacement for strtof, strtod and strtold that does not need a null-terminated
+   string and never touches errno. Accepts the same syntax: leading whitespace, an optional sign, decimal
+   and 0x hexadecimal floating point, inf, infinity and nan. Uses std::from_chars, which implements the
+   Eisel-Lemire algorithm in current standard libraries.
+
+   Returns std::errc::invalid_argument with ptr == begin if there is no number, and
+   std::errc::result_out_of_range if the value overflows or underflows FloatType.
+*/
+template<typename FloatType>
+std::from_chars_result parse_float(const char* begin, const char* end, FloatType& value) {
+    const char* p = skip_ascii_space(begin, end);
+
+    bool negative = false;
+    if ((p < end) && ((*p == '+') || (*p == '-'))) {
+        negative = (*p == '-');
+        ++p;
+    }
+    if ((p == end) || (*p == '+') || (*p == '-')) {
+        return { begin, std::errc::invalid_argument };
+    }
+
+#   ifdef __cpp_lib_to_chars
+        std::from_chars_result result = { p, std::errc::invalid_argument };
+        // std::from_chars accepts its own '-', so require a digit or point after "0x", as strtod does
+        if ((end - p > 2) && (p[0] == '0') && ((p[1] | 0x20) == 'x') &&
+            (static_cast<unsigned char>(p[2] - '0') <= 9 || static_cast<unsigned char>((p[2] | 0x20) - 'a') <= 5 || (p[2] == '.'))) {
+            result = std::from_chars(p + 2, end, value, std::chars_format::hex);
+            // "0x" without hex digits is the number 0 followed by 'x'
+            if (result.ec == std::errc::invalid_argument) { result.ptr = p; }
+        }
+        if (result.ptr == p) {
+            result = std::from_chars(p, end, value);
+        }
+#   else
+        // strtod needs a null-terminated string and reports errors through errno, which is restored afterward.
+        // Unlike the std::from_chars path, this depends on the decimal point of the C locale.
+        const SIMDString<128> field(p, size_t(end - p));
+        const int savedErrno = errno;
+        errno = 0;
+        char* fieldEnd = nullptr;
+        if constexpr (std::is_same_v<FloatType, float>) {
+            value = ::strtof(field.c_str(), &fieldEnd);
+        } else if constexpr (std::is_same_v<FloatType, double>) {
+            value = ::strtod(field.c_str(), &fieldEnd);
+        } else {
+            value = ::strtold(field.c_str(), &fieldEnd);
+        }
+        std::from_chars_result result = { p + (fieldEnd - field.c_str()),
+            (fieldEnd == field.c_str()) ? std::errc::invalid_argument : (errno == ERANGE) ? std::errc::result_out_of_range : std::errc() };
+        errno = savedErrno;
+#   endif
+
+    if (result.ec == std::errc::invalid_argument) {
+        return { begin, std::errc::invalid_argument };
     }
+    if (negative) { value = -value; }
+    return result;
+}
 
-    if (errno == ERANGE) {
-        throw std::out_of_range("stof argument out of range");
+/** Calls parse_float() or parse_integer() in base 10 according to NumberType */
+template<typename NumberType>
+std::from_chars_result parse_number(const char* begin, const char* end, NumberType& value) {
+    if constexpr (std::is_floating_point_v<NumberType>) {
+        return parse_float(begin, end, value);
+    } else {
+        return parse_integer(begin, end, value, 10);
     }
+}
 
-    if (pos) {
-        *pos = end - str.data();
+/**
+   Parses every number in [begin, end) that is separated from the next by delimiter, with optional
+   whitespace around each, and writes them to out. This is the bulk version of stoi() and stof() for
+   loading tables: it does not allocate or copy, and is independent of the locale. A whitespace
+   delimiter also matches any run of whitespace.
+
+   Returns the output iterator after the last number written. If parsing stops early at text that is
+   not a number, or at a number out of range for NumberType, sets *errorPos to its offset from begin.
+   Otherwise sets *errorPos to std::string_view::npos.
+*/
+template<typename NumberType, class OutputIt>
+OutputIt parse_numbers(const char* begin, const char* end, OutputIt out, char delimiter = ',', size_t* errorPos = nullptr) {
+    if (errorPos) { *errorPos = std::string_view::npos; }
+
+    const char* p = skip_ascii_space(begin, end);
+    while (p < end) {
+        NumberType value;
+        const std::from_chars_result result = parse_number(p, end, value);
+        if (result.ec != std::errc()) {
+            if (errorPos) { *errorPos = size_t(p - begin); }
+            return out;
+        }
+        *out = value;
+        ++out;
+
+        const char* next = skip_ascii_space(result.ptr, end);
+        if (next < end) {
+            if (*next == delimiter) {
+                next = skip_ascii_space(next + 1, end);
+            } else if (! is_ascii_space(delimiter) || (next == result.ptr)) {
+                if (errorPos) { *errorPos = size_t(next - begin); }
+                return out;
+            }
+        }
+        p = next;
     }
+    return out;
+}
 
-    return answer;
+template<typename NumberType, class OutputIt>
+OutputIt parse_numbers(std::string_view text, OutputIt out, char delimiter = ',', size_t* errorPos = nullptr) {
+    return parse_numbers<NumberType>(text.data(), text.data() + text.size(), out, delimiter, errorPos);
 }
 
-TEMPLATE 
-inline unsigned long stoul(
-    const SIMDString<INTERNAL_SIZE, Allocator> &str, typename SIMDString<INTERNAL_SIZE, Allocator>::size_type* pos = nullptr, int base = 10) {
-    typename SIMDString<INTERNAL_SIZE, Allocator>::pointer end;
-    unsigned long answer = ::strtoul(str.data(), &end, base);
-    if ( end == str.data() ) {
-        throw std::invalid_argument("invalid stof argument");
+template<typename NumberType, size_t INTERNAL_SIZE, class Allocator, class OutputIt>
+OutputIt parse_numbers(const SIMDString<INTERNAL_SIZE, Allocator>& str, OutputIt out, char delimiter = ',', size_t* errorPos = nullptr) {
+    return parse_numbers<NumberType>(str.data(), str.data() + str.size(), out, delimiter, errorPos);
+}
+
+/** Shared implementation of the sto* functions, which throw the same exceptions as their std:: counterparts */
+template<typename NumberType, class StringType>
+NumberType string_to_number(const StringType& str, typename StringType::size_type* pos, int base, const char* name) {
+    NumberType value = NumberType();
+    std::from_chars_result result;
+    if constexpr (std::is_floating_point_v<NumberType>) {
+        result = parse_float(str.data(), str.data() + str.size(), value);
+    } else {
+        result = parse_integer(str.data(), str.data() + str.size(), value, base);
     }
 
-    if (errno == ERANGE) {
-        throw std::out_of_range("stof argument out of range");
+    if (result.ec == std::errc::invalid_argument) {
+        throw std::invalid_argument(name);
+    }
+
+    if (result.ec == std::errc::result_out_of_range) {
+        throw std::out_of_range(name);
     }
 
     if (pos) {
-        *pos = end - str.data();
+        *pos = result.ptr - str.data();
     }
 
-    return answer;
+    return value;
 }
 
 TEMPLATE 
-inline unsigned long long stoull(
+inline int stoi(
     const SIMDString<INTERNAL_SIZE, Allocator> &str, typename SIMDString<INTERNAL_SIZE, Allocator>::size_type* pos = nullptr, int base = 10) {
-    typename SIMDString<INTERNAL_SIZE, Allocator>::pointer end;
-    unsigned long long answer = ::strtoull(str.data(), &end, base);
-    if ( end == str.data() ) {
-        throw std::invalid_argument("invalid stof argument");
-    }
+    return string_to_number<int>(str, pos, base, "stoi");
+}
 
-    if (errno == ERANGE) {
-        throw std::out_of_range("stof argument out of range");
-    }
+TEMPLATE 
+inline long stol(
+    const SIMDString<INTERNAL_SIZE, Allocator> &str, typename SIMDString<INTERNAL_SIZE, Allocator>::size_type* pos = nullptr, int base = 10) {
+    return string_to_number<long>(str, pos, base, "stol");
+}
 
-    if (pos) {
-        *pos = end - str.data();
-    }
+TEMPLATE 
+inline long long stoll(
+    const SIMDString<INTERNAL_SIZE, Allocator> &str, typename SIMDString<INTERNAL_SIZE, Allocator>::size_type* pos = nullptr, int base = 10) {
+    return string_to_number<long long>(str, pos, base, "stoll");
+}
 
-    return answer;
+TEMPLATE 
+inline unsigned long stoul(
+    const SIMDString<INTERNAL_SIZE, Allocator> &str, typename SIMDString<INTERNAL_SIZE, Allocator>::size_type* pos = nullptr, int base = 10) {
+    return string_to_number<unsigned long>(str, pos, base, "stoul");
+}
+
+TEMPLATE 
+inline unsigned long long stoull(
+    const SIMDString<INTERNAL_SIZE, Allocator> &str, typename SIMDString<INTERNAL_SIZE, Allocator>::size_type* pos = nullptr, int base = 10) {
+    return string_to_number<unsigned long long>(str, pos, base, "stoull");
 }
 
 TEMPLATE 
 inline float stof(
     const SIMDString<INTERNAL_SIZE, Allocator> &str, typename SIMDString<INTERNAL_SIZE, Allocator>::size_type* pos = nullptr) {
-    typename SIMDString<INTERNAL_SIZE, Allocator>::pointer end;
-    float answer = ::strtof(str.data(), &end);
-    
-    if ( end == str.data() ) {
-        throw std::invalid_argument("invalid stof argument");
-    }
-
-    if (errno == ERANGE) {
-        throw std::out_of_range("stof argument out of range");
-    }
-
-    if (pos) {
-        *pos = end - str.data();
-    }
-
-    return answer;
+    return string_to_number<float>(str, pos, 10, "stof");
 }
 
 TEMPLATE 
 inline double stod(
     const SIMDString<INTERNAL_SIZE, Allocator> &str, typename SIMDString<INTERNAL_SIZE, Allocator>::size_type* pos = nullptr) {
-    typename SIMDString<INTERNAL_SIZE, Allocator>::pointer end;
-    double answer = ::strtod(str.data(), &end);
-    if ( end == str.data() ) {
-        throw std::invalid_argument("invalid stof argument");
-    }
-
-    if (errno == ERANGE) {
-        throw std::out_of_range("stof argument out of range");
-    }
-
-    if (pos) {
-        *pos = end - str.data();
-    }
-
-    return answer;
+    return string_to_number<double>(str, pos, 10, "stod");
 }
 
 TEMPLATE 
 inline long double stold(
     const SIMDString<INTERNAL_SIZE, Allocator> &str, typename SIMDString<INTERNAL_SIZE, Allocator>::size_type* pos = nullptr) {
-    typename SIMDString<INTERNAL_SIZE, Allocator>::pointer end;
-    long double answer = ::strtold(str.data(), &end);
-    if ( end == str.data() ) {
-        throw std::invalid_argument("invalid stof argument");
-    }
-
-    if (errno == ERANGE) {
-        throw std::out_of_range("stof argument out of range");
-    }
+    return string_to_number<long double>(str, pos, 10, "stold");
+}
 
-    if (pos) {
-        *pos = end - str.data();
-    }
+/** Number of decimal digits in value, which is at least 1. Estimates log10 from the bit length
+    and corrects it with one comparison, instead of dividing repeatedly. */
+template<typename UIntType>
+int count_digits(UIntType value) {
+    static_assert(sizeof(UIntType) <= sizeof(uint64_t), "count_digits supports at most 64-bit integers");
+    constexpr uint64_t powersOfTen[] = {
+        0, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull, 100000000ull,
+        1000000000ull, 10000000000ull, 100000000000ull, 1000000000000ull, 10000000000000ull,
+        100000000000000ull, 1000000000000000ull, 10000000000000000ull, 100000000000000000ull,
+        1000000000000000000ull, 10000000000000000000ull };
+
+    const uint64_t v = uint64_t(value) | 1;
+#   if defined(_MSC_VER) && !defined(__clang__)
+        // Two 32-bit scans, because _BitScanReverse64 does not exist on 32-bit targets
+        unsigned long highBit = 0;
+        if (_BitScanReverse(&highBit, uint32_t(v >> 32))) {
+            highBit += 32;
+        } else {
+            _BitScanReverse(&highBit, uint32_t(v));
+        }
+        const int bits = int(highBit) + 1;
+#   else
+        const int bits = 64 - __builtin_clzll(v);
+#   endif
 
-    return answer;
+    // 1233 / 4096 is slightly more than log10(2)
+    const int log10 = (bits * 1233) >> 12;
+    return log10 + int(uint64_t(value) >= powersOfTen[log10]);
 }
 
+/** Writes the count_digits(value) == digits decimal digits of value to dst[0, digits), two at a time
+    from a table of digit pairs. Does not null-terminate. */
 template<typename UIntType>
-char * uint_to_buffer(char* bufEnd, UIntType value) {
+void uint_to_chars(char* dst, UIntType value, int digits) {
+    constexpr char digitPairs[] =
+        "00010203040506070809" "10111213141516171819" "20212223242526272829" "30313233343536373839"
+        "40414243444546474849" "50515253545556575859" "60616263646566676869" "70717273747576777879"
+        "80818283848586878889" "90919293949596979899";
+
+    char* p = dst + digits;
+    uint64_t wide = uint64_t(value);
+
+    // Peel off eight digits at a time so that the inner loop uses 32-bit arithmetic
+    while (wide > 0xFFFFFFFFull) {
+        uint32_t low = uint32_t(wide % 100000000u);
+        wide /= 100000000u;
+        for (int k = 0; k < 4; ++k) {
+            const size_t i = size_t(low % 100u) * 2;
+            low /= 100u;
+            *(--p) = digitPairs[i + 1];
+            *(--p) = digitPairs[i];
+        }
+    }
+
+    uint32_t v = uint32_t(wide);
+    while (v >= 100u) {
+        const size_t i = size_t(v % 100u) * 2;
+        v /= 100u;
+        *(--p) = digitPairs[i + 1];
+        *(--p) = digitPairs[i];
+    }
+    if (v >= 10u) {
+        const size_t i = size_t(v) * 2;
+        *(--p) = digitPairs[i + 1];
+        *(--p) = digitPairs[i];
+    } else {
+        *(--p) = static_cast<char>('0' + v);
+    }
+}
 
-    while (value >= 10)
-	{
-	  *(--bufEnd) = static_cast<char>('0' + (value % 10));
-	  value /= 10;
-	}
+/** Writes the decimal representation of value, with a leading '-' if negative, to dst and returns the
+    number of characters written, which is at most std::numeric_limits<IntType>::digits10 + 2. */
+template<typename IntType>
+size_t int_to_chars(char* dst, IntType value) {
+    using UIntType = std::make_unsigned_t<IntType>;
+    if constexpr (std::is_signed_v<IntType>) {
+        if (value < 0) {
+            const UIntType magnitude = UIntType(0) - static_cast<UIntType>(value);
+            const int digits = count_digits(magnitude);
+            *dst = '-';
+            uint_to_chars(dst + 1, magnitude, digits);
+            return size_t(digits) + 1;
+        }
+    }
+    const int digits = count_digits(static_cast<UIntType>(value));
+    uint_to_chars(dst, static_cast<UIntType>(value), digits);
+    return size_t(digits);
+}
 
-	*(--bufEnd) = static_cast<char>('0' + value);
+#if SIMDSTRING_SMALL_INT_COUNT > 0
+/** Null-terminated decimal spellings of [0, SIMDSTRING_SMALL_INT_COUNT), each in a slot of STRIDE bytes,
+    generated at compile time into read-only storage */
+struct SmallIntegerTable {
+    static constexpr size_t COUNT = SIMDSTRING_SMALL_INT_COUNT;
+    // The constructor's loop runs COUNT times at compile time, and gcc stops constant evaluation of
+    // loops after 262144 iterations by default
+    static_assert(COUNT <= 100000, "SIMDSTRING_SMALL_INT_COUNT must be at most 100000");
+    static constexpr size_t STRIDE = [] {
+        size_t digits = 1;
+        for (size_t v = COUNT - 1; v >= 10; v /= 10) { ++digits; }
+        return digits + 1;
+    }();
+
+    char chars[COUNT * STRIDE];
+
+    constexpr SmallIntegerTable() : chars() {
+        for (size_t i = 0; i < COUNT; ++i) {
+            char digits[STRIDE] = {};
+            size_t length = 0;
+            size_t v = i;
+            do {
+                digits[length++] = char('0' + v % 10);
+                v /= 10;
+            } while (v);
+            for (size_t d = 0; d < length; ++d) {
+                chars[i * STRIDE + d] = digits[length - 1 - d];
+            }
+        }
+    }
+};
 
-    return bufEnd; 
-}
+inline constexpr SmallIntegerTable smallIntegerTable;
+#endif
 
 #ifdef G3D_System_h
 template<size_t INTERNAL_SIZE = 64, class Allocator = G3D::g3d_allocator<char>, typename IntType>
@@ -2266,73 +3619,197 @@ template<size_t INTERNAL_SIZE = 64, class Allocator = G3D::g3d_allocator<char>,
 template<size_t INTERNAL_SIZE = 64, class Allocator = ::std::allocator<char>, typename IntType>
 #endif
 SIMDString<INTERNAL_SIZE, Allocator>  int_to_string(IntType value) {
-    const int n = std::numeric_limits<IntType>::digits10 + 3;
-    char str[n + 1] = {'\0'};
-
-    if (std::is_unsigned_v<IntType> || value >= 0) {
-        return SIMDString<INTERNAL_SIZE, Allocator>(uint_to_buffer(str + n, value));
-    } else {
-        using UIntType = std::make_unsigned_t<IntType>;
-        char* start  = uint_to_buffer(str + n, static_cast<UIntType>(0 - value));
-        *(--start) = '-';
+    typedef typename SIMDString<INTERNAL_SIZE, Allocator>::size_type size_type;
+
+#   if SIMDSTRING_SMALL_INT_COUNT > 0
+        if ((std::is_unsigned_v<IntType> || (value >= 0)) && (uint64_t(value) < SmallIntegerTable::COUNT)) {
+            // Share the precomputed spelling in constant storage
+            return SIMDString<INTERNAL_SIZE, Allocator>::borrow(smallIntegerTable.chars + size_t(value) * SmallIntegerTable::STRIDE,
+                                                                size_type(count_digits(uint64_t(value))));
+        }
+#   endif
+
+    using UIntType = std::make_unsigned_t<IntType>;
+    bool negative = false;
+    if constexpr (std::is_signed_v<IntType>) { negative = (value < 0); }
+    const UIntType magnitude = negative ? UIntType(UIntType(0) - static_cast<UIntType>(value)) : static_cast<UIntType>(value);
+    const int digits = count_digits(magnitude);
+
+    SIMDString<INTERNAL_SIZE, Allocator> result;
+
+    // Request exactly the final length, so that the digits are written in place into the internal buffer
+    // whenever it can hold them and the heap is only used for a small INTERNAL_SIZE
+    result.resize_and_overwrite(size_type(digits) + size_type(negative), [&](char* dst, size_type count) {
+        if (negative) { *dst = '-'; }
+        uint_to_chars(dst + size_type(negative), magnitude, digits);
+        return count;
+    });
+    return result;
+}
 
-        return SIMDString<INTERNAL_SIZE, Allocator>(start);
-    }
+/** Appends the decimal representation of the integer value to str, like std::to_chars but into a
+    SIMDString's own storage, and returns str. Avoids the temporary made by str += to_string(value). */
+template<size_t INTERNAL_SIZE, class Allocator, typename IntType,
+         std::enable_if_t<std::is_integral_v<IntType> && !std::is_same_v<IntType, bool> && !std::is_same_v<IntType, char>, int> = 0>
+SIMDString<INTERNAL_SIZE, Allocator>& to_chars(SIMDString<INTERNAL_SIZE, Allocator>& str, IntType value) {
+    char* dst = str.append_uninitialized(std::numeric_limits<IntType>::digits10 + 2);
+    str.commit_append(int_to_chars(dst, value));
+    return str;
 }
 
 TEMPLATE 
 SIMDString<INTERNAL_SIZE, Allocator> to_string(int value) {
-    return int_to_string(value);
+    return int_to_string<INTERNAL_SIZE, Allocator>(value);
 }
 
 TEMPLATE 
 SIMDString<INTERNAL_SIZE, Allocator> to_string(long value) {
-    return int_to_string(value);
+    return int_to_string<INTERNAL_SIZE, Allocator>(value);
 }
 
 TEMPLATE 
 SIMDString<INTERNAL_SIZE, Allocator> to_string(long long value) {
-    return int_to_string(value);
+    return int_to_string<INTERNAL_SIZE, Allocator>(value);
 }
 
 TEMPLATE 
 SIMDString<INTERNAL_SIZE, Allocator> to_string(unsigned int value) {
-    return int_to_string(value);
+    return int_to_string<INTERNAL_SIZE, Allocator>(value);
 }
 
 TEMPLATE 
 SIMDString<INTERNAL_SIZE, Allocator> to_string(unsigned long value) {
-    return int_to_string(value);
+    return int_to_string<INTERNAL_SIZE, Allocator>(value);
 }
 
 TEMPLATE 
 SIMDString<INTERNAL_SIZE, Allocator> to_string(unsigned long long value) {
-    return int_to_string(value);
+    return int_to_string<INTERNAL_SIZE, Allocator>(value);
 }
 
+/** "true" or "false" as a constant string, without copying. Unlike to_string(bool), which like
+    std::to_string promotes to int and returns "1" or "0". */
+TEMPLATE 
+SIMDString<INTERNAL_SIZE, Allocator> bool_to_string(bool value) {
+    return value ? SIMDString<INTERNAL_SIZE, Allocator>::borrow("true", 4) : SIMDString<INTERNAL_SIZE, Allocator>::borrow("false", 5);
+}
+
+#ifndef __cpp_lib_to_chars
+/** Fallback for standard libraries without floating-point std::to_chars. Formats value with snprintf,
+    which depends on the C locale, and returns the length that the output needs, which may exceed size.
+    A negative precision requests the fewest digits that strtold reads back as value. */
+template<typename FloatType>
+int float_snprintf(char* dst, size_t size, FloatType value, std::chars_format fmt = std::chars_format::general, int precision = -1) {
+    char format[8] = "%.*";
+    char* f = format + 3;
+    if (std::is_same_v<FloatType, long double>) { *f++ = 'L'; }
+    *f++ = (fmt == std::chars_format::fixed) ? 'f' : (fmt == std::chars_format::scientific) ? 'e' :
+           (fmt == std::chars_format::hex) ? 'a' : 'g';
+    *f = '\0';
+
+    if ((precision >= 0) || (fmt == std::chars_format::hex) || (value != value) || (value - value != 0)) {
+        return snprintf(dst, size + 1, format, precision, value);
+    }
+
+    // Shortest round trip: add digits until the value is recovered
+    for (int p = 0; ; ++p) {
+        const int len = snprintf(dst, size + 1, format, p, value);
+        if ((len > int(size)) || (FloatType(::strtold(dst, nullptr)) == value)) { return len; }
+    }
+}
+#endif
+
+/** Appends value to str as std::to_chars(first, last, value, formatArgs...) would format it, writing
+    directly into the string's storage. The first attempt reserves guess characters and the reservation
+    doubles until the output fits, which only happens for fixed notation of very large values. */
+template<class StringType, typename FloatType, typename... FormatArgs>
+StringType& float_to_chars(StringType& str, size_t guess, FloatType value, FormatArgs... formatArgs) {
+    size_t size = guess;
+    while (true) {
+        char* dst = str.append_uninitialized(size);
+#       ifdef __cpp_lib_to_chars
+            const std::to_chars_result result = std::to_chars(dst, dst + size, value, formatArgs...);
+            if (result.ec == std::errc()) {
+                str.commit_append(size_t(result.ptr - dst));
+                return str;
+            }
+            size *= 2;
+#       else
+            const int len = float_snprintf(dst, size, value, formatArgs...);
+            if ((len < 0) || (size_t(len) <= size)) {
+                str.commit_append(size_t(std::max(len, 0)));
+                return str;
+            }
+            size = size_t(len);
+#       endif
+    }
+}
+
+/** Appends the shortest representation of value that reads back exactly, like std::to_chars(first, last, value) */
+template<size_t INTERNAL_SIZE, class Allocator, typename FloatType, std::enable_if_t<std::is_floating_point_v<FloatType>, int> = 0>
+SIMDString<INTERNAL_SIZE, Allocator>& to_chars(SIMDString<INTERNAL_SIZE, Allocator>& str, FloatType value) {
+    return float_to_chars(str, 32, value);
+}
+
+/** Appends the shortest representation of value in the notation fmt that reads back exactly */
+template<size_t INTERNAL_SIZE, class Allocator, typename FloatType, std::enable_if_t<std::is_floating_point_v<FloatType>, int> = 0>
+SIMDString<INTERNAL_SIZE, Allocator>& to_chars(SIMDString<INTERNAL_SIZE, Allocator>& str, FloatType value, std::chars_format fmt) {
+    return float_to_chars(str, 32, value, fmt);
+}
+
+/** Appends value in the notation fmt with precision digits, like printf's %f, %e, %g and %a */
+template<size_t INTERNAL_SIZE, class Allocator, typename FloatType, std::enable_if_t<std::is_floating_point_v<FloatType>, int> = 0>
+SIMDString<INTERNAL_SIZE, Allocator>& to_chars(SIMDString<INTERNAL_SIZE, Allocator>& str, FloatType value, std::chars_format fmt, int precision) {
+    return float_to_chars(str, 32, value, fmt, precision);
+}
+
+#ifdef G3D_System_h
+template<size_t INTERNAL_SIZE = 64, class Allocator = G3D::g3d_allocator<char>, typename FloatType, typename... FormatArgs>
+#else
+template<size_t INTERNAL_SIZE = 64, class Allocator = ::std::allocator<char>, typename FloatType, typename... FormatArgs>
+#endif
+SIMDString<INTERNAL_SIZE, Allocator> float_to_string(FloatType value, FormatArgs... formatArgs) {
+    SIMDString<INTERNAL_SIZE, Allocator> result;
+    // Try the internal buffer first
+    float_to_chars(result, std::max<size_t>(INTERNAL_SIZE - 1, 16), value, formatArgs...);
+    return result;
+}
+
+/** Same output as std::to_string, which is printf's %f, but independent of the C locale */
 TEMPLATE 
 SIMDString<INTERNAL_SIZE, Allocator> to_string(float value) {
-    // max digits for exponent in base 10 + max digits for mantissa in base 10 + extra buffer for extraneous symbols [+-01.e+-]
-    const int n = std::numeric_limits<float>::max_exponent10 + std::numeric_limits<float>::max_digits10 + 10;
-    typename SIMDString<INTERNAL_SIZE, Allocator>::value_type str[n];
-    snprintf(str, n, "%f", value);
-    return SIMDString<INTERNAL_SIZE, Allocator>(str);
+    return float_to_string<INTERNAL_SIZE, Allocator>(value, std::chars_format::fixed, 6);
 }
 
 TEMPLATE 
 SIMDString<INTERNAL_SIZE, Allocator> to_string(double value) {
-    const int n = std::numeric_limits<double>::max_exponent10 + std::numeric_limits<double>::max_digits10 + 10;
-    typename SIMDString<INTERNAL_SIZE, Allocator>::value_type str[n];
-    snprintf(str, n, "%f", value); 
-    return SIMDString<INTERNAL_SIZE, Allocator>(str);
+    return float_to_string<INTERNAL_SIZE, Allocator>(value, std::chars_format::fixed, 6);
 }
 
 TEMPLATE 
 SIMDString<INTERNAL_SIZE, Allocator> to_string(long double value) {
-    const int n = std::numeric_limits<long double>::max_exponent10 + std::numeric_limits<long double>::max_digits10 + 10;
-    typename SIMDString<INTERNAL_SIZE, Allocator>::value_type str[n];
-    snprintf(str, n, "%Lf", value);
-    return SIMDString<INTERNAL_SIZE, Allocator>(str);
+    return float_to_string<INTERNAL_SIZE, Allocator>(value, std::chars_format::fixed, 6);
+}
+
+/** The shortest representation of value in the notation fmt that reads back exactly. Unlike to_string(value),
+    this prints 1e+300 rather than 301 digits for std::chars_format::general and scientific. */
+#ifdef G3D_System_h
+template<size_t INTERNAL_SIZE = 64, class Allocator = G3D::g3d_allocator<char>, typename FloatType, std::enable_if_t<std::is_floating_point_v<FloatType>, int> = 0>
+#else
+template<size_t INTERNAL_SIZE = 64, class Allocator = ::std::allocator<char>, typename FloatType, std::enable_if_t<std::is_floating_point_v<FloatType>, int> = 0>
+#endif
+SIMDString<INTERNAL_SIZE, Allocator> to_string(FloatType value, std::chars_format fmt) {
+    return float_to_string<INTERNAL_SIZE, Allocator>(value, fmt);
+}
+
+/** value in the notation fmt with precision digits, like printf's %f, %e, %g and %a */
+#ifdef G3D_System_h
+template<size_t INTERNAL_SIZE = 64, class Allocator = G3D::g3d_allocator<char>, typename FloatType, std::enable_if_t<std::is_floating_point_v<FloatType>, int> = 0>
+#else
+template<size_t INTERNAL_SIZE = 64, class Allocator = ::std::allocator<char>, typename FloatType, std::enable_if_t<std::is_floating_point_v<FloatType>, int> = 0>
+#endif
+SIMDString<INTERNAL_SIZE, Allocator> to_string(FloatType value, std::chars_format fmt, int precision) {
+    return float_to_string<INTERNAL_SIZE, Allocator>(value, fmt, precision);
 }
 
     
@@ -2344,7 +3821,41 @@ struct std::hash<SIMDString<_Size, _Alloc1>>
         // a recommended way of hashing bytes that is compiler neutral 
         // and does not require implementing our own hash function
         // https://learn.microsoft.com/en-us/cpp/porting/fix-your-dependencies-on-library-internals
-        return std::hash<std::string_view>{}(std::string_view(str.data()));
+        return std::hash<std::string_view>{}(std::string_view(str.data(), str.size()));
+    }
+};
+
+/** Transparent hash, equality and ordering that ignore the case of ASCII letters, for containers keyed
+    by asset paths, commands and settings. Keys and lookups may be any mix of SIMDString, std::string,
+    std::string_view and C strings, without lower-case copies.
+
+    \code
+    std::unordered_map<SIMDString<>, Command, CaseInsensitiveHash, CaseInsensitiveEqual> commands;
+    std::map<SIMDString<>, Setting, CaseInsensitiveLess> settings;
+    auto it = settings.find("Graphics.VSync");
+    \endcode
+*/
+struct CaseInsensitiveHash {
+    using is_transparent = void;
+
+    size_t operator()(SIMDString<>::StringViewArg s) const noexcept {
+        return ascii_ihash(s.data(), s.size());
+    }
+};
+
+struct CaseInsensitiveEqual {
+    using is_transparent = void;
+
+    bool operator()(SIMDString<>::StringViewArg a, SIMDString<>::StringViewArg b) const noexcept {
+        return (a.size() == b.size()) && ascii_iequal(a.data(), b.data(), a.size());
+    }
+};
+
+struct CaseInsensitiveLess {
+    using is_transparent = void;
+
+    bool operator()(SIMDString<>::StringViewArg a, SIMDString<>::StringViewArg b) const noexcept {
+        return ascii_icompare(a.data(), a.size(), b.data(), b.size()) < 0;
     }
 };
 
@@ -2363,4 +3874,5 @@ typename SIMDString<INTERNAL_SIZE, Allocator>::iterator end(SIMDString<INTERNAL_
 #undef TEMPLATE
 #undef ITERATOR_TRAITS
 #undef SSE_x64
+#undef SIMDSTRING_LITTLE_ENDIAN
 #undef m_allocatedSize
\ No newline at end of file
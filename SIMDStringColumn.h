@@ -0,0 +1,257 @@
+#pragma once
+/*
+MIT License
+
+Copyright (c) 2022 Morgan McGuire and Zander Majercik
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "SIMDString.h"
+#include "SIMDStringHash.h"
+#include <algorithm>
+#include <functional>
+#include <string_view>
+#include <vector>
+
+/**
+   \brief Many short strings stored column-wise, for batch queries over all of them.
+
+   The characters of every string are packed into one arena, with each string's offset and length in
+   parallel arrays, so a query streams through about (length + 8) bytes per string instead of an
+   80-byte SIMDString plus, for long strings, a heap block. The batch queries write one bit per string
+   into a Bitmask.
+
+   With padding, which is the default, each string starts on a 16-byte boundary of the arena and is
+   followed by zeros up to the next boundary, with at least one. The queries can then compare whole
+   16-byte blocks with SSE2 without bounds checks: equals() and starts_with() for patterns of up to 16
+   bytes take one load and compare per candidate string. Without padding the arena is smaller and the
+   queries fall back to memcmp() and memchr().
+
+   Strings are appended with push_back() and cannot be modified or removed. Views returned by
+   operator[] are invalidated by the next push_back().
+*/
+class SIMDStringColumn {
+public:
+    /** One bit per string, with bit i % 64 of word i / 64 for string i */
+    using Bitmask = std::vector<uint64_t>;
+
+    static inline bool test(const Bitmask& mask, size_t i) {
+        return (mask[i >> 6] >> (i & 63)) & 1;
+    }
+
+    /** Number of set bits */
+    static size_t count(const Bitmask& mask) {
+        size_t n = 0;
+        for (uint64_t word : mask) {
+#           ifdef _MSC_VER
+                n += size_t(__popcnt64(word));
+#           else
+                n += size_t(__builtin_popcountll(word));
+#           endif
+        }
+        return n;
+    }
+
+protected:
+    static constexpr size_t PAD = 16;
+
+    std::vector<uint32_t>   m_offsets;
+    std::vector<uint32_t>   m_lengths;
+    std::vector<char>       m_arena;
+    bool                    m_padded;
+
+    /** Sizes out to hold one bit per string, cleared */
+    inline void resetMask(Bitmask& out) const {
+        out.assign((m_lengths.size() + 63) / 64, 0);
+    }
+
+    /** Sets out's bit for every string of exactly length characters whose row passes test(row) */
+    template<class Test>
+    void filterByLength(size_t length, bool atLeast, Bitmask& out, Test test) const {
+        resetMask(out);
+        const uint32_t* lengths = m_lengths.data();
+        const size_t n = m_lengths.size();
+        size_t i = 0;
+
+#       ifdef SIMDSTRING_SSE2
+            if (! atLeast && (length <= UINT32_MAX)) {
+                // Reject rows four lengths at a time
+                const __m128i target = _mm_set1_epi32(int(uint32_t(length)));
+                for (; i + 4 <= n; i += 4) {
+                    const __m128i l = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lengths + i));
+                    unsigned int candidates = (unsigned int)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(l, target)));
+                    while (candidates) {
+                        const unsigned int k = countTrailingZeros(candidates);
+                        const size_t row = i + k;
+                        if (test(row)) { out[row >> 6] |= uint64_t(1) << (row & 63); }
+                        candidates &= candidates - 1;
+                    }
+                }
+            }
+#       endif
+
+        for (; i < n; ++i) {
+            if ((atLeast ? (lengths[i] >= length) : (lengths[i] == length)) && test(i)) {
+                out[i >> 6] |= uint64_t(1) << (i & 63);
+            }
+        }
+    }
+
+public:
+
+    explicit SIMDStringColumn(bool padded = true) : m_padded(padded) {}
+
+    inline bool padded() const {
+        return m_padded;
+    }
+
+    inline size_t size() const {
+        return m_lengths.size();
+    }
+
+    inline bool empty() const {
+        return m_lengths.empty();
+    }
+
+    /** Bytes used by the arena and the offset and length arrays */
+    inline size_t bytes() const {
+        return m_arena.size() + (m_offsets.size() + m_lengths.size()) * sizeof(uint32_t);
+    }
+
+    /** Reserves room for count strings totaling characters bytes */
+    void reserve(size_t count, size_t characters) {
+        m_offsets.reserve(count);
+        m_lengths.reserve(count);
+        m_arena.reserve(m_padded ? characters + count * PAD : characters);
+    }
+
+    void push_back(std::string_view s) {
+        assert(m_arena.size() + s.size() + PAD <= UINT32_MAX); // "SIMDStringColumn is limited to 4 GB"
+        m_offsets.push_back(uint32_t(m_arena.size()));
+        m_lengths.push_back(uint32_t(s.size()));
+        m_arena.insert(m_arena.end(), s.begin(), s.end());
+        if (m_padded) {
+            m_arena.resize((m_arena.size() / PAD + 1) * PAD, '\0');
+        }
+    }
+
+    template<size_t INTERNAL_SIZE, class Allocator>
+    void push_back(const SIMDString<INTERNAL_SIZE, Allocator>& s) {
+        push_back(std::string_view(s.data(), s.size()));
+    }
+
+    inline std::string_view operator[](size_t i) const {
+        return std::string_view(m_arena.data() + m_offsets[i], m_lengths[i]);
+    }
+
+    /** Sets out's bit for each string equal to literal */
+    void equals(std::string_view literal, Bitmask& out) const {
+        const char* const arena = m_arena.data();
+        const uint32_t* const offsets = m_offsets.data();
+#       ifdef SIMDSTRING_SSE2
+            if (m_padded && (literal.size() < PAD)) {
+                // The padding is zero, so the whole block matches the zero-padded literal
+                alignas(16) char padded[PAD] = {};
+                if (! literal.empty()) { ::memcpy(padded, literal.data(), literal.size()); }
+                const __m128i pattern = _mm_load_si128(reinterpret_cast<const __m128i*>(padded));
+                filterByLength(literal.size(), false, out, [&](size_t row) {
+                    const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(arena + offsets[row]));
+                    return _mm_movemask_epi8(_mm_cmpeq_epi8(block, pattern)) == 0xFFFF;
+                });
+                return;
+            }
+#       endif
+        filterByLength(literal.size(), false, out, [&](size_t row) {
+            return literal.empty() || (::memcmp(arena + offsets[row], literal.data(), literal.size()) == 0);
+        });
+    }
+
+    /** Sets out's bit for each string that begins with prefix */
+    void starts_with(std::string_view prefix, Bitmask& out) const {
+        const char* const arena = m_arena.data();
+        const uint32_t* const offsets = m_offsets.data();
+#       ifdef SIMDSTRING_SSE2
+            if (m_padded && (prefix.size() <= PAD)) {
+                alignas(16) char padded[PAD] = {};
+                if (! prefix.empty()) { ::memcpy(padded, prefix.data(), prefix.size()); }
+                const __m128i pattern = _mm_load_si128(reinterpret_cast<const __m128i*>(padded));
+                const int required = int((1u << prefix.size()) - 1);
+                filterByLength(prefix.size(), true, out, [&](size_t row) {
+                    const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(arena + offsets[row]));
+                    return (_mm_movemask_epi8(_mm_cmpeq_epi8(block, pattern)) & required) == required;
+                });
+                return;
+            }
+#       endif
+        filterByLength(prefix.size(), true, out, [&](size_t row) {
+            return prefix.empty() || (::memcmp(arena + offsets[row], prefix.data(), prefix.size()) == 0);
+        });
+    }
+
+    /** Sets out's bit for each string that contains c */
+    void contains(char c, Bitmask& out) const {
+        resetMask(out);
+        const char* const arena = m_arena.data();
+        const size_t n = m_lengths.size();
+#       ifdef SIMDSTRING_SSE2
+            if (m_padded) {
+                // Search whole blocks, masking off the padding in the last one
+                const __m128i target = _mm_set1_epi8(c);
+                for (size_t i = 0; i < n; ++i) {
+                    const char* p = arena + m_offsets[i];
+                    const size_t length = m_lengths[i];
+                    for (size_t k = 0; k < length; k += PAD, p += PAD) {
+                        unsigned int hits = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)), target));
+                        if (length - k < PAD) {
+                            hits &= (1u << (length - k)) - 1;
+                        }
+                        if (hits) {
+                            out[i >> 6] |= uint64_t(1) << (i & 63);
+                            break;
+                        }
+                    }
+                }
+                return;
+            }
+#       endif
+        for (size_t i = 0; i < n; ++i) {
+            if (m_lengths[i] && ::memchr(arena + m_offsets[i], c, m_lengths[i])) {
+                out[i >> 6] |= uint64_t(1) << (i & 63);
+            }
+        }
+    }
+
+    /** Writes std::hash<std::string_view> of each string to out, so that the results match
+        std::hash<SIMDString> */
+    void hash_all(std::vector<size_t>& out) const {
+        out.resize(m_lengths.size());
+        const char* const arena = m_arena.data();
+        // hash_batch interleaves several strings per call, so pass it views in chunks on the stack
+        constexpr size_t CHUNK = 64;
+        std::string_view views[CHUNK];
+        for (size_t i = 0; i < m_lengths.size(); i += CHUNK) {
+            const size_t n = std::min(CHUNK, m_lengths.size() - i);
+            for (size_t j = 0; j < n; ++j) {
+                views[j] = std::string_view(arena + m_offsets[i + j], m_lengths[i + j]);
+            }
+            hash_batch(views, n, out.data() + i);
+        }
+    }
+};
@@ -0,0 +1,390 @@
+#pragma once
+/*
+MIT License
+
+Copyright (c) 2022 Morgan McGuire and Zander Majercik
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "SIMDString.h"
+#include <algorithm>
+#include <string_view>
+#include <vector>
+
+/**
+   \brief Immutable sorted set of strings, front coded in blocks for compact storage.
+
+   The strings are sorted and split into blocks of blockSize. The first string of each block, its
+   head, is stored whole; each of the others is stored as the length of the prefix it shares with the
+   previous string and the remaining suffix, with both lengths as variable-length integers. Tables of
+   keys with long shared prefixes, such as "ui.menu.options.audio.volume", typically shrink to a few
+   bytes per string plus four per block.
+
+   find() binary searches the block heads and then scans one block, comparing only the suffixes
+   against the key without decoding the strings. get() decodes a string into a caller-provided
+   SIMDString so that loops over many strings can reuse one buffer.
+
+   The whole dictionary is one flat buffer, returned by bytes(), that can be written to a file and
+   later used in place with open(), for example from a memory mapping, without copying. open() checks
+   every offset and length once, so corrupt or untrusted files are rejected rather than read out of
+   bounds. The format uses native byte order and 32-bit offsets:
+
+   \code
+   "SFCD" version count blockSize blockCount     five 32-bit words
+   blockOffset[blockCount]                       32-bit offsets of each block within the blocks
+   blocks                                        head: length, bytes; then per string: shared, length, bytes
+   \endcode
+*/
+class SIMDStringDictionary {
+public:
+    static constexpr size_t npos = size_t(-1);
+    static constexpr uint32_t VERSION = 1;
+
+protected:
+    static constexpr size_t HEADER_WORDS = 5;
+
+    /** Set when the dictionary owns its buffer, as after build() */
+    std::vector<char>   m_storage;
+
+    const char*         m_bytes = nullptr;
+    size_t              m_byteCount = 0;
+    uint32_t            m_count = 0;
+    uint32_t            m_blockSize = 1;
+    uint32_t            m_blockCount = 0;
+    /** Unaligned 32-bit offsets, which may be in a memory mapping */
+    const char*         m_offsets = nullptr;
+    const char*         m_blocks = nullptr;
+
+    static inline uint32_t loadWord(const char* p) {
+        uint32_t w;
+        ::memcpy(&w, p, sizeof(w));
+        return w;
+    }
+
+    static inline void appendWord(std::vector<char>& out, uint32_t w) {
+        const char* p = reinterpret_cast<const char*>(&w);
+        out.insert(out.end(), p, p + sizeof(w));
+    }
+
+    static inline void appendVarint(std::vector<char>& out, size_t value) {
+        while (value >= 0x80) {
+            out.push_back(char(uint8_t(value) | 0x80));
+            value >>= 7;
+        }
+        out.push_back(char(value));
+    }
+
+    static inline size_t readVarint(const char*& p) {
+        size_t value = 0;
+        for (int shift = 0; ; shift += 7) {
+            const uint8_t b = uint8_t(*p++);
+            value |= size_t(b & 0x7F) << shift;
+            if (b < 0x80) { return value; }
+        }
+    }
+
+    /** Like readVarint, but returns false instead of reading at or past end or overflowing size_t */
+    static inline bool readVarintChecked(const char*& p, const char* end, size_t& value) {
+        value = 0;
+        for (int shift = 0; (p < end) && (shift < int(sizeof(size_t) * 8)); shift += 7) {
+            const uint8_t b = uint8_t(*p++);
+            value |= size_t(b & 0x7F) << shift;
+            if (b < 0x80) { return true; }
+        }
+        return false;
+    }
+
+    /** True if the blocks of the header-checked buffer lie within it, so that the unchecked decoding in
+        find(), get() and for_each() stays in bounds: each block starts where the previous one ended,
+        every length fits in the bytes that remain, and no string shares more than the previous one's
+        length. */
+    bool blocksAreValid(const char* end) const {
+        const char* p = m_blocks;
+        for (uint32_t b = 0; b < m_blockCount; ++b) {
+            if (loadWord(m_offsets + size_t(b) * sizeof(uint32_t)) != size_t(p - m_blocks)) { return false; }
+            size_t length;
+            if (! readVarintChecked(p, end, length) || (length > size_t(end - p))) { return false; }
+            p += length;
+            const uint32_t n = blockLength(b);
+            for (uint32_t i = 1; i < n; ++i) {
+                size_t shared, suffixLength;
+                if (! readVarintChecked(p, end, shared) || (shared > length) ||
+                    ! readVarintChecked(p, end, suffixLength) || (suffixLength > size_t(end - p))) {
+                    return false;
+                }
+                p += suffixLength;
+                length = shared + suffixLength;
+            }
+        }
+        return p == end;
+    }
+
+    inline const char* block(uint32_t b) const {
+        return m_blocks + loadWord(m_offsets + size_t(b) * sizeof(uint32_t));
+    }
+
+    /** The head of block b. Points into the buffer. */
+    inline std::string_view head(uint32_t b) const {
+        const char* p = block(b);
+        const size_t length = readVarint(p);
+        return std::string_view(p, length);
+    }
+
+    /** Number of strings in block b */
+    inline uint32_t blockLength(uint32_t b) const {
+        return (b + 1 < m_blockCount) ? m_blockSize : m_count - b * m_blockSize;
+    }
+
+    static inline size_t commonPrefix(std::string_view a, std::string_view b) {
+        const size_t n = std::min(a.size(), b.size());
+        size_t i = 0;
+        while ((i < n) && (a[i] == b[i])) { ++i; }
+        return i;
+    }
+
+public:
+
+    SIMDStringDictionary() {}
+
+    SIMDStringDictionary(const SIMDStringDictionary&) = delete;
+    SIMDStringDictionary& operator=(const SIMDStringDictionary&) = delete;
+
+    // Moving a std::vector keeps its buffer, so the pointers into m_storage remain valid
+    SIMDStringDictionary(SIMDStringDictionary&&) = default;
+    SIMDStringDictionary& operator=(SIMDStringDictionary&&) = default;
+
+    /** Builds a dictionary of the distinct strings in strings, which need not be sorted. Elements may be
+        any type accepted by SIMDString::join(). */
+    template<class Range>
+    static SIMDStringDictionary build(const Range& strings, uint32_t blockSize = 16) {
+        assert(blockSize > 0);
+        std::vector<std::string_view> sorted;
+        for (const auto& s : strings) {
+            sorted.push_back(SIMDString<>::StringViewArg(s));
+        }
+        std::sort(sorted.begin(), sorted.end());
+        sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+
+        const uint32_t count = uint32_t(sorted.size());
+        const uint32_t blockCount = (count + blockSize - 1) / blockSize;
+
+        std::vector<char> blocks;
+        std::vector<uint32_t> offsets;
+        offsets.reserve(blockCount);
+        for (uint32_t i = 0; i < count; ++i) {
+            const std::string_view s = sorted[i];
+            if (i % blockSize == 0) {
+                offsets.push_back(uint32_t(blocks.size()));
+                appendVarint(blocks, s.size());
+                blocks.insert(blocks.end(), s.begin(), s.end());
+            } else {
+                const size_t shared = commonPrefix(sorted[i - 1], s);
+                appendVarint(blocks, shared);
+                appendVarint(blocks, s.size() - shared);
+                blocks.insert(blocks.end(), s.begin() + shared, s.end());
+            }
+        }
+        assert(blocks.size() <= UINT32_MAX); // "SIMDStringDictionary is limited to 4 GB"
+
+        SIMDStringDictionary result;
+        std::vector<char>& out = result.m_storage;
+        out.reserve((HEADER_WORDS + blockCount) * sizeof(uint32_t) + blocks.size());
+        out.insert(out.end(), { 'S', 'F', 'C', 'D' });
+        appendWord(out, VERSION);
+        appendWord(out, count);
+        appendWord(out, blockSize);
+        appendWord(out, blockCount);
+        for (uint32_t offset : offsets) {
+            appendWord(out, offset);
+        }
+        out.insert(out.end(), blocks.begin(), blocks.end());
+
+        const bool ok = result.open(std::string_view(out.data(), out.size()));
+        assert(ok); (void)ok;
+        return result;
+    }
+
+    /** Uses a buffer previously returned by bytes() in place, without copying it. The buffer must
+        outlive the dictionary. Returns false, leaving the dictionary empty, if the buffer is not a valid
+        dictionary. The header, offset table and every length are checked in one pass over the buffer,
+        so a truncated or corrupt file is rejected rather than read out of bounds. */
+    bool open(std::string_view buffer) {
+        const bool owned = ! m_storage.empty() && (buffer.data() == m_storage.data());
+        if (! owned) {
+            m_storage.clear();
+        }
+
+        const char* p = buffer.data();
+        const size_t headerSize = HEADER_WORDS * sizeof(uint32_t);
+        if ((buffer.size() < headerSize) || (::memcmp(p, "SFCD", 4) != 0) || (loadWord(p + 4) != VERSION)) {
+            *this = SIMDStringDictionary();
+            return false;
+        }
+
+        const uint32_t count = loadWord(p + 8);
+        const uint32_t blockSize = loadWord(p + 12);
+        const uint32_t blockCount = loadWord(p + 16);
+        if ((blockSize == 0) || (blockCount != (uint64_t(count) + blockSize - 1) / blockSize) ||
+            (buffer.size() < headerSize + size_t(blockCount) * sizeof(uint32_t))) {
+            *this = SIMDStringDictionary();
+            return false;
+        }
+
+        m_bytes = p;
+        m_byteCount = buffer.size();
+        m_count = count;
+        m_blockSize = blockSize;
+        m_blockCount = blockCount;
+        m_offsets = p + headerSize;
+        m_blocks = m_offsets + size_t(blockCount) * sizeof(uint32_t);
+        if (! blocksAreValid(p + buffer.size())) {
+            *this = SIMDStringDictionary();
+            return false;
+        }
+        return true;
+    }
+
+    /** The flat representation, for writing to a file and later passing to open() */
+    inline std::string_view bytes() const {
+        return std::string_view(m_bytes, m_byteCount);
+    }
+
+    inline size_t size() const {
+        return m_count;
+    }
+
+    inline bool empty() const {
+        return m_count == 0;
+    }
+
+    /** Index of key in sorted order, or npos */
+    size_t find(std::string_view key) const {
+        if (m_count == 0) {
+            return npos;
+        }
+
+        // The last block whose head is <= key
+        uint32_t lo = 0;
+        uint32_t hi = m_blockCount;
+        while (hi - lo > 1) {
+            const uint32_t mid = lo + (hi - lo) / 2;
+            if (head(mid) <= key) {
+                lo = mid;
+            } else {
+                hi = mid;
+            }
+        }
+
+        const char* p = block(lo);
+        size_t length = readVarint(p);
+        // matched is the length of the common prefix of key and the previous string, which is < key
+        size_t matched = commonPrefix(std::string_view(p, length), key);
+        if ((matched == length) && (matched == key.size())) {
+            return size_t(lo) * m_blockSize;
+        } else if ((matched < length) && ((matched == key.size()) || (uint8_t(p[matched]) > uint8_t(key[matched])))) {
+            return npos;
+        }
+        p += length;
+
+        const uint32_t n = blockLength(lo);
+        for (uint32_t i = 1; i < n; ++i) {
+            const size_t shared = readVarint(p);
+            const size_t suffixLength = readVarint(p);
+            const char* suffix = p;
+            p += suffixLength;
+
+            if (shared > matched) {
+                // Agrees with the previous string past where it differed from key, so still < key
+                continue;
+            } else if (shared < matched) {
+                // Differs from the previous string where it matched key, and is greater, so > key
+                return npos;
+            }
+
+            const size_t common = commonPrefix(std::string_view(suffix, suffixLength), key.substr(matched));
+            if (common == suffixLength) {
+                if (matched + common == key.size()) {
+                    return size_t(lo) * m_blockSize + i;
+                }
+                // A proper prefix of key
+            } else if ((matched + common == key.size()) || (uint8_t(suffix[common]) > uint8_t(key[matched + common]))) {
+                return npos;
+            }
+            matched += common;
+        }
+        return npos;
+    }
+
+    template<size_t INTERNAL_SIZE, class Allocator>
+    size_t find(const SIMDString<INTERNAL_SIZE, Allocator>& key) const {
+        return find(std::string_view(key.data(), key.size()));
+    }
+
+    inline bool contains(std::string_view key) const {
+        return find(key) != npos;
+    }
+
+    /** Decodes the string at index into out, reusing its storage */
+    template<size_t INTERNAL_SIZE, class Allocator>
+    void get(size_t index, SIMDString<INTERNAL_SIZE, Allocator>& out) const {
+        assert(index < m_count);
+        const uint32_t b = uint32_t(index / m_blockSize);
+        const char* p = block(b);
+        const size_t length = readVarint(p);
+        out.assign(p, length);
+        p += length;
+        for (size_t i = size_t(b) * m_blockSize; i < index; ++i) {
+            const size_t shared = readVarint(p);
+            const size_t suffixLength = readVarint(p);
+            out.resize(shared);
+            out.append(p, suffixLength);
+            p += suffixLength;
+        }
+    }
+
+    SIMDString<> operator[](size_t index) const {
+        SIMDString<> s;
+        get(index, s);
+        return s;
+    }
+
+    /** Calls fn(index, const SIMDString<>& str) for every string in order, decoding into one buffer */
+    template<class Function>
+    void for_each(Function fn) const {
+        SIMDString<> s;
+        for (uint32_t b = 0; b < m_blockCount; ++b) {
+            const char* p = block(b);
+            const size_t length = readVarint(p);
+            s.assign(p, length);
+            p += length;
+            size_t index = size_t(b) * m_blockSize;
+            fn(index, static_cast<const SIMDString<>&>(s));
+            const uint32_t n = blockLength(b);
+            for (uint32_t i = 1; i < n; ++i) {
+                const size_t shared = readVarint(p);
+                const size_t suffixLength = readVarint(p);
+                s.resize(shared);
+                s.append(p, suffixLength);
+                p += suffixLength;
+                fn(++index, static_cast<const SIMDString<>&>(s));
+            }
+        }
+    }
+};
@@ -0,0 +1,376 @@
+#pragma once
+/*
+MIT License
+
+Copyright (c) 2022 Morgan McGuire and Zander Majercik
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "SIMDString.h"
+#include <array>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+/**
+   \file SIMDStringFormat.h
+
+   format<"HP: {}/{} ({:.1f}%)">(hp, maxHP, percent) renders into a SIMDString, and format_to<"...">(str, ...)
+   appends to an existing one. The format string is a template argument, so it is parsed and checked against
+   the argument count and types at compile time, and the output size is estimated up front so that the result is written
+   in one pass into storage reserved once, which is the internal buffer for typical UI text.
+
+   Replacement fields follow std::format: {} or {:[[fill]align][0][width][.precision][type]}, with align one of
+   '<', '>' and '^', and {{ and }} for literal braces. Fields are numbered automatically. Supported arguments
+   are integers (types d, x, X, o, b), floating point (types f, e, g, a; shortest round trip by default), bool,
+   char, and strings: SIMDString, std::string, std::string_view and const char*. For strings, precision
+   truncates. The result may be any SIMDString specialization.
+
+   Requires C++20, for class types as template arguments.
+*/
+
+#if defined(__cpp_nontype_template_args) && (__cpp_nontype_template_args >= 201911L)
+
+/** A string literal usable as a template argument */
+template<size_t N>
+struct FormatString {
+    char chars[N] = {};
+
+    constexpr FormatString(const char (&s)[N]) {
+        for (size_t i = 0; i < N; ++i) { chars[i] = s[i]; }
+    }
+
+    constexpr size_t size() const { return N - 1; }
+};
+
+/** One literal run of the format string, optionally followed by a replacement field */
+struct FormatSegment {
+    size_t      literalBegin = 0;
+    size_t      literalLength = 0;
+    bool        hasField = false;
+    char        fill = ' ';
+    /** '<', '>', '^', or '\0' for the default of the argument type */
+    char        align = '\0';
+    bool        zeroPad = false;
+    size_t      width = 0;
+    int         precision = -1;
+    char        type = '\0';
+};
+
+/** Parses F once at compile time */
+template<FormatString F>
+struct ParsedFormat {
+private:
+
+    static constexpr bool isAlign(char c) { return (c == '<') || (c == '>') || (c == '^'); }
+
+    static constexpr bool isType(char c) {
+        for (const char t : { 'd', 'x', 'X', 'o', 'b', 'f', 'e', 'g', 'a' }) { if (c == t) { return true; } }
+        return false;
+    }
+
+    // Parses the segments of F into out, which may be nullptr to count them. Throwing during
+    // constant evaluation turns a malformed format string into a compile error.
+    static constexpr size_t parse(FormatSegment* out) {
+        const char* s = F.chars;
+        const size_t n = F.size();
+        size_t count = 0;
+        FormatSegment segment;
+
+        for (size_t i = 0; i < n; ) {
+            const char c = s[i];
+            if ((c == '}') || ((c == '{') && (i + 1 < n) && (s[i + 1] == '{'))) {
+                if ((i + 1 >= n) || (s[i + 1] != c)) { throw "format string has an unmatched '}'"; }
+                // Keep one brace of the pair in this literal and skip the other
+                segment.literalLength = i + 1 - segment.literalBegin;
+                if (out) { out[count] = segment; }
+                ++count;
+                segment = FormatSegment();
+                segment.literalBegin = i + 2;
+                i += 2;
+            } else if (c == '{') {
+                segment.literalLength = i - segment.literalBegin;
+                segment.hasField = true;
+                ++i;
+                if ((i < n) && (s[i] == ':')) {
+                    ++i;
+                    if ((i + 1 < n) && isAlign(s[i + 1]) && (s[i] != '{') && (s[i] != '}')) {
+                        segment.fill = s[i];
+                        segment.align = s[i + 1];
+                        i += 2;
+                    } else if ((i < n) && isAlign(s[i])) {
+                        segment.align = s[i];
+                        ++i;
+                    }
+                    if ((i < n) && (s[i] == '0')) {
+                        segment.zeroPad = true;
+                        ++i;
+                    }
+                    for (; (i < n) && (s[i] >= '0') && (s[i] <= '9'); ++i) {
+                        segment.width = segment.width * 10 + size_t(s[i] - '0');
+                    }
+                    if ((i < n) && (s[i] == '.')) {
+                        ++i;
+                        if ((i >= n) || (s[i] < '0') || (s[i] > '9')) { throw "format string has '.' without a precision"; }
+                        segment.precision = 0;
+                        for (; (i < n) && (s[i] >= '0') && (s[i] <= '9'); ++i) {
+                            segment.precision = segment.precision * 10 + (s[i] - '0');
+                        }
+                    }
+                    if ((i < n) && (s[i] != '}')) {
+                        if (! isType(s[i])) { throw "format string has an unsupported type"; }
+                        segment.type = s[i];
+                        ++i;
+                    }
+                }
+                if ((i >= n) || (s[i] != '}')) { throw "format string has an unterminated or unsupported replacement field"; }
+                ++i;
+                if (out) { out[count] = segment; }
+                ++count;
+                segment = FormatSegment();
+                segment.literalBegin = i;
+            } else {
+                ++i;
+            }
+        }
+
+        segment.literalLength = n - segment.literalBegin;
+        if (segment.literalLength) {
+            if (out) { out[count] = segment; }
+            ++count;
+        }
+        return count;
+    }
+
+    static constexpr size_t segmentCount = parse(nullptr);
+
+    static constexpr std::array<FormatSegment, segmentCount> parseSegments() {
+        std::array<FormatSegment, segmentCount> result;
+        parse(result.data());
+        return result;
+    }
+
+public:
+
+    static constexpr std::array<FormatSegment, segmentCount> segments = parseSegments();
+
+    static constexpr size_t fieldCount = [] {
+        size_t count = 0;
+        for (const FormatSegment& segment : segments) { count += segment.hasField ? 1 : 0; }
+        return count;
+    }();
+
+    /** The segments that have replacement fields, in argument order */
+    static constexpr std::array<FormatSegment, fieldCount> fields = [] {
+        std::array<FormatSegment, fieldCount> result;
+        size_t i = 0;
+        for (const FormatSegment& segment : segments) {
+            if (segment.hasField) { result[i++] = segment; }
+        }
+        return result;
+    }();
+
+    /** Characters of literal text */
+    static constexpr size_t literalSize = [] {
+        size_t size = 0;
+        for (const FormatSegment& segment : segments) { size += segment.literalLength; }
+        return size;
+    }();
+};
+
+/** Estimate of the characters that format_argument() writes for value, ignoring width. This only
+    sizes the up-front reservation, so an underestimate costs a reallocation rather than correctness. */
+template<class T>
+size_t format_size_estimate(const FormatSegment& segment, const T& value) {
+    if constexpr (std::is_same_v<T, bool>) {
+        return 5;
+    } else if constexpr (std::is_same_v<T, char>) {
+        return 1;
+    } else if constexpr (std::is_integral_v<T>) {
+        using UIntType = std::make_unsigned_t<T>;
+        constexpr int bits = std::numeric_limits<UIntType>::digits;
+        const bool negative = std::is_signed_v<T> && (value < 0);
+        switch (segment.type) {
+        case 'b': return bits + (negative ? 1 : 0);
+        case 'o': return (bits + 2) / 3 + (negative ? 1 : 0);
+        case 'x': case 'X': return (bits + 3) / 4 + (negative ? 1 : 0);
+        default:
+            const UIntType magnitude = negative ? UIntType(0) - UIntType(value) : UIntType(value);
+            return size_t(count_digits(magnitude)) + (negative ? 1 : 0);
+        }
+    } else if constexpr (std::is_floating_point_v<T>) {
+        const size_t precision = size_t(std::max(segment.precision, 0));
+        if ((segment.type == 'f') && (value < T(1e15)) && (value > T(-1e15))) {
+            // Sign, integer digits, point and fraction
+            return size_t(count_digits(uint64_t(value < 0 ? -value : value))) + 2 + precision;
+        }
+        // Sign, leading digit, point, exponent and fraction, or a shortest round trip of a double
+        return std::max(size_t(24), 8 + precision);
+    } else if constexpr (std::is_convertible_v<const T&, const char*>) {
+        return ::strlen(value);
+    } else {
+        return value.size();
+    }
+}
+
+/** True if type, which may be '\0' for none, applies to arguments of type T: d, x, X, o and b to
+    integers, f, e, g and a to floating point, and none to bool, char and strings */
+template<class T>
+constexpr bool format_type_accepts(char type) {
+    if (! type) {
+        return true;
+    } else if constexpr (std::is_same_v<T, bool> || std::is_same_v<T, char>) {
+        return false;
+    } else if constexpr (std::is_integral_v<T>) {
+        return (type == 'd') || (type == 'x') || (type == 'X') || (type == 'o') || (type == 'b');
+    } else if constexpr (std::is_floating_point_v<T>) {
+        return (type == 'f') || (type == 'e') || (type == 'g') || (type == 'a');
+    } else {
+        return false;
+    }
+}
+
+template<class Parsed, class... Args, size_t... FIELD>
+constexpr bool format_types_match(std::index_sequence<FIELD...>) {
+    if constexpr (Parsed::fieldCount != sizeof...(Args)) {
+        // Reported by the argument count check instead
+        return true;
+    } else {
+        return (true && ... && format_type_accepts<std::decay_t<Args>>(Parsed::fields[FIELD].type));
+    }
+}
+
+template<class Parsed, class... Args, size_t... FIELD>
+size_t format_fields_estimate(std::index_sequence<FIELD...>, const Args&... args) {
+    return (size_t(0) + ... + std::max(Parsed::fields[FIELD].width, format_size_estimate(Parsed::fields[FIELD], args)));
+}
+
+/** Appends value to str formatted according to the type and precision of segment, without padding */
+template<class StringType, class T>
+void format_argument(StringType& str, const FormatSegment& segment, const T& value) {
+    if constexpr (std::is_same_v<T, bool>) {
+        str.append(value ? "true" : "false", value ? 4 : 5);
+    } else if constexpr (std::is_same_v<T, char>) {
+        str += value;
+    } else if constexpr (std::is_integral_v<T>) {
+        const int base = (segment.type == 'x' || segment.type == 'X') ? 16 : (segment.type == 'o') ? 8 : (segment.type == 'b') ? 2 : 10;
+        if (base == 10) {
+            to_chars(str, value);
+        } else {
+            // Sign and one digit per bit of the magnitude, which for the minimum of a signed type has
+            // one more bit than numeric_limits<T>::digits
+            constexpr size_t capacity = size_t(std::numeric_limits<std::make_unsigned_t<T>>::digits) + 1;
+            char* dst = str.append_uninitialized(capacity);
+            const std::to_chars_result result = std::to_chars(dst, dst + capacity, value, base);
+            assert(result.ec == std::errc());
+            if (segment.type == 'X') {
+                for (char* c = dst; c < result.ptr; ++c) { if (*c >= 'a') { *c -= 'a' - 'A'; } }
+            }
+            str.commit_append(size_t(result.ptr - dst));
+        }
+    } else if constexpr (std::is_floating_point_v<T>) {
+        const std::chars_format fmt =
+            (segment.type == 'f') ? std::chars_format::fixed :
+            (segment.type == 'e') ? std::chars_format::scientific :
+            (segment.type == 'a') ? std::chars_format::hex : std::chars_format::general;
+        if (segment.precision >= 0) {
+            to_chars(str, value, fmt, segment.precision);
+        } else if (segment.type) {
+            to_chars(str, value, fmt);
+        } else {
+            to_chars(str, value);
+        }
+    } else {
+        std::string_view view;
+        if constexpr (std::is_convertible_v<const T&, const char*>) {
+            view = std::string_view(value);
+        } else {
+            view = std::string_view(value.data(), value.size());
+        }
+        if (segment.precision >= 0) { view = view.substr(0, size_t(segment.precision)); }
+        str.append(view.data(), view.size());
+    }
+}
+
+/** Pads the characters appended since start to the width of segment */
+template<class StringType, class T>
+void format_pad(StringType& str, const FormatSegment& segment, size_t start) {
+    const size_t length = str.size() - start;
+    if (length >= segment.width) { return; }
+    const size_t padding = segment.width - length;
+
+    constexpr bool isNumber = std::is_arithmetic_v<T> && !std::is_same_v<T, bool> && !std::is_same_v<T, char>;
+    if (isNumber && segment.zeroPad && !segment.align) {
+        // Zeros go after the sign
+        const size_t digitsStart = start + ((str[start] == '-') ? 1 : 0);
+        str.insert(digitsStart, padding, '0');
+        return;
+    }
+
+    const char align = segment.align ? segment.align : (isNumber ? '>' : '<');
+    const size_t before = (align == '>') ? padding : (align == '^') ? padding / 2 : 0;
+    if (before) { str.insert(start, before, segment.fill); }
+    if (padding > before) { str.append(padding - before, segment.fill); }
+}
+
+template<class Parsed, size_t SEGMENT, class StringType, class... Args>
+void format_segments(StringType& str, const char* chars, const Args&... args) {
+    if constexpr (SEGMENT < Parsed::segments.size()) {
+        constexpr FormatSegment segment = Parsed::segments[SEGMENT];
+        if constexpr (segment.literalLength > 0) {
+            str.append(chars + segment.literalBegin, segment.literalLength);
+        }
+        if constexpr (segment.hasField) {
+            // Consume the first argument and pass on the rest
+            [&](const auto& value, const auto&... rest) {
+                using T = std::decay_t<decltype(value)>;
+                const size_t start = str.size();
+                format_argument(str, segment, value);
+                if constexpr (segment.width > 0) {
+                    format_pad<StringType, T>(str, segment, start);
+                }
+                format_segments<Parsed, SEGMENT + 1>(str, chars, rest...);
+            }(args...);
+        } else {
+            format_segments<Parsed, SEGMENT + 1>(str, chars, args...);
+        }
+    }
+}
+
+/** Appends args to str as described by the format string F, and returns str */
+template<FormatString F, class StringType, class... Args>
+StringType& format_to(StringType& str, const Args&... args) {
+    using Parsed = ParsedFormat<F>;
+    static_assert(Parsed::fieldCount == sizeof...(Args), "format argument count does not match the replacement fields");
+    static_assert(format_types_match<Parsed, Args...>(std::index_sequence_for<Args...>()), "format type does not apply to its argument");
+    str.reserve(str.size() + Parsed::literalSize + format_fields_estimate<Parsed>(std::index_sequence_for<Args...>(), args...));
+    format_segments<Parsed, 0>(str, F.chars, args...);
+    return str;
+}
+
+/** Formats args as described by the format string F, for example format<"{:>6.2f} ms">(elapsed) */
+template<FormatString F, class StringType = SIMDString<>, class... Args>
+StringType format(const Args&... args) {
+    StringType result;
+    format_to<F>(result, args...);
+    return result;
+}
+
+#endif
@@ -0,0 +1,190 @@
+#pragma once
+/*
+MIT License
+
+Copyright (c) 2022 Morgan McGuire and Zander Majercik
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "SIMDString.h"
+#include <functional>
+#include <string_view>
+#include <vector>
+
+#if defined(__GLIBCXX__) && (SIZE_MAX == UINT64_MAX) && defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+    // libstdc++'s std::hash<std::string_view> is _Hash_bytes() with this seed, which the batch
+    // reimplements so that it can interleave several strings
+#   define SIMDSTRINGHASH_MURMUR
+#endif
+
+#ifdef SIMDSTRINGHASH_MURMUR
+
+constexpr size_t HASH_BATCH_MUL  = (size_t(0xc6a4a793UL) << 32) + size_t(0x5bd1e995UL);
+constexpr size_t HASH_BATCH_SEED = size_t(0xc70f6907UL);
+
+inline size_t hash_batch_shift_mix(size_t v) {
+    return v ^ (v >> 47);
+}
+
+inline size_t hash_batch_word(const char* p) {
+    size_t w;
+    ::memcpy(&w, p, sizeof(size_t));
+    return w;
+}
+
+/** The last 1 to 7 bytes of a string as a little-endian integer, without reading past p + n */
+inline size_t hash_batch_tail(const char* p, size_t n) {
+    if (n >= 4) {
+        uint32_t lo, hi;
+        ::memcpy(&lo, p, 4);
+        ::memcpy(&hi, p + n - 4, 4);
+        return size_t(lo) | (size_t(hi) << (8 * (n - 4)));
+    } else {
+        return size_t(uint8_t(p[0])) | (size_t(uint8_t(p[n / 2])) << (8 * (n / 2))) | (size_t(uint8_t(p[n - 1])) << (8 * (n - 1)));
+    }
+}
+
+/** Hashes the words of one string from word index first onward. If padded, the string may be read up
+    to the next multiple of 8 bytes. */
+inline size_t hash_batch_finish(size_t hash, const char* p, size_t length, size_t first, bool padded) {
+    const size_t words = length / 8;
+    for (size_t w = first; w < words; ++w) {
+        hash = (hash ^ (hash_batch_shift_mix(hash_batch_word(p + 8 * w) * HASH_BATCH_MUL) * HASH_BATCH_MUL)) * HASH_BATCH_MUL;
+    }
+    const size_t rest = length & 7;
+    if (rest != 0) {
+        const size_t data = padded ?
+            (hash_batch_word(p + 8 * words) & ((size_t(1) << (8 * rest)) - 1)) :
+            hash_batch_tail(p + 8 * words, rest);
+        hash = (hash ^ data) * HASH_BATCH_MUL;
+    }
+    hash = hash_batch_shift_mix(hash) * HASH_BATCH_MUL;
+    return hash_batch_shift_mix(hash);
+}
+
+/** Hashes HASH_BATCH_LANES strings at once. The words that all of them have are hashed in lockstep
+    so that the multiply chains of the lanes overlap, then each lane finishes alone. Returns false
+    without writing out if any string is longer than HASH_BATCH_MAX_LENGTH, for which the library's
+    loop is as fast. */
+constexpr size_t HASH_BATCH_LANES = 4;
+constexpr size_t HASH_BATCH_MAX_LENGTH = 32;
+
+inline bool hash_batch_lanes(const char* const* data, const size_t* length, const bool* padded, size_t* out) {
+    for (size_t l = 0; l < HASH_BATCH_LANES; ++l) {
+        if (length[l] > HASH_BATCH_MAX_LENGTH) {
+            return false;
+        }
+    }
+
+    size_t hash[HASH_BATCH_LANES];
+    size_t common = length[0];
+    for (size_t l = 0; l < HASH_BATCH_LANES; ++l) {
+        hash[l] = HASH_BATCH_SEED ^ (length[l] * HASH_BATCH_MUL);
+        common = (length[l] < common) ? length[l] : common;
+    }
+    common /= 8;
+
+    for (size_t w = 0; w < common; ++w) {
+        for (size_t l = 0; l < HASH_BATCH_LANES; ++l) {
+            const size_t mixed = hash_batch_shift_mix(hash_batch_word(data[l] + 8 * w) * HASH_BATCH_MUL) * HASH_BATCH_MUL;
+            hash[l] = (hash[l] ^ mixed) * HASH_BATCH_MUL;
+        }
+    }
+
+    for (size_t l = 0; l < HASH_BATCH_LANES; ++l) {
+        out[l] = hash_batch_finish(hash[l], data[l], length[l], common, padded[l]);
+    }
+    return true;
+}
+
+#endif
+
+/**
+   Writes std::hash<SIMDString>()(strings[i]) to out[i] for each of the count strings.
+
+   Rebuilding a hash table hashes many short keys, and one at a time each key is a chain of dependent
+   multiplies plus a call into the library. With libstdc++ on 64-bit little-endian targets this
+   reimplements its string hash inline to run four keys of up to HASH_BATCH_MAX_LENGTH bytes in
+   lockstep, and reads the last partial word of an inline-mode string with one load from its
+   16-byte-aligned buffer, which is at least that long. SSE2 and AVX2 have no 64-bit multiply, so the
+   lanes are interleaved scalar registers rather than vector lanes. Elsewhere, and for longer strings,
+   it calls std::hash.
+*/
+template<size_t INTERNAL_SIZE, class Allocator>
+void hash_batch(const SIMDString<INTERNAL_SIZE, Allocator>* strings, size_t count, size_t* out) {
+    const std::hash<SIMDString<INTERNAL_SIZE, Allocator>> hasher;
+    size_t i = 0;
+#   ifdef SIMDSTRINGHASH_MURMUR
+        for (; i + HASH_BATCH_LANES <= count; i += HASH_BATCH_LANES) {
+            const char* data[HASH_BATCH_LANES];
+            size_t length[HASH_BATCH_LANES];
+            bool padded[HASH_BATCH_LANES];
+            for (size_t l = 0; l < HASH_BATCH_LANES; ++l) {
+                const SIMDString<INTERNAL_SIZE, Allocator>& s = strings[i + l];
+                data[l] = s.data();
+                length[l] = s.size();
+                // In the inline buffer, which is a multiple of 16 bytes and holds the terminator
+                const char* object = reinterpret_cast<const char*>(&s);
+                padded[l] = (data[l] >= object) && (data[l] < object + sizeof(s));
+            }
+            if (! hash_batch_lanes(data, length, padded, out + i)) {
+                for (size_t l = 0; l < HASH_BATCH_LANES; ++l) {
+                    out[i + l] = hasher(strings[i + l]);
+                }
+            }
+        }
+#   endif
+    for (; i < count; ++i) {
+        out[i] = hasher(strings[i]);
+    }
+}
+
+template<size_t INTERNAL_SIZE, class Allocator>
+void hash_batch(const std::vector<SIMDString<INTERNAL_SIZE, Allocator>>& strings, std::vector<size_t>& out) {
+    out.resize(strings.size());
+    hash_batch(strings.data(), strings.size(), out.data());
+}
+
+/** Writes std::hash<std::string_view>()(strings[i]) to out[i] for each of the count views */
+inline void hash_batch(const std::string_view* strings, size_t count, size_t* out) {
+    const std::hash<std::string_view> hasher;
+    size_t i = 0;
+#   ifdef SIMDSTRINGHASH_MURMUR
+        const bool padded[HASH_BATCH_LANES] = {};
+        for (; i + HASH_BATCH_LANES <= count; i += HASH_BATCH_LANES) {
+            const char* data[HASH_BATCH_LANES];
+            size_t length[HASH_BATCH_LANES];
+            for (size_t l = 0; l < HASH_BATCH_LANES; ++l) {
+                data[l] = strings[i + l].data();
+                length[l] = strings[i + l].size();
+            }
+            if (! hash_batch_lanes(data, length, padded, out + i)) {
+                for (size_t l = 0; l < HASH_BATCH_LANES; ++l) {
+                    out[i + l] = hasher(strings[i + l]);
+                }
+            }
+        }
+#   endif
+    for (; i < count; ++i) {
+        out[i] = hasher(strings[i]);
+    }
+}
+
+#undef SIMDSTRINGHASH_MURMUR
@@ -0,0 +1,161 @@
+#pragma once
+/*
+MIT License
+
+Copyright (c) 2022 Morgan McGuire and Zander Majercik
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "SIMDString.h"
+#include <memory>
+#include <string_view>
+#include <errno.h>
+#include <limits.h>
+
+#ifdef _WIN32
+#   include <io.h>
+#else
+#   include <sys/uio.h>
+#   include <unistd.h>
+#endif
+
+#ifndef _WIN32
+
+/** Number of iovec entries passed to each writev call. IOV_MAX is 1024 on Linux and macOS. */
+#   if defined(IOV_MAX) && (IOV_MAX < 1024)
+        constexpr int SIMDSTRING_IOV_BATCH = IOV_MAX;
+#   else
+        constexpr int SIMDSTRING_IOV_BATCH = 1024;
+#   endif
+
+/** Writes every byte described by iov[0, count), retrying after partial writes and EINTR.
+    Modifies iov. Returns false with errno set if writev fails. */
+inline bool writev_all(int fd, struct iovec* iov, int count) {
+    while (count > 0) {
+        const ssize_t written = ::writev(fd, iov, count);
+        if (written < 0) {
+            if (errno == EINTR) { continue; }
+            return false;
+        }
+
+        // Skip the fully written entries and trim the partially written one
+        size_t remaining = size_t(written);
+        while ((count > 0) && (remaining >= iov->iov_len)) {
+            remaining -= iov->iov_len;
+            ++iov;
+            --count;
+        }
+        if (count > 0) {
+            iov->iov_base = static_cast<char*>(iov->iov_base) + remaining;
+            iov->iov_len -= remaining;
+        }
+    }
+    return true;
+}
+
+#endif
+
+/** Pieces shorter than this are copied into a staging buffer and coalesced with their neighbors, because
+    the kernel's per-iovec cost exceeds the cost of copying them: one iovec per short line is slower than
+    std::ofstream. Longer pieces, and pieces that directly follow the previous one in memory, are written
+    in place. */
+constexpr size_t SIMDSTRING_WRITE_COALESCE_SIZE = 128;
+
+/**
+   Writes each string in strings to the file descriptor fd, followed by separator if it is not empty,
+   without going through a stream buffer. Strings of SIMDSTRING_WRITE_COALESCE_SIZE or more characters
+   are passed to writev as data()/size() pairs without copying, whether they are in the heap, the
+   internal buffer, or the constant segment. Works with any range whose elements have data() and size(),
+   such as std::vector<SIMDString>.
+
+   The iovec array and staging buffer, 16 KB each, are allocated per call rather than on the stack, and
+   the staging buffer only if there are short pieces.
+
+   Returns false with errno set on failure, in which case an unknown prefix of the output was written.
+   On Windows, each piece is written with a separate _write() call.
+*/
+template<class Range>
+bool write_all(int fd, const Range& strings, std::string_view separator = std::string_view()) {
+#   ifdef _WIN32
+        for (const auto& str : strings) {
+            for (std::string_view piece : { std::string_view(str.data(), str.size()), separator }) {
+                while (! piece.empty()) {
+                    const int written = ::_write(fd, piece.data(), (unsigned int)std::min(piece.size(), size_t(INT_MAX)));
+                    if (written < 0) { return false; }
+                    piece.remove_prefix(size_t(written));
+                }
+            }
+        }
+        return true;
+#   else
+        constexpr size_t STAGING_SIZE = 16 * 1024;
+        const std::unique_ptr<struct iovec[]> iov(new struct iovec[SIMDSTRING_IOV_BATCH]);
+        std::unique_ptr<char[]> staging;
+        int count = 0;
+        size_t staged = 0;
+        // End of the last iovec if it points at the caller's strings rather than the staging buffer
+        const char* inPlaceEnd = nullptr;
+        bool ok = true;
+
+        auto flush = [&]() {
+            ok = ok && writev_all(fd, iov.get(), count);
+            count = 0;
+            staged = 0;
+        };
+
+        auto add = [&](const char* data, size_t size) {
+            if (! size) {
+                return;
+            } else if (count && (data == inPlaceEnd)) {
+                // Directly follows the previous in-place piece, as for lines of a mapped file
+                iov[count - 1].iov_len += size;
+                inPlaceEnd += size;
+                return;
+            } else if (size < SIMDSTRING_WRITE_COALESCE_SIZE) {
+                if (! staging) { staging.reset(new char[STAGING_SIZE]); }
+                if (staged + size > STAGING_SIZE) { flush(); }
+                char* dst = staging.get() + staged;
+                ::memcpy(dst, data, size);
+                staged += size;
+                inPlaceEnd = nullptr;
+                if (count && (static_cast<char*>(iov[count - 1].iov_base) + iov[count - 1].iov_len == dst)) {
+                    // Extend the previous staged run
+                    iov[count - 1].iov_len += size;
+                    return;
+                }
+                iov[count].iov_base = dst;
+                iov[count].iov_len = size;
+            } else {
+                iov[count].iov_base = const_cast<char*>(data);
+                iov[count].iov_len = size;
+                inPlaceEnd = data + size;
+            }
+            if (++count == SIMDSTRING_IOV_BATCH) { flush(); }
+        };
+
+        for (const auto& str : strings) {
+            add(str.data(), str.size());
+            add(separator.data(), separator.size());
+            if (! ok) { return false; }
+        }
+        flush();
+        return ok;
+#   endif
+}
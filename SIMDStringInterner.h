@@ -0,0 +1,339 @@
+#pragma once
+/*
+MIT License
+
+Copyright (c) 2022 Morgan McGuire and Zander Majercik
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "SIMDString.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+/**
+   \brief A 32-bit handle to a string in a SIMDStringInterner.
+
+   Two symbols from the same interner are equal exactly when their strings are, so comparing and
+   hashing them costs the same as for integers. The default-constructed symbol is null and is not
+   equal to any interned string, including the empty one.
+*/
+class Symbol {
+protected:
+    friend class SIMDStringInterner;
+
+    uint32_t        m_id = 0;
+
+    explicit Symbol(uint32_t id) : m_id(id) {}
+
+public:
+
+    Symbol() {}
+
+    /** Nonzero for symbols returned by SIMDStringInterner, and unique within it */
+    inline uint32_t id() const {
+        return m_id;
+    }
+
+    explicit inline operator bool() const {
+        return m_id != 0;
+    }
+
+    inline bool operator==(Symbol other) const {
+        return m_id == other.m_id;
+    }
+
+    inline bool operator!=(Symbol other) const {
+        return m_id != other.m_id;
+    }
+
+    /** Orders by id, which is not the order of the strings */
+    inline bool operator<(Symbol other) const {
+        return m_id < other.m_id;
+    }
+};
+
+namespace std {
+    template<> struct hash<Symbol> {
+        size_t operator()(Symbol symbol) const noexcept {
+            return size_t(symbol.id());
+        }
+    };
+}
+
+/**
+   \brief Deduplicates strings into an append-only arena and names each by a Symbol.
+
+   The characters of each distinct string are stored once, null-terminated, in arena chunks that are
+   never moved or freed until the interner is destroyed, so str() returns a borrowed SIMDString that
+   points into the arena without copying, and copies of it share the pointer as constant segment
+   strings do. The chunks are registered with registerBorrowedBuffer(), so debug builds catch strings
+   that outlive their interner.
+
+   The strings are spread across SHARD_COUNT shards by hash. find(), str(), and view() never lock.
+   intern() first tries find() and only locks the string's shard to insert, so job threads inserting
+   different strings rarely contend.
+
+   \code
+   SIMDStringInterner names;
+   const Symbol albedo = names.intern("albedoTexture");
+   if (binding.name == albedo) { ... }
+   \endcode
+*/
+class SIMDStringInterner {
+public:
+    static constexpr uint32_t SHARD_BITS = 4;
+    static constexpr uint32_t SHARD_COUNT = 1 << SHARD_BITS;
+
+protected:
+
+    struct Entry {
+        const char*     chars;
+        size_t          length;
+        size_t          hash;
+    };
+
+    /** Entries are allocated in pages so that a published entry never moves */
+    static constexpr size_t PAGE_BITS = 10;
+    static constexpr size_t PAGE_SIZE = size_t(1) << PAGE_BITS;
+    static constexpr size_t MAX_PAGES = 1024;
+
+    static constexpr size_t ARENA_CHUNK_SIZE = 64 * 1024;
+    static constexpr size_t INITIAL_TABLE_SIZE = 64;
+
+    /** Open-addressed hash table. Each slot holds the high 32 bits of the hash and the symbol id,
+        or 0 if empty, so that most mismatches are rejected without reading the entry. */
+    struct Table {
+        size_t                                  mask;
+        std::unique_ptr<std::atomic<uint64_t>[]> slots;
+
+        explicit Table(size_t size) : mask(size - 1), slots(new std::atomic<uint64_t>[size]) {
+            for (size_t i = 0; i < size; ++i) {
+                slots[i].store(0, std::memory_order_relaxed);
+            }
+        }
+    };
+
+    struct alignas(64) Shard {
+        std::mutex                          mutex;
+        std::atomic<Table*>                 table{nullptr};
+        /** The current table and those it replaced, which readers may still be probing */
+        std::vector<std::unique_ptr<Table>> tables;
+        std::atomic<Entry*>                 pages[MAX_PAGES] = {};
+        std::atomic<uint32_t>               count{0};
+
+        char*                               arenaNext = nullptr;
+        size_t                              arenaRemaining = 0;
+        std::vector<std::unique_ptr<char[]>> arena;
+    };
+
+    std::unique_ptr<Shard[]>    m_shards;
+
+    /** The high half is a tag that rejects most mismatches without a compare. It is a remix of the whole
+        hash, rather than its high bits, so that it also varies where size_t is 32 bits. */
+    inline static uint64_t slotValue(size_t hash, uint32_t id) {
+        const uint32_t tag = uint32_t((uint64_t(hash) * 0x9E3779B97F4A7C15ULL) >> 32);
+        return (uint64_t(tag) << 32) | id;
+    }
+
+    inline const Entry& entry(uint32_t id) const {
+        const uint32_t index = id - 1;
+        const uint32_t local = index >> SHARD_BITS;
+        const Entry* page = m_shards[index & (SHARD_COUNT - 1)].pages[local >> PAGE_BITS].load(std::memory_order_acquire);
+        return page[local & (PAGE_SIZE - 1)];
+    }
+
+    /** Returns the slot holding text in table, or the empty slot where it belongs */
+    size_t probe(const Table& table, std::string_view text, size_t hash, uint64_t& slot) const {
+        const uint32_t tag = uint32_t(slotValue(hash, 0) >> 32);
+        for (size_t i = (hash >> SHARD_BITS) & table.mask; ; i = (i + 1) & table.mask) {
+            slot = table.slots[i].load(std::memory_order_acquire);
+            if (slot == 0) {
+                return i;
+            } else if (uint32_t(slot >> 32) == tag) {
+                const Entry& e = entry(uint32_t(slot));
+                if ((e.length == text.size()) && (text.empty() || (::memcmp(e.chars, text.data(), text.size()) == 0))) {
+                    return i;
+                }
+            }
+        }
+    }
+
+    /** Copies text and a terminator into shard's arena. Called with the shard locked. */
+    const char* store(Shard& shard, std::string_view text) {
+        const size_t size = text.size() + 1;
+        char* dst;
+        if (size > ARENA_CHUNK_SIZE / 4) {
+            // Large strings get their own chunk so that they do not waste the rest of the current one
+            shard.arena.emplace_back(new char[size]);
+            dst = shard.arena.back().get();
+            registerBorrowedBuffer(dst, size);
+        } else {
+            if (size > shard.arenaRemaining) {
+                shard.arena.emplace_back(new char[ARENA_CHUNK_SIZE]);
+                shard.arenaNext = shard.arena.back().get();
+                shard.arenaRemaining = ARENA_CHUNK_SIZE;
+                registerBorrowedBuffer(shard.arenaNext, ARENA_CHUNK_SIZE);
+            }
+            dst = shard.arenaNext;
+            shard.arenaNext += size;
+            shard.arenaRemaining -= size;
+        }
+        if (! text.empty()) {
+            ::memcpy(dst, text.data(), text.size());
+        }
+        dst[text.size()] = '\0';
+        return dst;
+    }
+
+    /** Replaces shard's table with one twice as large. Called with the shard locked. */
+    void grow(Shard& shard) {
+        const Table& old = *shard.table.load(std::memory_order_relaxed);
+        std::unique_ptr<Table> table(new Table(2 * (old.mask + 1)));
+        for (size_t i = 0; i <= old.mask; ++i) {
+            const uint64_t slot = old.slots[i].load(std::memory_order_relaxed);
+            if (slot) {
+                size_t j = (entry(uint32_t(slot)).hash >> SHARD_BITS) & table->mask;
+                while (table->slots[j].load(std::memory_order_relaxed)) {
+                    j = (j + 1) & table->mask;
+                }
+                table->slots[j].store(slot, std::memory_order_relaxed);
+            }
+        }
+        shard.table.store(table.get(), std::memory_order_release);
+        shard.tables.push_back(std::move(table));
+    }
+
+public:
+
+    SIMDStringInterner() : m_shards(new Shard[SHARD_COUNT]) {
+        for (uint32_t s = 0; s < SHARD_COUNT; ++s) {
+            m_shards[s].tables.emplace_back(new Table(INITIAL_TABLE_SIZE));
+            m_shards[s].table.store(m_shards[s].tables.back().get(), std::memory_order_relaxed);
+        }
+    }
+
+    SIMDStringInterner(const SIMDStringInterner&) = delete;
+    SIMDStringInterner& operator=(const SIMDStringInterner&) = delete;
+
+    ~SIMDStringInterner() {
+        for (uint32_t s = 0; s < SHARD_COUNT; ++s) {
+            Shard& shard = m_shards[s];
+            for (std::atomic<Entry*>& page : shard.pages) {
+                delete[] page.load(std::memory_order_relaxed);
+            }
+            for (const std::unique_ptr<char[]>& chunk : shard.arena) {
+                unregisterBorrowedBuffer(chunk.get());
+            }
+        }
+    }
+
+    /** Returns the symbol for text, or a null symbol if it has not been interned. Never locks. */
+    Symbol find(std::string_view text) const {
+        const size_t hash = std::hash<std::string_view>{}(text);
+        const Table& table = *m_shards[hash & (SHARD_COUNT - 1)].table.load(std::memory_order_acquire);
+        uint64_t slot;
+        probe(table, text, hash, slot);
+        return Symbol(uint32_t(slot));
+    }
+
+    /** Returns the symbol for text, copying it into the arena if it has not been seen before.
+        Throws std::length_error if a shard already holds MAX_PAGES * PAGE_SIZE strings. */
+    Symbol intern(std::string_view text) {
+        const size_t hash = std::hash<std::string_view>{}(text);
+        const uint32_t shardIndex = uint32_t(hash & (SHARD_COUNT - 1));
+        Shard& shard = m_shards[shardIndex];
+
+        uint64_t slot;
+        probe(*shard.table.load(std::memory_order_acquire), text, hash, slot);
+        if (slot) {
+            return Symbol(uint32_t(slot));
+        }
+
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        // Another thread may have inserted text, or grown the table, since the unlocked probe
+        Table& table = *shard.table.load(std::memory_order_relaxed);
+        const size_t i = probe(table, text, hash, slot);
+        if (slot) {
+            return Symbol(uint32_t(slot));
+        }
+
+        const uint32_t local = shard.count.load(std::memory_order_relaxed);
+        if (local >= MAX_PAGES * PAGE_SIZE) {
+            throw std::length_error("SIMDStringInterner shard is full");
+        }
+
+        Entry* page = shard.pages[local >> PAGE_BITS].load(std::memory_order_relaxed);
+        if (! page) {
+            page = new Entry[PAGE_SIZE];
+            shard.pages[local >> PAGE_BITS].store(page, std::memory_order_release);
+        }
+        page[local & (PAGE_SIZE - 1)] = Entry{ store(shard, text), text.size(), hash };
+
+        // Publishing the slot with release makes the entry and its characters visible to find()
+        const uint32_t id = ((local << SHARD_BITS) | shardIndex) + 1;
+        table.slots[i].store(slotValue(hash, id), std::memory_order_release);
+        shard.count.store(local + 1, std::memory_order_relaxed);
+
+        // Keep the load factor at most 1/2 so that probes stay short
+        if (2 * size_t(local + 1) > table.mask + 1) {
+            grow(shard);
+        }
+        return Symbol(id);
+    }
+
+    template<size_t INTERNAL_SIZE, class Allocator>
+    Symbol intern(const SIMDString<INTERNAL_SIZE, Allocator>& str) {
+        return intern(std::string_view(str.data(), str.size()));
+    }
+
+    Symbol intern(const char* s) {
+        return intern(std::string_view(s));
+    }
+
+    /** The characters of symbol, which remain valid for the lifetime of the interner.
+        symbol must have come from this interner. */
+    inline std::string_view view(Symbol symbol) const {
+        assert(symbol); // "Null Symbol"
+        const Entry& e = entry(symbol.id());
+        return std::string_view(e.chars, e.length);
+    }
+
+    /** A borrowed string that points into the arena, without copying */
+    template<class StringType = SIMDString<>>
+    StringType str(Symbol symbol) const {
+        const std::string_view v = view(symbol);
+        return StringType::borrow(v.data(), v.size());
+    }
+
+    /** Number of distinct strings interned */
+    size_t size() const {
+        size_t total = 0;
+        for (uint32_t s = 0; s < SHARD_COUNT; ++s) {
+            total += m_shards[s].count.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+};
@@ -0,0 +1,434 @@
+#pragma once
+/*
+MIT License
+
+Copyright (c) 2022 Morgan McGuire and Zander Majercik
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "SIMDString.h"
+#include <algorithm>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+/** Options for MultiPatternSearcher */
+struct MultiPatternOptions {
+    /** Match ASCII letters regardless of case */
+    bool    caseInsensitive = false;
+
+    /** Only match occurrences that are not preceded or followed by a word character: an ASCII letter,
+        digit, '_', or any byte >= 0x80, which covers UTF-8 letters */
+    bool    wholeWord = false;
+};
+
+/**
+   \brief Searches text for any of a fixed set of patterns at once.
+
+   Replaces a loop of SIMDString::find() calls, one per pattern, such as a chat filter or log alert
+   scan, with one pass over the text. The searcher is built once from the patterns and picks an
+   engine for their number:
+
+   - Up to TEDDY_MAX_PATTERNS patterns, with SSSE3: Teddy. The patterns are split into 8 buckets, and
+     per 16-byte block of text, two shuffles per leading pattern byte (up to 3) find the positions at
+     which some pattern of each bucket could start. Only those positions are compared against the
+     bucket's patterns.
+   - Otherwise: an Aho-Corasick automaton, whose time per byte does not depend on the number of
+     patterns. The root has a dense transition table and other states sorted edge lists.
+
+   Matches may overlap, and a pattern that occurs several times is reported each time. Empty patterns
+   never match. The text may be any SIMDString, std::string, std::string_view or C string.
+
+   \code
+   static const MultiPatternSearcher filter(bannedWords, { true, true });
+   if (filter.contains_any(message)) { ... }
+   \endcode
+*/
+class MultiPatternSearcher {
+public:
+    static constexpr size_t TEDDY_MAX_PATTERNS = 32;
+
+    enum class Engine { TEDDY, AHO_CORASICK };
+
+    struct Match {
+        /** Index of the pattern in the list passed to the constructor */
+        uint32_t    pattern;
+        size_t      position;
+        size_t      length;
+    };
+
+    typedef SIMDString<>::StringViewArg Text;
+
+protected:
+    std::vector<std::string>    m_patterns;
+    MultiPatternOptions         m_options;
+    Engine                      m_engine = Engine::AHO_CORASICK;
+    size_t                      m_maxLength = 0;
+
+    // Teddy: bucket bits for the low and high nibble of each of the first m_teddyBytes pattern bytes
+    alignas(16) uint8_t         m_teddyLow[3][16] = {};
+    alignas(16) uint8_t         m_teddyHigh[3][16] = {};
+    size_t                      m_teddyBytes = 0;
+    std::vector<uint32_t>       m_buckets[8];
+
+    // Aho-Corasick, with state 0 the root
+    struct State {
+        uint32_t    fail = 0;
+        // Nearest state on the fail chain with outputs, or 0
+        uint32_t    dictionary = 0;
+        uint32_t    edgeBegin = 0;
+        uint32_t    edgeCount = 0;
+        uint32_t    outputBegin = 0;
+        uint32_t    outputCount = 0;
+    };
+    std::vector<State>          m_states;
+    uint32_t                    m_rootNext[256] = {};
+    std::vector<uint8_t>        m_edgeBytes;
+    std::vector<uint32_t>       m_edgeTargets;
+    std::vector<uint32_t>       m_outputs;
+
+    static inline bool isWordByte(uint8_t c) {
+        return ((c >= 'a') && (c <= 'z')) || ((c >= 'A') && (c <= 'Z')) || ((c >= '0') && (c <= '9')) || (c == '_') || (c >= 0x80);
+    }
+
+    /** True if pattern occurs at text[position], which has room for it */
+    inline bool matchesAt(std::string_view text, size_t position, const std::string& pattern) const {
+        const char* t = text.data() + position;
+        return m_options.caseInsensitive ? ascii_iequal(t, pattern.data(), pattern.size()) : (::memcmp(t, pattern.data(), pattern.size()) == 0);
+    }
+
+    inline bool acceptable(std::string_view text, size_t position, size_t length) const {
+        return ! m_options.wholeWord ||
+            (((position == 0) || ! isWordByte(uint8_t(text[position - 1]))) &&
+             ((position + length == text.size()) || ! isWordByte(uint8_t(text[position + length]))));
+    }
+
+    void buildTeddy() {
+        size_t minLength = SIZE_MAX;
+        for (const std::string& p : m_patterns) {
+            if (! p.empty()) { minLength = std::min(minLength, p.size()); }
+        }
+        m_teddyBytes = std::min<size_t>(3, minLength);
+
+        for (uint32_t i = 0; i < m_patterns.size(); ++i) {
+            const std::string& p = m_patterns[i];
+            if (p.empty()) { continue; }
+            const uint32_t bucket = i % 8;
+            m_buckets[bucket].push_back(i);
+            for (size_t k = 0; k < m_teddyBytes; ++k) {
+                const uint8_t c = uint8_t(p[k]);
+                uint8_t variants[2] = { c, c };
+                if (m_options.caseInsensitive) {
+                    variants[0] = uint8_t(ascii_tolower(char(c)));
+                    variants[1] = uint8_t(ascii_toupper(char(c)));
+                }
+                for (const uint8_t v : variants) {
+                    m_teddyLow[k][v & 0x0F] |= uint8_t(1 << bucket);
+                    m_teddyHigh[k][v >> 4] |= uint8_t(1 << bucket);
+                }
+            }
+        }
+    }
+
+    void buildAhoCorasick() {
+        // Trie with per-node sorted child lists
+        std::vector<std::vector<std::pair<uint8_t, uint32_t>>> children(1);
+        std::vector<std::vector<uint32_t>> outputs(1);
+        for (uint32_t i = 0; i < m_patterns.size(); ++i) {
+            const std::string& p = m_patterns[i];
+            if (p.empty()) { continue; }
+            uint32_t node = 0;
+            for (const char ch : p) {
+                const uint8_t c = m_options.caseInsensitive ? uint8_t(ascii_tolower(ch)) : uint8_t(ch);
+                auto& list = children[node];
+                auto it = std::lower_bound(list.begin(), list.end(), std::make_pair(c, uint32_t(0)));
+                if ((it != list.end()) && (it->first == c)) {
+                    node = it->second;
+                } else {
+                    const uint32_t child = uint32_t(children.size());
+                    list.insert(it, std::make_pair(c, child));
+                    children.emplace_back();
+                    outputs.emplace_back();
+                    node = child;
+                }
+            }
+            outputs[node].push_back(i);
+        }
+
+        m_states.assign(children.size(), State());
+        for (uint32_t s = 0; s < children.size(); ++s) {
+            State& state = m_states[s];
+            state.edgeBegin = uint32_t(m_edgeBytes.size());
+            state.edgeCount = uint32_t(children[s].size());
+            for (const auto& edge : children[s]) {
+                m_edgeBytes.push_back(edge.first);
+                m_edgeTargets.push_back(edge.second);
+            }
+            state.outputBegin = uint32_t(m_outputs.size());
+            state.outputCount = uint32_t(outputs[s].size());
+            m_outputs.insert(m_outputs.end(), outputs[s].begin(), outputs[s].end());
+        }
+        for (const auto& edge : children[0]) {
+            m_rootNext[edge.first] = edge.second;
+        }
+
+        // Fail links in breadth-first order, so that every shallower state is done first
+        std::vector<uint32_t> queue;
+        queue.reserve(m_states.size());
+        for (const auto& edge : children[0]) {
+            queue.push_back(edge.second);
+        }
+        for (size_t q = 0; q < queue.size(); ++q) {
+            const uint32_t s = queue[q];
+            for (const auto& edge : children[s]) {
+                const uint32_t child = edge.second;
+                State& c = m_states[child];
+                c.fail = next(m_states[s].fail, edge.first);
+                const State& f = m_states[c.fail];
+                c.dictionary = f.outputCount ? c.fail : f.dictionary;
+                queue.push_back(child);
+            }
+        }
+    }
+
+    inline uint32_t child(uint32_t s, uint8_t c) const {
+        const State& state = m_states[s];
+        const uint8_t* bytes = m_edgeBytes.data() + state.edgeBegin;
+        if (state.edgeCount <= 8) {
+            for (uint32_t e = 0; e < state.edgeCount; ++e) {
+                if (bytes[e] == c) { return m_edgeTargets[state.edgeBegin + e]; }
+            }
+            return 0;
+        }
+        const uint8_t* found = std::lower_bound(bytes, bytes + state.edgeCount, c);
+        return ((found != bytes + state.edgeCount) && (*found == c)) ? m_edgeTargets[state.edgeBegin + uint32_t(found - bytes)] : 0;
+    }
+
+    /** Aho-Corasick transition from s on c, following fail links */
+    inline uint32_t next(uint32_t s, uint8_t c) const {
+        while (s != 0) {
+            const uint32_t t = child(s, c);
+            if (t) { return t; }
+            s = m_states[s].fail;
+        }
+        return m_rootNext[c];
+    }
+
+    /** Calls report(match) for matches starting at or before stopAt, which report may lower, in order
+        of position, until report returns false */
+    template<class Report>
+    void scanTeddy(std::string_view text, Report& report, size_t& stopAt) const {
+#   ifdef SIMDSTRING_SSSE3
+        const size_t n = text.size();
+        const __m128i nibbleMask = _mm_set1_epi8(0x0F);
+        const __m128i zero = _mm_setzero_si128();
+        __m128i low[3], high[3];
+        for (size_t k = 0; k < m_teddyBytes; ++k) {
+            low[k] = _mm_load_si128(reinterpret_cast<const __m128i*>(m_teddyLow[k]));
+            high[k] = _mm_load_si128(reinterpret_cast<const __m128i*>(m_teddyHigh[k]));
+        }
+
+        // Verifies the candidates of the 16 positions from base, whose bytes are at block
+        auto processBlock = [&](const char* block, size_t base, size_t valid) {
+            __m128i candidates = _mm_set1_epi8(-1);
+            for (size_t k = 0; k < m_teddyBytes; ++k) {
+                const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + k));
+                const __m128i l = _mm_shuffle_epi8(low[k], _mm_and_si128(v, nibbleMask));
+                const __m128i h = _mm_shuffle_epi8(high[k], _mm_and_si128(_mm_srli_epi16(v, 4), nibbleMask));
+                candidates = _mm_and_si128(candidates, _mm_and_si128(l, h));
+            }
+            unsigned int mask = ~(unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(candidates, zero)) & ((1u << valid) - 1);
+            if (! mask) { return true; }
+
+            alignas(16) uint8_t buckets[16];
+            _mm_store_si128(reinterpret_cast<__m128i*>(buckets), candidates);
+            while (mask) {
+                const unsigned int j = countTrailingZeros(mask);
+                mask &= mask - 1;
+                const size_t position = base + j;
+                if (position > stopAt) { return false; }
+                for (unsigned int bits = buckets[j]; bits; bits &= bits - 1) {
+                    for (const uint32_t i : m_buckets[countTrailingZeros(bits)]) {
+                        const std::string& p = m_patterns[i];
+                        if ((p.size() <= n - position) && matchesAt(text, position, p) && acceptable(text, position, p.size())) {
+                            if (! report(Match{ i, position, p.size() })) { return false; }
+                        }
+                    }
+                }
+            }
+            return true;
+        };
+
+        size_t position = 0;
+        // Each block reads m_teddyBytes - 1 bytes past its 16
+        for (; position + 16 + m_teddyBytes - 1 <= n; position += 16) {
+            if ((position > stopAt) || ! processBlock(text.data() + position, position, 16)) { return; }
+        }
+        for (; position < n; position += 16) {
+            char padded[32] = {};
+            const size_t available = std::min<size_t>(n - position, 18);
+            ::memcpy(padded, text.data() + position, available);
+            if ((position > stopAt) || ! processBlock(padded, position, std::min<size_t>(n - position, 16))) { return; }
+        }
+#   else
+        (void)text; (void)report; (void)stopAt;
+#   endif
+    }
+
+    /** Calls report(match) for matches ending at or before index stopAt, which report may lower, in
+        order of end, until report returns false */
+    template<class Report>
+    void scanAhoCorasick(std::string_view text, Report& report, size_t& stopAt) const {
+        const uint8_t* t = reinterpret_cast<const uint8_t*>(text.data());
+        const size_t n = text.size();
+        uint32_t s = 0;
+        for (size_t i = 0; (i < n) && (i <= stopAt); ++i) {
+            s = next(s, m_options.caseInsensitive ? uint8_t(ascii_tolower(char(t[i]))) : t[i]);
+            for (uint32_t d = m_states[s].outputCount ? s : m_states[s].dictionary; d != 0; d = m_states[d].dictionary) {
+                const State& state = m_states[d];
+                for (uint32_t o = 0; o < state.outputCount; ++o) {
+                    const uint32_t p = m_outputs[state.outputBegin + o];
+                    const size_t length = m_patterns[p].size();
+                    const size_t position = i + 1 - length;
+                    if (acceptable(text, position, length) && ! report(Match{ p, position, length })) {
+                        return;
+                    }
+                }
+            }
+        }
+    }
+
+    template<class Report>
+    void scan(std::string_view text, Report& report, size_t& stopAt) const {
+        if (m_engine == Engine::TEDDY) {
+            scanTeddy(text, report, stopAt);
+        } else {
+            scanAhoCorasick(text, report, stopAt);
+        }
+    }
+
+    void build() {
+        for (const std::string& p : m_patterns) {
+            m_maxLength = std::max(m_maxLength, p.size());
+        }
+#       ifdef SIMDSTRING_SSSE3
+            if ((m_patterns.size() <= TEDDY_MAX_PATTERNS) && (m_maxLength > 0)) {
+                m_engine = Engine::TEDDY;
+                buildTeddy();
+                return;
+            }
+#       endif
+        m_engine = Engine::AHO_CORASICK;
+        buildAhoCorasick();
+    }
+
+public:
+
+    /** patterns is a range of any string type, such as std::vector<SIMDString<>> */
+    template<class Range>
+    explicit MultiPatternSearcher(const Range& patterns, const MultiPatternOptions& options = MultiPatternOptions()) : m_options(options) {
+        for (const auto& p : patterns) {
+            const Text view(p);
+            m_patterns.emplace_back(view.data(), view.size());
+        }
+        assert(m_patterns.size() <= UINT32_MAX); // "MultiPatternSearcher is limited to 4G patterns"
+        build();
+    }
+
+    MultiPatternSearcher(std::initializer_list<Text> patterns, const MultiPatternOptions& options = MultiPatternOptions()) : m_options(options) {
+        for (const Text& p : patterns) {
+            m_patterns.emplace_back(p.data(), p.size());
+        }
+        build();
+    }
+
+    inline size_t size() const {
+        return m_patterns.size();
+    }
+
+    inline std::string_view pattern(size_t i) const {
+        return m_patterns[i];
+    }
+
+    inline Engine engine() const {
+        return m_engine;
+    }
+
+    inline const MultiPatternOptions& options() const {
+        return m_options;
+    }
+
+    /** Calls fn(const Match&) for every match, in an order that depends on the engine. fn may return
+        false to stop. */
+    template<class Function>
+    void for_each_match(Text text, Function fn) const {
+        size_t stopAt = SIZE_MAX;
+        auto report = [&](const Match& match) {
+            if constexpr (std::is_same_v<decltype(fn(match)), bool>) {
+                return fn(match);
+            } else {
+                fn(match);
+                return true;
+            }
+        };
+        scan(text, report, stopAt);
+    }
+
+    /** Every match, sorted by position and then by pattern index */
+    std::vector<Match> find_all(Text text) const {
+        std::vector<Match> matches;
+        for_each_match(text, [&](const Match& match) { matches.push_back(match); });
+        std::sort(matches.begin(), matches.end(), [](const Match& a, const Match& b) {
+            return (a.position != b.position) ? (a.position < b.position) : (a.pattern < b.pattern);
+        });
+        return matches;
+    }
+
+    /** Sets match to the leftmost match, and among those the one with the lowest pattern index, and
+        returns true, or returns false if there is none. Scans only as far as needed to be sure. */
+    bool find_first(Text text, Match& match) const {
+        bool found = false;
+        size_t stopAt = SIZE_MAX;
+        auto report = [&](const Match& m) {
+            if (! found || (m.position < match.position) || ((m.position == match.position) && (m.pattern < match.pattern))) {
+                match = m;
+                found = true;
+                // Teddy reports by position and Aho-Corasick by end, which is at most m_maxLength later
+                stopAt = (m_engine == Engine::TEDDY) ? match.position : match.position + m_maxLength - 1;
+            }
+            return true;
+        };
+        scan(text, report, stopAt);
+        return found;
+    }
+
+    bool contains_any(Text text) const {
+        bool found = false;
+        size_t stopAt = SIZE_MAX;
+        auto report = [&](const Match&) {
+            found = true;
+            return false;
+        };
+        scan(text, report, stopAt);
+        return found;
+    }
+};
@@ -0,0 +1,603 @@
+#pragma once
+/*
+MIT License
+
+Copyright (c) 2022 Morgan McGuire and Zander Majercik
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "SIMDString.h"
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+/**
+   \brief Ordered map from SIMDString keys to values, stored as an adaptive radix tree.
+
+   Each inner node branches on one byte of the key and grows through four layouts as children are
+   added: 4 and 16 children with sorted key bytes (the 16-way node is searched with one SSE2 compare),
+   48 children behind a 256-byte index, and 256 direct children. Runs of bytes shared by every key
+   below a node are stored once as the node's prefix, which points into one of those keys instead of
+   being copied.
+
+   Keys are visited in lexicographic byte order, with a key before its extensions. Prefix queries
+   only visit the subtree below the prefix, so autocomplete costs time proportional to the number of
+   completions rather than the number of keys. Callbacks passed to the for_each functions receive
+   (const SIMDString<>& key, const Value& value) and may return false to stop early.
+
+   Keys cannot be removed, except by clear().
+*/
+template<class Value>
+class SIMDStringRadixTree {
+public:
+
+    using Key = SIMDString<>;
+
+    enum NodeType : uint8_t {
+        NODE_4,
+        NODE_16,
+        NODE_48,
+        NODE_256,
+        LEAF,
+        NODE_TYPE_COUNT
+    };
+
+    /** Number of nodes of each NodeType, and their bytes including heap-allocated keys */
+    struct MemoryUsage {
+        size_t      count[NODE_TYPE_COUNT] = {};
+        size_t      bytes[NODE_TYPE_COUNT] = {};
+
+        size_t totalBytes() const {
+            size_t total = 0;
+            for (size_t b : bytes) { total += b; }
+            return total;
+        }
+    };
+
+protected:
+
+    struct Leaf;
+
+    struct Node {
+        NodeType        type;
+        uint16_t        count = 0;
+        uint32_t        prefixLength = 0;
+        /** Bytes shared by all keys below this node after the byte that selected it. Points into the
+            key of a leaf below, which never moves. */
+        const char*     prefix = nullptr;
+        /** The key that ends exactly after prefix, if any */
+        Leaf*           leaf = nullptr;
+
+        explicit Node(NodeType t) : type(t) {}
+    };
+
+    struct Leaf : public Node {
+        Key             key;
+        Value           value;
+
+        Leaf(const Key& k, const Value& v) : Node(LEAF), key(k), value(v) {}
+    };
+
+    struct Node4 : public Node {
+        uint8_t         keys[4] = {};
+        Node*           children[4] = {};
+        Node4() : Node(NODE_4) {}
+    };
+
+    struct Node16 : public Node {
+        uint8_t         keys[16] = {};
+        Node*           children[16] = {};
+        Node16() : Node(NODE_16) {}
+    };
+
+    struct Node48 : public Node {
+        /** One more than the index of the byte's child in children, or 0 */
+        uint8_t         index[256] = {};
+        Node*           children[48] = {};
+        Node48() : Node(NODE_48) {}
+    };
+
+    struct Node256 : public Node {
+        Node*           children[256] = {};
+        Node256() : Node(NODE_256) {}
+    };
+
+    Node*               m_root = nullptr;
+    size_t              m_size = 0;
+
+    /** Returns the slot that holds the child for byte, or nullptr */
+    static Node** findChild(Node* node, uint8_t byte) {
+        switch (node->type) {
+        case NODE_4: {
+            Node4* n = static_cast<Node4*>(node);
+            for (uint16_t i = 0; i < n->count; ++i) {
+                if (n->keys[i] == byte) { return &n->children[i]; }
+            }
+            return nullptr;
+        }
+        case NODE_16: {
+            Node16* n = static_cast<Node16*>(node);
+#           ifdef SIMDSTRING_SSE2
+                const __m128i match = _mm_cmpeq_epi8(_mm_set1_epi8(char(byte)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(n->keys)));
+                const unsigned int mask = (unsigned int)_mm_movemask_epi8(match) & ((1u << n->count) - 1);
+                if (mask) {
+                    return &n->children[countTrailingZeros(mask)];
+                }
+#           else
+                for (uint16_t i = 0; i < n->count; ++i) {
+                    if (n->keys[i] == byte) { return &n->children[i]; }
+                }
+#           endif
+            return nullptr;
+        }
+        case NODE_48: {
+            Node48* n = static_cast<Node48*>(node);
+            return n->index[byte] ? &n->children[n->index[byte] - 1] : nullptr;
+        }
+        case NODE_256: {
+            Node256* n = static_cast<Node256*>(node);
+            return n->children[byte] ? &n->children[byte] : nullptr;
+        }
+        default:
+            return nullptr;
+        }
+    }
+
+    /** Inserts into a Node4 or Node16, keeping keys sorted */
+    template<class SortedNode>
+    static void insertSorted(SortedNode* n, uint8_t byte, Node* child) {
+        uint16_t i = n->count;
+        for (; (i > 0) && (n->keys[i - 1] > byte); --i) {
+            n->keys[i] = n->keys[i - 1];
+            n->children[i] = n->children[i - 1];
+        }
+        n->keys[i] = byte;
+        n->children[i] = child;
+        ++n->count;
+    }
+
+    static void copyHeader(Node* to, const Node* from) {
+        to->count = from->count;
+        to->prefixLength = from->prefixLength;
+        to->prefix = from->prefix;
+        to->leaf = from->leaf;
+    }
+
+    /** Adds child for byte, which must not already be present, replacing ref with a larger node if full */
+    static void addChild(Node*& ref, uint8_t byte, Node* child) {
+        Node* node = ref;
+        switch (node->type) {
+        case NODE_4: {
+            Node4* n = static_cast<Node4*>(node);
+            if (n->count < 4) {
+                insertSorted(n, byte, child);
+                return;
+            }
+            Node16* grown = new Node16();
+            copyHeader(grown, n);
+            ::memcpy(grown->keys, n->keys, 4);
+            ::memcpy(grown->children, n->children, 4 * sizeof(Node*));
+            insertSorted(grown, byte, child);
+            ref = grown;
+            delete n;
+            return;
+        }
+        case NODE_16: {
+            Node16* n = static_cast<Node16*>(node);
+            if (n->count < 16) {
+                insertSorted(n, byte, child);
+                return;
+            }
+            Node48* grown = new Node48();
+            copyHeader(grown, n);
+            for (uint8_t i = 0; i < 16; ++i) {
+                grown->index[n->keys[i]] = uint8_t(i + 1);
+                grown->children[i] = n->children[i];
+            }
+            ref = grown;
+            delete n;
+            addChild(ref, byte, child);
+            return;
+        }
+        case NODE_48: {
+            Node48* n = static_cast<Node48*>(node);
+            if (n->count < 48) {
+                n->children[n->count] = child;
+                n->index[byte] = uint8_t(++n->count);
+                return;
+            }
+            Node256* grown = new Node256();
+            copyHeader(grown, n);
+            for (int b = 0; b < 256; ++b) {
+                if (n->index[b]) { grown->children[b] = n->children[n->index[b] - 1]; }
+            }
+            ref = grown;
+            delete n;
+            addChild(ref, byte, child);
+            return;
+        }
+        case NODE_256: {
+            Node256* n = static_cast<Node256*>(node);
+            n->children[byte] = child;
+            ++n->count;
+            return;
+        }
+        default:
+            assert(false); // "addChild on a leaf"
+        }
+    }
+
+    /** Attaches leaf below node, which consumed the key through depth */
+    static void attach(Node*& ref, Leaf* leaf, size_t depth) {
+        if (leaf->key.size() == depth) {
+            ref->leaf = leaf;
+        } else {
+            addChild(ref, uint8_t(leaf->key[depth]), leaf);
+        }
+    }
+
+    static size_t commonPrefix(const char* a, size_t aLength, const char* b, size_t bLength) {
+        const size_t n = std::min(aLength, bLength);
+        size_t i = 0;
+        while ((i < n) && (a[i] == b[i])) { ++i; }
+        return i;
+    }
+
+    /** Returns the leaf for key, inserting one with value if it is absent */
+    Leaf* insert(Node*& ref, std::string_view key, size_t depth, const Value& value, bool& inserted) {
+        Node* node = ref;
+        if (! node) {
+            Leaf* leaf = new Leaf(Key(key.data(), key.size()), value);
+            ref = leaf;
+            inserted = true;
+            return leaf;
+        }
+
+        if (node->type == LEAF) {
+            Leaf* old = static_cast<Leaf*>(node);
+            if (std::string_view(old->key.data(), old->key.size()) == key) {
+                return old;
+            }
+
+            // Split the leaf into a node whose prefix is what the two keys share
+            Leaf* leaf = new Leaf(Key(key.data(), key.size()), value);
+            inserted = true;
+            const size_t shared = commonPrefix(old->key.data() + depth, old->key.size() - depth, key.data() + depth, key.size() - depth);
+            Node* split = new Node4();
+            split->prefix = old->key.data() + depth;
+            split->prefixLength = uint32_t(shared);
+            attach(split, old, depth + shared);
+            attach(split, leaf, depth + shared);
+            ref = split;
+            return leaf;
+        }
+
+        const size_t shared = commonPrefix(node->prefix, node->prefixLength, key.data() + depth, key.size() - depth);
+        if (shared < node->prefixLength) {
+            // key diverges inside the prefix, so split it at the first differing byte
+            Leaf* leaf = new Leaf(Key(key.data(), key.size()), value);
+            inserted = true;
+            Node* split = new Node4();
+            split->prefix = node->prefix;
+            split->prefixLength = uint32_t(shared);
+            const uint8_t branch = uint8_t(node->prefix[shared]);
+            node->prefix += shared + 1;
+            node->prefixLength -= uint32_t(shared + 1);
+            addChild(split, branch, node);
+            attach(split, leaf, depth + shared);
+            ref = split;
+            return leaf;
+        }
+
+        depth += node->prefixLength;
+        if (depth == key.size()) {
+            if (! node->leaf) {
+                node->leaf = new Leaf(Key(key.data(), key.size()), value);
+                inserted = true;
+            }
+            return node->leaf;
+        }
+
+        Node** child = findChild(node, uint8_t(key[depth]));
+        if (child) {
+            return insert(*child, key, depth + 1, value, inserted);
+        }
+        Leaf* leaf = new Leaf(Key(key.data(), key.size()), value);
+        inserted = true;
+        addChild(ref, uint8_t(key[depth]), leaf);
+        return leaf;
+    }
+
+    /** Calls fn on each leaf below node in key order. Returns false if fn stopped the traversal. */
+    template<class Function>
+    static bool visit(const Node* node, Function& fn) {
+        if (node->type == LEAF) {
+            const Leaf* leaf = static_cast<const Leaf*>(node);
+            if constexpr (std::is_same_v<decltype(fn(leaf->key, leaf->value)), bool>) {
+                return fn(leaf->key, leaf->value);
+            } else {
+                fn(leaf->key, leaf->value);
+                return true;
+            }
+        }
+
+        if (node->leaf && ! visit(node->leaf, fn)) {
+            return false;
+        }
+
+        switch (node->type) {
+        case NODE_4:
+        case NODE_16: {
+            const Node* const* children = (node->type == NODE_4) ? static_cast<const Node4*>(node)->children : static_cast<const Node16*>(node)->children;
+            for (uint16_t i = 0; i < node->count; ++i) {
+                if (! visit(children[i], fn)) { return false; }
+            }
+            return true;
+        }
+        case NODE_48: {
+            const Node48* n = static_cast<const Node48*>(node);
+            for (int b = 0; b < 256; ++b) {
+                if (n->index[b] && ! visit(n->children[n->index[b] - 1], fn)) { return false; }
+            }
+            return true;
+        }
+        default: {
+            const Node256* n = static_cast<const Node256*>(node);
+            for (int b = 0; b < 256; ++b) {
+                if (n->children[b] && ! visit(n->children[b], fn)) { return false; }
+            }
+            return true;
+        }
+        }
+    }
+
+    static void destroy(Node* node) {
+        if (! node) { return; }
+        switch (node->type) {
+        case LEAF:
+            delete static_cast<Leaf*>(node);
+            return;
+        case NODE_4: {
+            Node4* n = static_cast<Node4*>(node);
+            for (uint16_t i = 0; i < n->count; ++i) { destroy(n->children[i]); }
+            destroy(n->leaf);
+            delete n;
+            return;
+        }
+        case NODE_16: {
+            Node16* n = static_cast<Node16*>(node);
+            for (uint16_t i = 0; i < n->count; ++i) { destroy(n->children[i]); }
+            destroy(n->leaf);
+            delete n;
+            return;
+        }
+        case NODE_48: {
+            Node48* n = static_cast<Node48*>(node);
+            for (uint16_t i = 0; i < n->count; ++i) { destroy(n->children[i]); }
+            destroy(n->leaf);
+            delete n;
+            return;
+        }
+        default: {
+            Node256* n = static_cast<Node256*>(node);
+            for (int b = 0; b < 256; ++b) { destroy(n->children[b]); }
+            destroy(n->leaf);
+            delete n;
+            return;
+        }
+        }
+    }
+
+    static void measure(const Node* node, MemoryUsage& usage) {
+        static const size_t sizes[NODE_TYPE_COUNT] = { sizeof(Node4), sizeof(Node16), sizeof(Node48), sizeof(Node256), sizeof(Leaf) };
+        ++usage.count[node->type];
+        usage.bytes[node->type] += sizes[node->type];
+        if (node->type == LEAF) {
+            const Key& key = static_cast<const Leaf*>(node)->key;
+            const bool internal = (key.data() >= reinterpret_cast<const char*>(&key)) && (key.data() < reinterpret_cast<const char*>(&key + 1));
+            if (! internal && ! key.is_borrowed()) {
+                // Heap-allocated key characters
+                usage.bytes[LEAF] += key.capacity();
+            }
+            return;
+        }
+        if (node->leaf) {
+            measure(node->leaf, usage);
+        }
+        forEachChild(node, [&](const Node* child) { measure(child, usage); });
+    }
+
+    template<class Function>
+    static void forEachChild(const Node* node, Function fn) {
+        switch (node->type) {
+        case NODE_4:
+            for (uint16_t i = 0; i < node->count; ++i) { fn(static_cast<const Node4*>(node)->children[i]); }
+            return;
+        case NODE_16:
+            for (uint16_t i = 0; i < node->count; ++i) { fn(static_cast<const Node16*>(node)->children[i]); }
+            return;
+        case NODE_48:
+            for (uint16_t i = 0; i < node->count; ++i) { fn(static_cast<const Node48*>(node)->children[i]); }
+            return;
+        case NODE_256:
+            for (int b = 0; b < 256; ++b) {
+                if (static_cast<const Node256*>(node)->children[b]) { fn(static_cast<const Node256*>(node)->children[b]); }
+            }
+            return;
+        default:
+            return;
+        }
+    }
+
+public:
+
+    SIMDStringRadixTree() {}
+
+    SIMDStringRadixTree(const SIMDStringRadixTree&) = delete;
+    SIMDStringRadixTree& operator=(const SIMDStringRadixTree&) = delete;
+
+    ~SIMDStringRadixTree() {
+        destroy(m_root);
+    }
+
+    void clear() {
+        destroy(m_root);
+        m_root = nullptr;
+        m_size = 0;
+    }
+
+    inline size_t size() const {
+        return m_size;
+    }
+
+    inline bool empty() const {
+        return m_size == 0;
+    }
+
+    /** Maps key to value. Returns false, leaving the existing value unchanged, if key was already present. */
+    bool insert(std::string_view key, const Value& value) {
+        bool inserted = false;
+        insert(m_root, key, 0, value, inserted);
+        m_size += inserted;
+        return inserted;
+    }
+
+    template<size_t INTERNAL_SIZE, class Allocator>
+    bool insert(const SIMDString<INTERNAL_SIZE, Allocator>& key, const Value& value) {
+        return insert(std::string_view(key.data(), key.size()), value);
+    }
+
+    /** The value for key, default-constructing it if key is absent */
+    Value& operator[](std::string_view key) {
+        bool inserted = false;
+        Value& value = insert(m_root, key, 0, Value(), inserted)->value;
+        m_size += inserted;
+        return value;
+    }
+
+    /** The value for key, or nullptr */
+    const Value* find(std::string_view key) const {
+        const Node* node = m_root;
+        size_t depth = 0;
+        while (node) {
+            if (node->type == LEAF) {
+                const Leaf* leaf = static_cast<const Leaf*>(node);
+                return (std::string_view(leaf->key.data(), leaf->key.size()) == key) ? &leaf->value : nullptr;
+            }
+            if ((key.size() - depth < node->prefixLength) || (::memcmp(node->prefix, key.data() + depth, node->prefixLength) != 0)) {
+                return nullptr;
+            }
+            depth += node->prefixLength;
+            if (depth == key.size()) {
+                return node->leaf ? &node->leaf->value : nullptr;
+            }
+            Node** child = findChild(const_cast<Node*>(node), uint8_t(key[depth]));
+            node = child ? *child : nullptr;
+            ++depth;
+        }
+        return nullptr;
+    }
+
+    Value* find(std::string_view key) {
+        return const_cast<Value*>(static_cast<const SIMDStringRadixTree*>(this)->find(key));
+    }
+
+    inline bool contains(std::string_view key) const {
+        return find(key) != nullptr;
+    }
+
+    /** Calls fn(key, value) for every key in order */
+    template<class Function>
+    void for_each(Function fn) const {
+        if (m_root) {
+            visit(m_root, fn);
+        }
+    }
+
+    /** Calls fn(key, value) in order for every key that starts with prefix, including prefix itself */
+    template<class Function>
+    void for_each_prefix(std::string_view prefix, Function fn) const {
+        const Node* node = m_root;
+        size_t depth = 0;
+        while (node) {
+            if (node->type == LEAF) {
+                const Leaf* leaf = static_cast<const Leaf*>(node);
+                if (std::string_view(leaf->key.data(), leaf->key.size()).substr(0, prefix.size()) == prefix) {
+                    visit(node, fn);
+                }
+                return;
+            }
+
+            // Every key below node starts with the query if the query ends inside node's prefix
+            const size_t compared = std::min(size_t(node->prefixLength), prefix.size() - depth);
+            if (::memcmp(node->prefix, prefix.data() + depth, compared) != 0) {
+                return;
+            }
+            depth += compared;
+            if (depth == prefix.size()) {
+                visit(node, fn);
+                return;
+            }
+
+            Node** child = findChild(const_cast<Node*>(node), uint8_t(prefix[depth]));
+            node = child ? *child : nullptr;
+            ++depth;
+        }
+    }
+
+    /** The longest key that is a prefix of text, and its value, or nullptr if no key is */
+    std::pair<const Key*, const Value*> longest_prefix(std::string_view text) const {
+        const Leaf* best = nullptr;
+        const Node* node = m_root;
+        size_t depth = 0;
+        while (node) {
+            if (node->type == LEAF) {
+                const Leaf* leaf = static_cast<const Leaf*>(node);
+                if (std::string_view(leaf->key.data(), leaf->key.size()) == text.substr(0, leaf->key.size())) {
+                    best = leaf;
+                }
+                break;
+            }
+            if ((text.size() - depth < node->prefixLength) || (::memcmp(node->prefix, text.data() + depth, node->prefixLength) != 0)) {
+                break;
+            }
+            depth += node->prefixLength;
+            if (node->leaf) {
+                best = node->leaf;
+            }
+            if (depth == text.size()) {
+                break;
+            }
+            Node** child = findChild(const_cast<Node*>(node), uint8_t(text[depth]));
+            node = child ? *child : nullptr;
+            ++depth;
+        }
+        return best ? std::pair<const Key*, const Value*>(&best->key, &best->value) : std::pair<const Key*, const Value*>(nullptr, nullptr);
+    }
+
+    /** Counts nodes and bytes by NodeType */
+    MemoryUsage memory_usage() const {
+        MemoryUsage usage;
+        if (m_root) {
+            measure(m_root, usage);
+        }
+        return usage;
+    }
+};
@@ -0,0 +1,346 @@
+#pragma once
+/*
+MIT License
+
+Copyright (c) 2022 Morgan McGuire and Zander Majercik
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "SIMDString.h"
+#include <algorithm>
+#include <atomic>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+/**
+   \brief Sorting of large arrays of strings by radix-sorting 8-byte prefixes.
+
+   std::sort of millions of SIMDStrings spends its time in compare() calls, each of which reaches
+   through data() to memcmp, and in moving the 80-byte objects at every swap. radix_sort_order()
+   instead reads each string once to make a key from its first 8 bytes, in big-endian order so that
+   integer order is memcmp order, and MSD radix sorts 16-byte (key, index) pairs one byte at a time.
+   Bytes that every string in a bucket shares, such as a common "assets/" root, are found with one
+   pass over the keys and skipped. Buckets whose keys are used up are given keys from the next 8 bytes of their
+   strings, and buckets of at most 32 strings are ordered by comparing keys and then the full strings.
+   radix_sort() and sort_unique() move each string once, into its final position.
+
+   The first distinguishing byte is partitioned with the histogram and scatter split across threads,
+   and then the threads take its buckets.
+
+   The order is that of std::string_view, so it is the same as std::sort with operator<. The sort is
+   stable. StringType may be any class with data() and size(), such as std::string.
+*/
+class SIMDStringSort {
+public:
+    /** Minimum number of strings per thread */
+    static constexpr size_t PARALLEL_THRESHOLD = 1 << 16;
+
+protected:
+
+    struct Item {
+        uint64_t    key;
+        uint32_t    index;
+    };
+
+    static constexpr size_t SMALL_BUCKET = 32;
+
+    /** A range of items whose strings match before byte depth + keyByte */
+    struct Bucket {
+        size_t      begin;
+        size_t      end;
+        size_t      depth;
+        int         keyByte;
+    };
+
+    static inline uint64_t prefixKey(const char* data, size_t size) {
+        uint64_t key = 0;
+        if (size) {
+            ::memcpy(&key, data, std::min<size_t>(size, 8));
+        }
+#       if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+            return key;
+#       elif defined(_MSC_VER)
+            return _byteswap_uint64(key);
+#       else
+            return __builtin_bswap64(key);
+#       endif
+    }
+
+    /** How many items ahead to prefetch strings when reading them in sorted order, which is random
+        order in memory */
+    static constexpr size_t PREFETCH_DISTANCE = 16;
+
+    static inline void prefetch(const void* p) {
+#       if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+            _mm_prefetch(static_cast<const char*>(p), _MM_HINT_T0);
+#       elif defined(__GNUC__) || defined(__clang__)
+            __builtin_prefetch(p);
+#       else
+            (void)p;
+#       endif
+    }
+
+    /** Strings by index, as string_views */
+    template<class StringType>
+    struct StringArray {
+        const StringType*   strings;
+
+        inline std::string_view operator()(uint32_t i) const {
+            return std::string_view(strings[i].data(), strings[i].size());
+        }
+
+        inline const void* address(uint32_t i) const {
+            return strings + i;
+        }
+    };
+
+    static inline size_t digit(uint64_t key, int keyByte) {
+        return size_t(key >> (56 - 8 * keyByte)) & 0xFF;
+    }
+
+    /** The first byte at or after keyByte that is set in varying, or 8 */
+    static inline int firstVaryingByte(uint64_t varying, int keyByte) {
+        while ((keyByte < 8) && (digit(varying, keyByte) == 0)) { ++keyByte; }
+        return keyByte;
+    }
+
+    /** Calls fn(t) for t in [0, threadCount), with t = 0 on the calling thread */
+    template<class Function>
+    static void forEachThread(unsigned int threadCount, Function fn) {
+        std::vector<std::thread> threads;
+        threads.reserve(threadCount - 1);
+        for (unsigned int t = 1; t < threadCount; ++t) {
+            threads.emplace_back(fn, t);
+        }
+        fn(0);
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    }
+
+    static unsigned int chooseThreadCount(size_t n, unsigned int threadCount) {
+        if (! threadCount) { threadCount = std::max(1u, std::thread::hardware_concurrency()); }
+        return (unsigned int)std::max<size_t>(1, std::min<size_t>(threadCount, n / PARALLEL_THRESHOLD));
+    }
+
+    /** Sorts the items of bucket, and the buckets it splits into, on the calling thread */
+    template<class View>
+    static void sortBucket(Item* items, Item* scratch, const Bucket& bucket, const View& view) {
+        std::vector<Bucket> stack = { bucket };
+        while (! stack.empty()) {
+            Bucket b = stack.back();
+            stack.pop_back();
+            Item* const first = items + b.begin;
+            Item* const last = items + b.end;
+            const size_t n = b.end - b.begin;
+
+            if (n <= SMALL_BUCKET) {
+                // Insertion sort, which is stable and does not allocate
+                for (Item* item = first + 1; item < last; ++item) {
+                    const Item x = *item;
+                    Item* hole = item;
+                    while ((hole != first) && ((x.key < hole[-1].key) || ((x.key == hole[-1].key) && (view(x.index) < view(hole[-1].index))))) {
+                        *hole = hole[-1];
+                        --hole;
+                    }
+                    *hole = x;
+                }
+                continue;
+            }
+
+            if (b.keyByte == 8) {
+                // The keys are equal. Continue with the next 8 bytes of the strings, counting the zero
+                // padding of shorter ones.
+                b.depth += 8;
+                b.keyByte = 0;
+                bool longer = false;
+                for (Item* item = first; item != last; ++item) {
+                    if (item + PREFETCH_DISTANCE < last) {
+                        prefetch(view.address(item[PREFETCH_DISTANCE].index));
+                    }
+                    const std::string_view s = view(item->index);
+                    longer = longer || (s.size() > b.depth);
+                    item->key = (s.size() > b.depth) ? prefixKey(s.data() + b.depth, s.size() - b.depth) : 0;
+                }
+                if (! longer) {
+                    // Equal up to their lengths, so the shorter ones are less
+                    std::stable_sort(first, last, [&](const Item& x, const Item& y) {
+                        return view(x.index).size() < view(y.index).size();
+                    });
+                    continue;
+                }
+            }
+
+            // Skip the bytes that every key in the bucket shares
+            uint64_t all = ~uint64_t(0), any = 0;
+            for (Item* item = first; item != last; ++item) {
+                all &= item->key;
+                any |= item->key;
+            }
+            const int keyByte = firstVaryingByte(all ^ any, b.keyByte);
+            if (keyByte == 8) {
+                stack.push_back({ b.begin, b.end, b.depth, 8 });
+                continue;
+            }
+
+            size_t count[256] = {};
+            for (Item* item = first; item != last; ++item) {
+                ++count[digit(item->key, keyByte)];
+            }
+
+            size_t next[256];
+            size_t offset = 0;
+            for (size_t d = 0; d < 256; ++d) {
+                next[d] = offset;
+                if (count[d] > 1) {
+                    stack.push_back({ b.begin + offset, b.begin + offset + count[d], b.depth, keyByte + 1 });
+                }
+                offset += count[d];
+            }
+            Item* const out = scratch + b.begin;
+            for (Item* item = first; item != last; ++item) {
+                out[next[digit(item->key, keyByte)]++] = *item;
+            }
+            std::copy(out, out + n, first);
+        }
+    }
+
+public:
+
+    /** Returns the permutation that sorts strings[0, count): strings[order[0]] is the least. Uses up to
+        threadCount threads (0 = hardware concurrency), with at least PARALLEL_THRESHOLD strings each. */
+    template<class StringType>
+    static std::vector<uint32_t> radix_sort_order(const StringType* strings, size_t count, unsigned int threadCount = 0) {
+        assert(count <= UINT32_MAX); // "SIMDStringSort is limited to 4G strings"
+        threadCount = chooseThreadCount(count, threadCount);
+        const size_t blockSize = (count + threadCount - 1) / threadCount;
+        const StringArray<StringType> view = { strings };
+
+        std::vector<Item> items(count);
+        std::vector<Item> scratch(count);
+        std::vector<uint64_t> all(threadCount, ~uint64_t(0)), any(threadCount, 0);
+        forEachThread(threadCount, [&](unsigned int t) {
+            const size_t last = std::min(count, (t + 1) * blockSize);
+            for (size_t i = t * blockSize; i < last; ++i) {
+                items[i].key = prefixKey(strings[i].data(), strings[i].size());
+                items[i].index = uint32_t(i);
+                all[t] &= items[i].key;
+                any[t] |= items[i].key;
+            }
+        });
+
+        // Partition on the first byte that differs between keys
+        uint64_t varying = 0;
+        for (unsigned int t = 0; t < threadCount; ++t) {
+            varying |= all[t] ^ any[t];
+        }
+        const int keyByte = firstVaryingByte(varying, 0);
+        if (count < 2) {
+            // Already sorted
+        } else if ((count <= SMALL_BUCKET) || (keyByte == 8)) {
+            sortBucket(items.data(), scratch.data(), { 0, count, 0, keyByte }, view);
+        } else {
+            std::vector<size_t> counts(size_t(threadCount) * 256, 0);
+            forEachThread(threadCount, [&](unsigned int t) {
+                size_t* c = counts.data() + size_t(t) * 256;
+                const size_t last = std::min(count, (t + 1) * blockSize);
+                for (size_t i = t * blockSize; i < last; ++i) {
+                    ++c[digit(items[i].key, keyByte)];
+                }
+            });
+
+            // Thread t's part of bucket d follows all lower buckets and the earlier threads' parts of d
+            std::vector<Bucket> buckets;
+            size_t offset = 0;
+            for (size_t d = 0; d < 256; ++d) {
+                const size_t begin = offset;
+                for (unsigned int t = 0; t < threadCount; ++t) {
+                    const size_t c = counts[size_t(t) * 256 + d];
+                    counts[size_t(t) * 256 + d] = offset;
+                    offset += c;
+                }
+                if (offset - begin > 1) {
+                    buckets.push_back({ begin, offset, 0, keyByte + 1 });
+                }
+            }
+
+            forEachThread(threadCount, [&](unsigned int t) {
+                size_t* next = counts.data() + size_t(t) * 256;
+                const size_t last = std::min(count, (t + 1) * blockSize);
+                for (size_t i = t * blockSize; i < last; ++i) {
+                    scratch[next[digit(items[i].key, keyByte)]++] = items[i];
+                }
+            });
+            items.swap(scratch);
+
+            // Largest buckets first, so that the threads finish together
+            std::sort(buckets.begin(), buckets.end(), [](const Bucket& x, const Bucket& y) {
+                return (x.end - x.begin) > (y.end - y.begin);
+            });
+            std::atomic<size_t> nextBucket(0);
+            forEachThread(threadCount, [&](unsigned int) {
+                for (size_t b = nextBucket++; b < buckets.size(); b = nextBucket++) {
+                    sortBucket(items.data(), scratch.data(), buckets[b], view);
+                }
+            });
+        }
+
+        std::vector<uint32_t> order(count);
+        for (size_t i = 0; i < count; ++i) {
+            order[i] = items[i].index;
+        }
+        return order;
+    }
+
+    /** Sorts strings in the order of operator< */
+    template<class StringType>
+    static void radix_sort(std::vector<StringType>& strings, unsigned int threadCount = 0) {
+        const std::vector<uint32_t> order = radix_sort_order(strings.data(), strings.size(), threadCount);
+        std::vector<StringType> sorted;
+        sorted.reserve(strings.size());
+        for (size_t k = 0; k < order.size(); ++k) {
+            if (k + PREFETCH_DISTANCE < order.size()) {
+                prefetch(strings.data() + order[k + PREFETCH_DISTANCE]);
+            }
+            sorted.push_back(std::move(strings[order[k]]));
+        }
+        strings.swap(sorted);
+    }
+
+    /** Sorts strings and removes duplicates, keeping one of each */
+    template<class StringType>
+    static void sort_unique(std::vector<StringType>& strings, unsigned int threadCount = 0) {
+        const std::vector<uint32_t> order = radix_sort_order(strings.data(), strings.size(), threadCount);
+        std::vector<StringType> sorted;
+        sorted.reserve(strings.size());
+        for (size_t k = 0; k < order.size(); ++k) {
+            if (k + PREFETCH_DISTANCE < order.size()) {
+                prefetch(strings.data() + order[k + PREFETCH_DISTANCE]);
+            }
+            const uint32_t i = order[k];
+            const std::string_view s(strings[i].data(), strings[i].size());
+            if (sorted.empty() || (std::string_view(sorted.back().data(), sorted.back().size()) != s)) {
+                sorted.push_back(std::move(strings[i]));
+            }
+        }
+        strings.swap(sorted);
+    }
+};
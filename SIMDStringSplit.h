@@ -0,0 +1,289 @@
+#pragma once
+/*
+MIT License
+
+Copyright (c) 2022 Morgan McGuire and Zander Majercik
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "SIMDString.h"
+#include <iterator>
+#include <string_view>
+
+/**
+   \brief A set of bytes that can search a buffer for its first member 16 bytes at a time.
+
+   Uses the nibble lookup technique: one shuffle maps the low nibble of each input byte to the set of
+   high nibbles that complete a member, a second maps the high nibble to its bit, and the byte is a
+   member if the two intersect. This is exact for ASCII members. Sets of two to four bytes, such as
+   " \t\r\n", instead compare against each member and need only SSE2. Larger sets containing bytes
+   >= 0x80 use a scalar bitmap, and single-byte sets use memchr.
+*/
+class ByteSet {
+protected:
+    uint64_t        m_bits[4] = {};
+    size_t          m_count = 0;
+    /** The first four members, in insertion order */
+    char            m_members[4] = {};
+    bool            m_ascii = true;
+    alignas(16) uint8_t m_lowNibble[16] = {};
+
+public:
+
+    ByteSet() {}
+
+    explicit ByteSet(std::string_view members) {
+        for (const char c : members) {
+            const uint8_t b = uint8_t(c);
+            if (contains(c)) { continue; }
+            m_bits[b >> 6] |= uint64_t(1) << (b & 63);
+            if (m_count < 4) { m_members[m_count] = c; }
+            ++m_count;
+            if (b >= 0x80) {
+                m_ascii = false;
+            } else {
+                m_lowNibble[b & 0x0F] |= uint8_t(1 << (b >> 4));
+            }
+        }
+    }
+
+    inline bool contains(char c) const {
+        const uint8_t b = uint8_t(c);
+        return (m_bits[b >> 6] >> (b & 63)) & 1;
+    }
+
+    inline size_t size() const {
+        return m_count;
+    }
+
+    /** Returns the first member of the set in [begin, end), or end */
+    const char* find(const char* begin, const char* end) const {
+        if (m_count == 0) {
+            return end;
+        } else if (m_count == 1) {
+            const char* found = static_cast<const char*>(::memchr(begin, m_members[0], size_t(end - begin)));
+            return found ? found : end;
+        }
+
+#       ifdef SIMDSTRING_SSE2
+            if (m_count <= 4) {
+                // Unused lanes repeat the first member, which does not change the result
+                const __m128i a = _mm_set1_epi8(m_members[0]);
+                const __m128i b = _mm_set1_epi8(m_members[1]);
+                const __m128i c = _mm_set1_epi8(m_members[m_count > 2 ? 2 : 0]);
+                const __m128i d = _mm_set1_epi8(m_members[m_count > 3 ? 3 : 0]);
+                for (; begin + 16 <= end; begin += 16) {
+                    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+                    const __m128i hit = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, a), _mm_cmpeq_epi8(v, b)),
+                                                     _mm_or_si128(_mm_cmpeq_epi8(v, c), _mm_cmpeq_epi8(v, d)));
+                    const unsigned int mask = (unsigned int)_mm_movemask_epi8(hit);
+                    if (mask) {
+                        return begin + countTrailingZeros(mask);
+                    }
+                }
+            }
+#       endif
+
+#       ifdef SIMDSTRING_SSSE3
+            if (m_ascii && (m_count > 4)) {
+                const __m128i lowTable = _mm_load_si128(reinterpret_cast<const __m128i*>(m_lowNibble));
+                // Bit h for high nibble h < 8, and nothing for bytes >= 0x80
+                const __m128i highTable = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 0, 0, 0, 0, 0, 0, 0, 0);
+                const __m128i nibbleMask = _mm_set1_epi8(0x0F);
+                const __m128i zero = _mm_setzero_si128();
+                for (; begin + 16 <= end; begin += 16) {
+                    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+                    const __m128i low = _mm_shuffle_epi8(lowTable, _mm_and_si128(v, nibbleMask));
+                    const __m128i high = _mm_shuffle_epi8(highTable, _mm_and_si128(_mm_srli_epi16(v, 4), nibbleMask));
+                    const unsigned int mask = ~(unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(low, high), zero)) & 0xFFFF;
+                    if (mask) {
+                        return begin + countTrailingZeros(mask);
+                    }
+                }
+            }
+#       endif
+
+        for (; begin < end; ++begin) {
+            if (contains(*begin)) { return begin; }
+        }
+        return end;
+    }
+};
+
+/** Options for split() */
+struct SplitOptions {
+    /** Omit empty tokens, such as those between adjacent delimiters */
+    bool    skipEmpty = false;
+
+    /** Remove ASCII whitespace from both ends of each token */
+    bool    trim = false;
+
+    /** If not '\0', a token that begins with this character extends to the next one, including any
+        delimiters in between, and is returned without the quotes. Characters between the closing
+        quote and the next delimiter are dropped. There is no escape sequence. */
+    char    quote = '\0';
+};
+
+/**
+   \brief Lazy range of the tokens of a string, as std::string_view slices of it.
+
+   Nothing is allocated or copied per token, and each token is found when the iterator advances,
+   so breaking out of a loop early does not scan the rest of the string. The string must outlive
+   the range and its tokens. Without SplitOptions::skipEmpty, n delimiters always produce n + 1
+   tokens, so an empty string has one empty token.
+
+   \code
+   for (std::string_view word : split(line, " ,;")) { ... }
+   \endcode
+*/
+class SplitRange {
+protected:
+    const char*     m_begin = nullptr;
+    const char*     m_end = nullptr;
+    ByteSet         m_delimiters;
+    SplitOptions    m_options;
+
+public:
+
+    class iterator {
+    protected:
+        friend class SplitRange;
+
+        const SplitRange*   m_range = nullptr;
+        /** Start of the text after the current token's delimiter, or nullptr after the last token */
+        const char*         m_next = nullptr;
+        std::string_view    m_token;
+
+        void advance() {
+            const char* const end = m_range->m_end;
+            const SplitOptions& options = m_range->m_options;
+
+            while (m_next) {
+                const char* p = m_next;
+                if (options.trim) {
+                    while ((p < end) && is_ascii_space(*p)) { ++p; }
+                }
+
+                const char* tokenBegin = p;
+                const char* tokenEnd;
+                bool quoted = false;
+                if (options.quote && (p < end) && (*p == options.quote)) {
+                    const char* close = static_cast<const char*>(::memchr(p + 1, options.quote, size_t(end - p - 1)));
+                    // An unterminated quote extends to the end of the string
+                    tokenBegin = p + 1;
+                    tokenEnd = close ? close : end;
+                    p = m_range->m_delimiters.find(close ? close + 1 : end, end);
+                    quoted = true;
+                } else {
+                    p = m_range->m_delimiters.find(p, end);
+                    tokenEnd = p;
+                    if (options.trim) {
+                        while ((tokenEnd > tokenBegin) && is_ascii_space(tokenEnd[-1])) { --tokenEnd; }
+                    }
+                }
+
+                m_next = (p < end) ? p + 1 : nullptr;
+                if (quoted || !options.skipEmpty || (tokenEnd > tokenBegin)) {
+                    m_token = std::string_view(tokenBegin, size_t(tokenEnd - tokenBegin));
+                    return;
+                }
+            }
+
+            // Past the last token
+            m_range = nullptr;
+        }
+
+        iterator(const SplitRange* range) : m_range(range), m_next(range->m_begin) {
+            advance();
+        }
+
+    public:
+
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = std::string_view;
+        using difference_type   = ptrdiff_t;
+        using pointer           = const std::string_view*;
+        using reference         = const std::string_view&;
+
+        iterator() {}
+
+        inline reference operator*() const { return m_token; }
+        inline pointer operator->() const { return &m_token; }
+
+        inline iterator& operator++() {
+            advance();
+            return *this;
+        }
+
+        inline iterator operator++(int) {
+            iterator old(*this);
+            advance();
+            return old;
+        }
+
+        /** Iterators over the same range are equal if they are at the same token, or both at the end */
+        inline bool operator==(const iterator& other) const {
+            return (m_range == other.m_range) && (!m_range || (m_token.data() == other.m_token.data()));
+        }
+
+        inline bool operator!=(const iterator& other) const {
+            return !(*this == other);
+        }
+    };
+
+    SplitRange(std::string_view text, std::string_view delimiters, const SplitOptions& options)
+        : m_begin(text.data()), m_end(text.data() + text.size()), m_delimiters(delimiters), m_options(options) {
+        if (! m_begin) {
+            // A default-constructed string_view has no storage, but still has one empty token
+            m_begin = m_end = "";
+        }
+    }
+
+    inline iterator begin() const {
+        return iterator(this);
+    }
+
+    inline iterator end() const {
+        return iterator();
+    }
+};
+
+/** Splits text at any of the characters in delimiters. See SplitRange. */
+inline SplitRange split(std::string_view text, std::string_view delimiters, const SplitOptions& options = SplitOptions()) {
+    return SplitRange(text, delimiters, options);
+}
+
+template<size_t INTERNAL_SIZE, class Allocator>
+SplitRange split(const SIMDString<INTERNAL_SIZE, Allocator>& str, std::string_view delimiters, const SplitOptions& options = SplitOptions()) {
+    return SplitRange(std::string_view(str.data(), str.size()), delimiters, options);
+}
+
+/** Splits a command line into whitespace-separated words, keeping "double quoted" phrases together */
+inline SplitRange tokens(std::string_view text) {
+    SplitOptions options;
+    options.skipEmpty = true;
+    options.quote = '"';
+    return SplitRange(text, " \t\n\v\f\r", options);
+}
+
+template<size_t INTERNAL_SIZE, class Allocator>
+SplitRange tokens(const SIMDString<INTERNAL_SIZE, Allocator>& str) {
+    return tokens(std::string_view(str.data(), str.size()));
+}
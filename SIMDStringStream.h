@@ -0,0 +1,145 @@
+#pragma once
+/*
+MIT License
+
+Copyright (c) 2022 Morgan McGuire and Zander Majercik
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "SIMDString.h"
+#include <ostream>
+#include <streambuf>
+#include <string_view>
+
+/**
+   \brief Output stream buffer that writes directly into a SIMDString.
+
+   The put area is the unused capacity of the string, obtained with SIMDString::append_uninitialized(),
+   so short messages are formatted into the string's internal buffer without any heap allocation and
+   longer ones grow through the string's usual allocation policy. take() moves the finished string out,
+   while reset() empties it but keeps its capacity for the next message.
+*/
+template<class StringType = SIMDString<>>
+class SIMDStringBuf : public std::streambuf {
+protected:
+    StringType      m_str;
+
+    /** Extends m_str over the characters written to the put area */
+    inline void commit() {
+        m_str.commit_append(size_t(pptr() - pbase()));
+        setp(pptr(), epptr());
+    }
+
+    /** Makes the put area cover the string's unused capacity, growing it to hold at least minimum more characters */
+    inline void openPutArea(size_t minimum) {
+        // append_uninitialized only reallocates when needed, and then grows geometrically
+        char* begin = m_str.append_uninitialized(minimum);
+        setp(begin, begin + (m_str.capacity() - m_str.size() - 1));
+    }
+
+    int_type overflow(int_type c) override {
+        commit();
+        if (traits_type::eq_int_type(c, traits_type::eof())) {
+            return traits_type::not_eof(c);
+        }
+        openPutArea(1);
+        *pptr() = traits_type::to_char_type(c);
+        pbump(1);
+        return c;
+    }
+
+    std::streamsize xsputn(const char* s, std::streamsize count) override {
+        if (count <= epptr() - pptr()) {
+            ::memcpy(pptr(), s, size_t(count));
+            pbump(int(count));
+        } else {
+            commit();
+            m_str.append(s, size_t(count));
+            openPutArea(0);
+        }
+        return count;
+    }
+
+    int sync() override {
+        commit();
+        return 0;
+    }
+
+public:
+
+    SIMDStringBuf() {
+        openPutArea(0);
+    }
+
+    SIMDStringBuf(const SIMDStringBuf&) = delete;
+    SIMDStringBuf& operator=(const SIMDStringBuf&) = delete;
+
+    /** The characters written so far. Invalidated by the next write. */
+    inline std::string_view view() const {
+        return std::string_view(m_str.data(), m_str.size() + size_t(pptr() - pbase()));
+    }
+
+    /** Moves the finished string out, leaving this buffer empty */
+    StringType take() {
+        commit();
+        StringType result(std::move(m_str));
+        m_str.clear();
+        openPutArea(0);
+        return result;
+    }
+
+    /** Empties the buffer while keeping its capacity, for reuse across messages */
+    void reset() {
+        m_str.clear();
+        openPutArea(0);
+    }
+};
+
+/**
+   \brief std::ostream that formats into a SIMDString through SIMDStringBuf, as an allocation-free
+   replacement for std::ostringstream followed by a copy of str().
+*/
+template<class StringType = SIMDString<>>
+class SIMDStringStream : public std::ostream {
+protected:
+    SIMDStringBuf<StringType>   m_buf;
+
+public:
+
+    SIMDStringStream() : std::ostream(nullptr) {
+        init(&m_buf);
+    }
+
+    /** The characters written so far. Invalidated by the next write. */
+    inline std::string_view view() const {
+        return m_buf.view();
+    }
+
+    /** Moves the finished string out, leaving the stream empty */
+    StringType take() {
+        return m_buf.take();
+    }
+
+    /** Empties the stream and clears its error state while keeping its capacity */
+    void reset() {
+        m_buf.reset();
+        clear();
+    }
+};
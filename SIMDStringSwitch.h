@@ -0,0 +1,263 @@
+#pragma once
+/*
+MIT License
+
+Copyright (c) 2022 Morgan McGuire and Zander Majercik
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "SIMDString.h"
+#include <algorithm>
+#include <stdexcept>
+#include <string_view>
+
+/** 64-bit FNV-1a, usable at compile time. std::hash is not constexpr, so compile-time tables cannot
+    share it. */
+constexpr uint64_t constexpr_string_hash(std::string_view s) {
+    uint64_t h = 14695981039346656037ULL;
+    for (const char c : s) {
+        h = (h ^ uint8_t(c)) * 1099511628211ULL;
+    }
+    return h;
+}
+
+/**
+   \brief A minimal perfect hash of N strings, built at compile time.
+
+   Maps each of the N keys to its index in the list passed to make_perfect_hash() with one string
+   hash, two table reads, and a single compare to reject strings that are not keys. This replaces
+   chains of if (name == "...") comparisons, each of which calls strlen, when dispatching on names.
+   Because find() is constexpr, its results for the keys can be case labels:
+
+   \code
+   static constexpr auto methods = make_perfect_hash({ "getName", "setName", "destroy" });
+   switch (methods.find(name)) {
+   case methods.find("getName"): ...
+   case methods.find("setName"): ...
+   default: // not a method
+   }
+   \endcode
+
+   Uses hash and displace: the FNV-1a hash of a key selects one of N buckets, and each bucket stores the
+   seed of a second hash that sends its keys to distinct free slots. The keys must be distinct and
+   must outlive the table, which is automatic for string literals.
+*/
+template<size_t N>
+class PerfectHash {
+    static_assert(N > 0, "PerfectHash requires at least one key");
+
+public:
+    static constexpr size_t npos = size_t(-1);
+
+protected:
+    std::string_view    m_keys[N] = {};
+    uint32_t            m_seeds[N] = {};
+    uint32_t            m_slotToKey[N] = {};
+
+    static constexpr size_t slot(uint64_t hash, uint32_t seed) {
+        // splitmix64 finalizer, so that each seed gives an independent-looking slot
+        uint64_t z = hash + (uint64_t(seed) + 1) * 0x9E3779B97F4A7C15ULL;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return size_t((z ^ (z >> 31)) % N);
+    }
+
+public:
+
+    explicit constexpr PerfectHash(const std::string_view (&keys)[N]) {
+        // Group the keys by bucket with a counting sort, so that each seed attempt visits only the
+        // bucket's own keys and the cost stays within compilers' constant-evaluation limits
+        uint64_t hashes[N] = {};
+        size_t bucketSize[N] = {};
+        for (size_t i = 0; i < N; ++i) {
+            m_keys[i] = keys[i];
+            hashes[i] = constexpr_string_hash(keys[i]);
+            ++bucketSize[hashes[i] % N];
+        }
+        size_t bucketStart[N + 1] = {};
+        for (size_t b = 0; b < N; ++b) {
+            bucketStart[b + 1] = bucketStart[b] + bucketSize[b];
+        }
+        size_t members[N] = {};
+        {
+            size_t next[N] = {};
+            for (size_t i = 0; i < N; ++i) {
+                const size_t b = hashes[i] % N;
+                members[bucketStart[b] + next[b]++] = i;
+            }
+        }
+
+        // Equal keys have equal hashes, so duplicates are within one bucket
+        size_t largestBucket = 0;
+        for (size_t b = 0; b < N; ++b) {
+            largestBucket = std::max(largestBucket, bucketSize[b]);
+            for (size_t m = bucketStart[b]; m < bucketStart[b + 1]; ++m) {
+                for (size_t n = bucketStart[b]; n < m; ++n) {
+                    if (keys[members[m]] == keys[members[n]]) {
+                        throw std::logic_error("PerfectHash keys must be distinct");
+                    }
+                }
+            }
+        }
+
+        // Place the largest buckets first, while there are the most free slots, again by counting sort
+        size_t sizeStart[N + 2] = {};
+        for (size_t b = 0; b < N; ++b) {
+            ++sizeStart[largestBucket - bucketSize[b] + 1];
+        }
+        for (size_t k = 1; k <= largestBucket + 1; ++k) {
+            sizeStart[k] += sizeStart[k - 1];
+        }
+        size_t order[N] = {};
+        for (size_t b = 0; b < N; ++b) {
+            order[sizeStart[largestBucket - bucketSize[b]]++] = b;
+        }
+
+        bool used[N] = {};
+        // Only the first bucketSize entries are used
+        size_t placed[N] = {};
+        for (size_t k = 0; (k < N) && (bucketSize[order[k]] > 0); ++k) {
+            const size_t b = order[k];
+            for (uint32_t seed = 0; ; ++seed) {
+                if (seed == (1u << 24)) {
+                    throw std::logic_error("No PerfectHash seed found");
+                }
+
+                // Tentatively place every key of bucket b
+                bool fits = true;
+                size_t placedCount = 0;
+                for (size_t m = bucketStart[b]; (m < bucketStart[b + 1]) && fits; ++m) {
+                    const size_t s = slot(hashes[members[m]], seed);
+                    fits = ! used[s];
+                    for (size_t p = 0; p < placedCount; ++p) {
+                        fits = fits && (placed[p] != s);
+                    }
+                    placed[placedCount++] = s;
+                }
+
+                if (fits) {
+                    m_seeds[b] = seed;
+                    for (size_t m = bucketStart[b]; m < bucketStart[b + 1]; ++m) {
+                        const size_t s = slot(hashes[members[m]], seed);
+                        used[s] = true;
+                        m_slotToKey[s] = uint32_t(members[m]);
+                    }
+                    break;
+                }
+            }
+        }
+    }
+
+    static constexpr size_t size() {
+        return N;
+    }
+
+    constexpr std::string_view key(size_t index) const {
+        return m_keys[index];
+    }
+
+    /** Index of s among the keys, or npos */
+    constexpr size_t find(std::string_view s) const {
+        const uint64_t hash = constexpr_string_hash(s);
+        const uint32_t index = m_slotToKey[slot(hash, m_seeds[hash % N])];
+        return (m_keys[index] == s) ? index : npos;
+    }
+
+    template<size_t INTERNAL_SIZE, class Allocator>
+    size_t find(const SIMDString<INTERNAL_SIZE, Allocator>& s) const {
+        return find(std::string_view(s.data(), s.size()));
+    }
+
+    constexpr size_t find(const char* s) const {
+        return find(std::string_view(s));
+    }
+};
+
+template<size_t N>
+constexpr PerfectHash<N> make_perfect_hash(const std::string_view (&keys)[N]) {
+    return PerfectHash<N>(keys);
+}
+
+/**
+   \brief Compile-time table of the names of an enum whose values are 0 through N - 1.
+
+   to_string() returns a constant-mode SIMDString that points at the name's string literal, without
+   probing inConstSegment() or copying, and from_string() parses a name through a PerfectHash. The names
+   are null-terminated strings, normally literals, so that to_string() never needs to copy.
+
+   \code
+   enum BlendMode { BLEND_OPAQUE, BLEND_ALPHA, BLEND_ADDITIVE };
+   static constexpr auto blendModeNames = make_enum_names<BlendMode>({ "OPAQUE", "ALPHA", "ADDITIVE" });
+   \endcode
+*/
+template<class Enum, size_t N>
+class EnumNames {
+protected:
+    PerfectHash<N>      m_hash;
+
+    struct Views {
+        std::string_view v[N];
+    };
+
+    static constexpr Views views(const char* const (&names)[N]) {
+        Views result;
+        for (size_t i = 0; i < N; ++i) { result.v[i] = std::string_view(names[i]); }
+        return result;
+    }
+
+public:
+
+    explicit constexpr EnumNames(const char* const (&names)[N]) : m_hash(views(names).v) {}
+
+    static constexpr size_t size() {
+        return N;
+    }
+
+    constexpr std::string_view name(Enum value) const {
+        return m_hash.key(size_t(value));
+    }
+
+    /** The name of value, which points at the name passed to make_enum_names() */
+    template<class StringType = SIMDString<>>
+    StringType to_string(Enum value) const {
+        const std::string_view n = name(value);
+        return StringType::borrow(n.data(), n.size());
+    }
+
+    /** Sets value and returns true if s is one of the names */
+    constexpr bool from_string(std::string_view s, Enum& value) const {
+        const size_t index = m_hash.find(s);
+        if (index == PerfectHash<N>::npos) {
+            return false;
+        }
+        value = Enum(index);
+        return true;
+    }
+
+    template<size_t INTERNAL_SIZE, class Allocator>
+    bool from_string(const SIMDString<INTERNAL_SIZE, Allocator>& s, Enum& value) const {
+        return from_string(std::string_view(s.data(), s.size()), value);
+    }
+};
+
+template<class Enum, size_t N>
+constexpr EnumNames<Enum, N> make_enum_names(const char* const (&names)[N]) {
+    return EnumNames<Enum, N>(names);
+}
@@ -0,0 +1,255 @@
+#pragma once
+/*
+MIT License
+
+Copyright (c) 2022 Morgan McGuire and Zander Majercik
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "SIMDString.h"
+#include <string_view>
+#include <vector>
+
+/** Finds the next ${key} placeholder in text at or after pos. Returns false if there is none. Otherwise
+    sets begin to the offset of the '$' and nameBegin/nameEnd to the offsets of the key, which is
+    everything between the braces. An unterminated "${" is not a placeholder. */
+inline bool find_placeholder(std::string_view text, size_t pos, size_t& begin, size_t& nameBegin, size_t& nameEnd) {
+    pos = text.find("${", pos);
+    if (pos == std::string_view::npos) {
+        return false;
+    }
+    const size_t close = text.find('}', pos + 2);
+    if (close == std::string_view::npos) {
+        return false;
+    }
+    begin = pos;
+    nameBegin = pos + 2;
+    nameEnd = close;
+    return true;
+}
+
+/** Looks up a placeholder's key in map. Returns false if it is absent. The key is converted to
+    Map::key_type, so std::string keys allocate for names that do not fit in their small-string buffer;
+    prefer std::string_view or SIMDString keys. */
+template<class Map>
+bool lookup_placeholder(const Map& map, std::string_view name, std::string_view& value) {
+    const auto it = map.find(typename Map::key_type(name.data(), name.size()));
+    if (it == map.end()) {
+        return false;
+    }
+    value = typename SIMDString<>::StringViewArg(it->second);
+    return true;
+}
+
+/**
+   Replaces each ${key} in text with map's value for key, such as an
+   std::unordered_map<std::string_view, SIMDString<>>. Placeholders whose key is not in map are copied
+   unchanged, and there is no escape sequence. The template is scanned and each key looked up once,
+   recording the replacements to compute the output length, and the result is allocated exactly once
+   and copied from those records.
+
+   For a template that is filled repeatedly, such as every frame, SIMDStringTemplate scans it only
+   once and looks up each distinct key once per fill.
+*/
+template<class StringType = SIMDString<>, class Map>
+StringType substitute(std::string_view text, const Map& map) {
+    struct Replacement {
+        size_t              begin;
+        size_t              end;
+        std::string_view    value;
+    };
+    // Replacements beyond the first CACHED_COUNT spill to the heap
+    constexpr size_t CACHED_COUNT = 32;
+    Replacement cached[CACHED_COUNT];
+    std::vector<Replacement> spilled;
+    size_t count = 0;
+
+    size_t length = text.size();
+    size_t pos = 0;
+    size_t begin, nameBegin, nameEnd;
+    std::string_view value;
+    while (find_placeholder(text, pos, begin, nameBegin, nameEnd)) {
+        pos = nameEnd + 1;
+        if (lookup_placeholder(map, text.substr(nameBegin, nameEnd - nameBegin), value)) {
+            const Replacement r = { begin, pos, value };
+            if (count < CACHED_COUNT) { cached[count] = r; } else { spilled.push_back(r); }
+            ++count;
+            length = length - (pos - begin) + value.size();
+        }
+    }
+
+    StringType result;
+    result.resize_and_overwrite(length, [&](char* dst, size_t) {
+        size_t read = 0;
+        for (size_t i = 0; i < count; ++i) {
+            const Replacement& r = (i < CACHED_COUNT) ? cached[i] : spilled[i - CACHED_COUNT];
+            ::memcpy(dst, text.data() + read, r.begin - read);
+            dst += r.begin - read;
+            if (! r.value.empty()) {
+                ::memcpy(dst, r.value.data(), r.value.size());
+                dst += r.value.size();
+            }
+            read = r.end;
+        }
+        if (read < text.size()) {
+            ::memcpy(dst, text.data() + read, text.size() - read);
+        }
+        return length;
+    });
+    return result;
+}
+
+/**
+   \brief A ${key} template that is parsed once and then filled many times.
+
+   The constructor records the offsets of the literal runs and placeholders and assigns each distinct
+   key an index. substitute() then resolves each key once, sums the lengths to allocate the result
+   exactly once, and copies the pieces without rescanning the template. Callers that fill the same
+   template every frame can skip the lookups entirely by passing values in key_index() order to fill().
+
+   \code
+   static const SIMDStringTemplate hud("Hello ${player}, you have ${n} coins");
+   SIMDString<> line = hud.substitute(values);
+   \endcode
+*/
+class SIMDStringTemplate {
+public:
+    static constexpr size_t npos = size_t(-1);
+
+protected:
+    /** A literal run of m_text followed by a placeholder, unless key is npos */
+    struct Segment {
+        size_t          literalBegin;
+        size_t          literalLength;
+        size_t          key;
+    };
+
+    SIMDString<>                m_text;
+    std::vector<Segment>        m_segments;
+    /** Distinct keys as slices of m_text, in order of first use */
+    std::vector<std::string_view> m_keys;
+    size_t                      m_literalSize = 0;
+
+    /** Copies the segments into dst. values[i] is the value of key i. */
+    template<class ValueArray>
+    char* write(char* dst, const ValueArray& values) const {
+        const char* const src = m_text.data();
+        for (const Segment& segment : m_segments) {
+            ::memcpy(dst, src + segment.literalBegin, segment.literalLength);
+            dst += segment.literalLength;
+            if (segment.key != npos) {
+                const std::string_view value = values[segment.key];
+                if (! value.empty()) {
+                    ::memcpy(dst, value.data(), value.size());
+                    dst += value.size();
+                }
+            }
+        }
+        return dst;
+    }
+
+    template<class StringType, class ValueArray>
+    StringType build(const ValueArray& values) const {
+        size_t length = m_literalSize;
+        for (const Segment& segment : m_segments) {
+            if (segment.key != npos) {
+                length += values[segment.key].size();
+            }
+        }
+
+        StringType result;
+        result.resize_and_overwrite(length, [&](char* dst, size_t) {
+            return size_t(write(dst, values) - dst);
+        });
+        return result;
+    }
+
+public:
+
+    explicit SIMDStringTemplate(std::string_view text) : m_text(text.data(), text.size()) {
+        const std::string_view view(m_text.data(), m_text.size());
+        size_t pos = 0;
+        size_t begin, nameBegin, nameEnd;
+        while (find_placeholder(view, pos, begin, nameBegin, nameEnd)) {
+            const std::string_view name = view.substr(nameBegin, nameEnd - nameBegin);
+            size_t key = key_index(name);
+            if (key == npos) {
+                key = m_keys.size();
+                m_keys.push_back(name);
+            }
+            m_segments.push_back({ pos, begin - pos, key });
+            m_literalSize += begin - pos;
+            pos = nameEnd + 1;
+        }
+        m_segments.push_back({ pos, view.size() - pos, npos });
+        m_literalSize += view.size() - pos;
+    }
+
+    // m_keys points into m_text, whose storage a copy would not share
+    SIMDStringTemplate(const SIMDStringTemplate&) = delete;
+    SIMDStringTemplate& operator=(const SIMDStringTemplate&) = delete;
+
+    /** Number of distinct keys */
+    inline size_t key_count() const {
+        return m_keys.size();
+    }
+
+    inline std::string_view key(size_t index) const {
+        return m_keys[index];
+    }
+
+    /** Index of name among the keys, or npos */
+    size_t key_index(std::string_view name) const {
+        for (size_t i = 0; i < m_keys.size(); ++i) {
+            if (m_keys[i] == name) { return i; }
+        }
+        return npos;
+    }
+
+    /** Fills the template with values[i] for key i, without any lookups. values must have key_count()
+        elements. */
+    template<class StringType = SIMDString<>>
+    StringType fill(const std::string_view* values) const {
+        return build<StringType>(values);
+    }
+
+    /** Fills the template with map's value for each key. Placeholders whose key is not in map are
+        copied unchanged, as with ::substitute(). */
+    template<class StringType = SIMDString<>, class Map>
+    StringType substitute(const Map& map) const {
+        // Resolve each key once, on the stack for typical templates
+        constexpr size_t STACK_KEYS = 32;
+        std::string_view stackValues[STACK_KEYS];
+        std::vector<std::string_view> heapValues;
+        std::string_view* values = stackValues;
+        if (m_keys.size() > STACK_KEYS) {
+            heapValues.resize(m_keys.size());
+            values = heapValues.data();
+        }
+
+        // A missing key is replaced by its own placeholder text, which is in m_text
+        for (size_t i = 0; i < m_keys.size(); ++i) {
+            if (! lookup_placeholder(map, m_keys[i], values[i])) {
+                values[i] = std::string_view(m_keys[i].data() - 2, m_keys[i].size() + 3);
+            }
+        }
+        return build<StringType>(values);
+    }
+};
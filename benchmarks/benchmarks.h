@@ -3,6 +3,31 @@
 
 #include <benchmark/benchmark.h>
 #include <sstream>
+#include <iomanip>
+#include <fstream>
+#include <filesystem>
+#include <atomic>
+#include <unordered_map>
+#include "MappedTextFile.h"
+#include "SIMDStringStream.h"
+#include "SIMDStringIO.h"
+#include "SIMDStringFormat.h"
+#include "SIMDStringSplit.h"
+#include "SIMDStringTemplate.h"
+#include "SIMDStringInterner.h"
+#include "SIMDStringSwitch.h"
+#include "SIMDStringRadixTree.h"
+#include "SIMDStringDictionary.h"
+#include "SIMDStringColumn.h"
+#include "SIMDStringHash.h"
+#include "SIMDStringSort.h"
+#include "SIMDStringMultiSearch.h"
+
+// libstdc++ implements the parallel algorithms with TBB, which must then be linked
+#if defined(_MSC_VER) || defined(BENCHMARK_PARALLEL_STL)
+#   include <execution>
+#   define BENCHMARK_HAS_EXECUTION
+#endif
 
 ////////////////////////////////////////////////////////////////////////////////////////
 // SIMDString benchmarks contains modified code from LLVM string benchmarks
@@ -457,14 +482,18 @@ static void BM_ConstCStrAt(benchmark::State& state)
 
 ////////////////////////////////////////////////////////////////////////////////////////
 // IO
+// The stream is rewound each iteration so that every iteration extracts state.range(0) characters
 template<class Str>
 static void BM_In(benchmark::State& state)
 {
     std::string tmp (state.range(0), '-');
     std::istringstream iss(tmp);
     Str s1;
-    for (auto _ : state)
+    for (auto _ : state) {
+        iss.clear();
+        iss.seekg(0);
         benchmark::DoNotOptimize(iss >> s1);
+    }
 }
 
 template<class Str>
@@ -473,8 +502,11 @@ static void BM_Getline(benchmark::State& state)
     std::string tmp (state.range(0), '-');
     std::istringstream iss(tmp);
     Str s1;
-    for (auto _ : state)
+    for (auto _ : state) {
+        iss.clear();
+        iss.seekg(0);
         benchmark::DoNotOptimize(getline(iss, s1));
+    }
 }
 
 template<class Str>
@@ -486,6 +518,211 @@ static void BM_Out(benchmark::State& state)
         benchmark::DoNotOptimize(oss << s1);
 }
 
+template<class Str>
+static void BM_OutFill(benchmark::State& state)
+{
+    std::ostringstream oss;
+    Str s1(CONST_C_STR);
+    for (auto _ : state) {
+        oss.seekp(0);
+        benchmark::DoNotOptimize(oss << std::setw(state.range(0)) << s1);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////
+// Conversions
+
+// Calls the to_string overload that produces Str
+template<class Str>
+struct BenchmarkToString {
+    template<class T>
+    static Str apply(T value) { return Str(std::to_string(value).c_str()); }
+};
+
+template<>
+struct BenchmarkToString<std::string> {
+    template<class T>
+    static std::string apply(T value) { return std::to_string(value); }
+};
+
+template<size_t INTERNAL_SIZE, class Allocator>
+struct BenchmarkToString<SIMDString<INTERNAL_SIZE, Allocator>> {
+    template<class T>
+    static SIMDString<INTERNAL_SIZE, Allocator> apply(T value) { return ::to_string<INTERNAL_SIZE, Allocator>(value); }
+};
+
+// Values of every length that IntType can represent, negated for signed types
+template<class IntType>
+static std::vector<IntType> BenchmarkIntegers()
+{
+    std::vector<IntType> values;
+    IntType value = 7;
+    for (int digits = 1; digits <= std::numeric_limits<IntType>::digits10; ++digits) {
+        values.push_back((std::is_signed_v<IntType> && (digits % 2 == 0)) ? IntType(0 - value) : value);
+        value = IntType(value * 10 + 3);
+    }
+    values.push_back(std::numeric_limits<IntType>::max());
+    values.push_back(std::numeric_limits<IntType>::min());
+    return values;
+}
+
+template<class Str, class IntType>
+static void BenchmarkIntToString(benchmark::State& state)
+{
+    const std::vector<IntType> values = BenchmarkIntegers<IntType>();
+    for (auto _ : state) {
+        for (IntType value : values) {
+            benchmark::DoNotOptimize(BenchmarkToString<Str>::apply(value));
+        }
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(values.size()));
+}
+
+template<class Str>
+static void BM_ToStringInt(benchmark::State& state) { BenchmarkIntToString<Str, int>(state); }
+
+template<class Str>
+static void BM_ToStringLong(benchmark::State& state) { BenchmarkIntToString<Str, long>(state); }
+
+template<class Str>
+static void BM_ToStringLongLong(benchmark::State& state) { BenchmarkIntToString<Str, long long>(state); }
+
+template<class Str>
+static void BM_ToStringUnsigned(benchmark::State& state) { BenchmarkIntToString<Str, unsigned int>(state); }
+
+template<class Str>
+static void BM_ToStringUnsignedLong(benchmark::State& state) { BenchmarkIntToString<Str, unsigned long>(state); }
+
+template<class Str>
+static void BM_ToStringUnsignedLongLong(benchmark::State& state) { BenchmarkIntToString<Str, unsigned long long>(state); }
+
+// UI and telemetry style values: mostly small magnitudes with a few digits, plus some extremes
+static std::vector<double> BenchmarkDoubles()
+{
+    std::vector<double> values;
+    uint32_t seed = 12345;
+    for (int i = 0; i < 64; ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        values.push_back((double(seed >> 8) / double(1 << 24) - 0.5) * 2000.0);
+    }
+    values.insert(values.end(), { 0.0, 0.1, 1.0 / 3.0, 1e-300, 6.02214076e23, -1.7976931348623157e308 });
+    return values;
+}
+
+template<class Str>
+static void BM_ToStringFloat(benchmark::State& state)
+{
+    std::vector<float> values;
+    for (double value : BenchmarkDoubles()) { values.push_back(float(std::max(-1e30, std::min(value, 1e30)))); }
+    for (auto _ : state) {
+        for (float value : values) {
+            benchmark::DoNotOptimize(BenchmarkToString<Str>::apply(value));
+        }
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(values.size()));
+}
+
+template<class Str>
+static void BM_ToStringDouble(benchmark::State& state)
+{
+    const std::vector<double> values = BenchmarkDoubles();
+    for (auto _ : state) {
+        for (double value : values) {
+            benchmark::DoNotOptimize(BenchmarkToString<Str>::apply(value));
+        }
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(values.size()));
+}
+
+// Calls the stoi and stod overloads that take Str
+template<class Str>
+struct BenchmarkParse {
+    static int stoi(const Str& str) { return std::stoi(std::string(str.c_str())); }
+    static double stod(const Str& str) { return std::stod(std::string(str.c_str())); }
+};
+
+template<>
+struct BenchmarkParse<std::string> {
+    static int stoi(const std::string& str) { return std::stoi(str); }
+    static double stod(const std::string& str) { return std::stod(str); }
+};
+
+template<size_t INTERNAL_SIZE, class Allocator>
+struct BenchmarkParse<SIMDString<INTERNAL_SIZE, Allocator>> {
+    static int stoi(const SIMDString<INTERNAL_SIZE, Allocator>& str) { return ::stoi(str); }
+    static double stod(const SIMDString<INTERNAL_SIZE, Allocator>& str) { return ::stod(str); }
+};
+
+template<class Str>
+static void BM_Stoi(benchmark::State& state)
+{
+    std::vector<Str> strings;
+    for (int value : BenchmarkIntegers<int>()) { strings.push_back(Str(std::to_string(value).c_str())); }
+    for (auto _ : state) {
+        for (const Str& str : strings) {
+            benchmark::DoNotOptimize(BenchmarkParse<Str>::stoi(str));
+        }
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(strings.size()));
+}
+
+template<class Str>
+static void BM_Stod(benchmark::State& state)
+{
+    std::vector<Str> strings;
+    char buffer[32];
+    for (double value : BenchmarkDoubles()) {
+        snprintf(buffer, sizeof(buffer), "%.17g", value);
+        strings.push_back(Str(buffer));
+    }
+    for (auto _ : state) {
+        for (const Str& str : strings) {
+            benchmark::DoNotOptimize(BenchmarkParse<Str>::stod(str));
+        }
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(strings.size()));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////
+// Text files
+
+// Returns the path of a generated ASCII file of about numBytes bytes with lines of 0-119 characters,
+// creating it on first use. The file is left in the temp directory for later runs.
+static std::string BenchmarkTextFile(size_t numBytes)
+{
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / ("SIMDStringBenchmark_" + std::to_string(numBytes) + ".txt");
+    std::error_code ec;
+    if (std::filesystem::file_size(path, ec) != numBytes) {
+        std::ofstream out(path, std::ios::binary);
+        std::string line;
+        size_t written = 0;
+        for (size_t i = 0; written < numBytes; ++i) {
+            line.assign(std::min((i * 7919) % 120, numBytes - written - 1), char('a' + (i % 26)));
+            line += '\n';
+            out.write(line.data(), line.size());
+            written += line.size();
+        }
+    }
+    return path.string();
+}
+
+template<class Str>
+static void BM_GetlineFile(benchmark::State& state)
+{
+    using std::getline;
+    const std::string filename = BenchmarkTextFile(state.range(0));
+    for (auto _ : state) {
+        std::ifstream in(filename, std::ios::binary);
+        Str s1;
+        size_t total = 0;
+        while (getline(in, s1)) {
+            total += s1.size();
+        }
+        benchmark::DoNotOptimize(total);
+    }
+    state.SetBytesProcessed(int64_t(state.iterations()) * state.range(0));
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////
 // Swap
 template<class Str>
@@ -579,7 +816,1310 @@ void RegisterBenchmarks(const char* classname) {
     REGISTER_BENCHMARK(BM_In)->Arg(0)->Arg(MAX_STRING_LEN);
     REGISTER_BENCHMARK(BM_Getline)->Arg(0)->Arg(MAX_STRING_LEN);
     REGISTER_BENCHMARK(BM_Out)->Arg(0)->Arg(MAX_STRING_LEN);
+    REGISTER_BENCHMARK(BM_OutFill)->Arg(0)->Arg(1024)->Arg(MAX_STRING_LEN);
+
+    ////////////////////////////////////////////////////////////////////////////////////
+    REGISTER_BENCHMARK(BM_ToStringInt);
+    REGISTER_BENCHMARK(BM_ToStringLong);
+    REGISTER_BENCHMARK(BM_ToStringLongLong);
+    REGISTER_BENCHMARK(BM_ToStringUnsigned);
+    REGISTER_BENCHMARK(BM_ToStringUnsignedLong);
+    REGISTER_BENCHMARK(BM_ToStringUnsignedLongLong);
+    REGISTER_BENCHMARK(BM_ToStringFloat);
+    REGISTER_BENCHMARK(BM_ToStringDouble);
+    REGISTER_BENCHMARK(BM_Stoi);
+    REGISTER_BENCHMARK(BM_Stod);
     
+    ////////////////////////////////////////////////////////////////////////////////////
+    REGISTER_BENCHMARK(BM_GetlineFile)->Arg(1 << 20)->Arg(1 << 30)->Unit(benchmark::kMillisecond);
+
+#undef REGISTER_BENCHMARK
+};
+
+////////////////////////////////////////////////////////////////////////////////////////
+// Benchmarks of SIMDString-specific extensions, which have no std::string equivalent.
+// Each is paired with a benchmark of the usual approach registered above or below.
+
+template<class Str>
+static void BM_MappedTextFileLines(benchmark::State& state)
+{
+    const std::string filename = BenchmarkTextFile(state.range(0));
+    for (auto _ : state) {
+        MappedTextFile file(filename.c_str());
+        size_t total = 0;
+        for (std::string_view line : file) {
+            total += line.size();
+        }
+        benchmark::DoNotOptimize(total);
+    }
+    state.SetBytesProcessed(int64_t(state.iterations()) * state.range(0));
+}
+
+template<class Str>
+static void BM_MappedTextFileBorrowedLines(benchmark::State& state)
+{
+    const std::string filename = BenchmarkTextFile(state.range(0));
+    MappedTextFile::Options options;
+    options.terminateLines = true;
+    for (auto _ : state) {
+        MappedTextFile file(filename.c_str(), options);
+        size_t total = 0;
+        for (size_t i = 0; i < file.lineCount(); ++i) {
+            const Str s1 = file.lineString<Str>(i);
+            total += s1.size();
+        }
+        benchmark::DoNotOptimize(total);
+    }
+    state.SetBytesProcessed(int64_t(state.iterations()) * state.range(0));
+}
+
+template<class Str>
+static void BM_MappedTextFileParallelLines(benchmark::State& state)
+{
+    const std::string filename = BenchmarkTextFile(state.range(0));
+    for (auto _ : state) {
+        MappedTextFile file(filename.c_str());
+        std::atomic<size_t> total(0);
+        file.parallelForEachLine([&total](size_t, std::string_view line) {
+            total.fetch_add(line.size(), std::memory_order_relaxed);
+        });
+        benchmark::DoNotOptimize(total.load());
+    }
+    state.SetBytesProcessed(int64_t(state.iterations()) * state.range(0));
+}
+
+// A typical log message
+#define FORMAT_LOG_MESSAGE(stream, i) (stream) << "Frame " << (i) << ": loaded " << CONST_C_STR_SIZE << " assets in " << 16.25 << " ms"
+
+template<class Str>
+static void BM_OStringStreamCopy(benchmark::State& state)
+{
+    int i = 0;
+    for (auto _ : state) {
+        std::ostringstream oss;
+        FORMAT_LOG_MESSAGE(oss, ++i);
+        Str s1(oss.str());
+        benchmark::DoNotOptimize(s1);
+    }
+}
+
+template<class Str>
+static void BM_SIMDStringStreamTake(benchmark::State& state)
+{
+    int i = 0;
+    for (auto _ : state) {
+        SIMDStringStream<Str> ss;
+        FORMAT_LOG_MESSAGE(ss, ++i);
+        Str s1(ss.take());
+        benchmark::DoNotOptimize(s1);
+    }
+}
+
+template<class Str>
+static void BM_SIMDStringStreamReuse(benchmark::State& state)
+{
+    int i = 0;
+    SIMDStringStream<Str> ss;
+    for (auto _ : state) {
+        ss.reset();
+        FORMAT_LOG_MESSAGE(ss, ++i);
+        benchmark::DoNotOptimize(ss.view());
+    }
+}
+
+#undef FORMAT_LOG_MESSAGE
+
+// HUD counters and list indices: to_string of values spread over [0, state.range(0)). Reports the fraction
+// that came from the precomputed small integer table as hit_rate.
+template<class Str>
+static void BM_ToStringCounters(benchmark::State& state)
+{
+    std::vector<int> values;
+    uint32_t seed = 12345;
+    for (int i = 0; i < 256; ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        values.push_back(int((seed >> 8) % uint32_t(state.range(0))));
+    }
+
+    int64_t hits = 0;
+    for (const int value : values) { hits += to_string(value).is_borrowed() ? 1 : 0; }
+
+    for (auto _ : state) {
+        for (const int value : values) {
+            const Str str = to_string(value);
+            benchmark::DoNotOptimize(str.data());
+        }
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(values.size()));
+    state.counters["hit_rate"] = double(hits) / double(values.size());
+}
+
+// Builds a comma-separated list of integers by appending a temporary to_string() result for each
+template<class Str>
+static void BM_AppendToString(benchmark::State& state)
+{
+    const std::vector<long long> values = BenchmarkIntegers<long long>();
+    Str s1;
+    for (auto _ : state) {
+        s1.clear();
+        for (long long value : values) {
+            s1 += BenchmarkToString<Str>::apply(value);
+            s1 += ',';
+        }
+        benchmark::DoNotOptimize(s1.data());
+    }
+}
+
+// Builds the same list as BM_AppendToString by formatting in place with to_chars()
+template<class Str>
+static void BM_ToCharsAppend(benchmark::State& state)
+{
+    const std::vector<long long> values = BenchmarkIntegers<long long>();
+    Str s1;
+    for (auto _ : state) {
+        s1.clear();
+        for (long long value : values) {
+            to_chars(s1, value);
+            s1 += ',';
+        }
+        benchmark::DoNotOptimize(s1.data());
+    }
+}
+
+// Shortest round-trip and fixed-precision formatting of doubles, compared with snprintf and std::to_chars
+// writing into a stack buffer. Each iteration formats every value of BenchmarkDoubles().
+template<class Str>
+static void BM_SnprintfRoundTrip(benchmark::State& state)
+{
+    const std::vector<double> values = BenchmarkDoubles();
+    char buffer[32];
+    for (auto _ : state) {
+        for (double value : values) {
+            benchmark::DoNotOptimize(snprintf(buffer, sizeof(buffer), "%.17g", value));
+        }
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(values.size()));
+}
+
+#ifdef __cpp_lib_to_chars
+template<class Str>
+static void BM_StdToCharsShortest(benchmark::State& state)
+{
+    const std::vector<double> values = BenchmarkDoubles();
+    char buffer[32];
+    for (auto _ : state) {
+        for (double value : values) {
+            benchmark::DoNotOptimize(std::to_chars(buffer, buffer + sizeof(buffer), value).ptr);
+        }
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(values.size()));
+}
+#endif
+
+template<class Str>
+static void BM_ToStringShortest(benchmark::State& state)
+{
+    const std::vector<double> values = BenchmarkDoubles();
+    for (auto _ : state) {
+        for (double value : values) {
+            benchmark::DoNotOptimize(to_string(value, std::chars_format::general));
+        }
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(values.size()));
+}
+
+template<class Str>
+static void BM_SnprintfFixed3(benchmark::State& state)
+{
+    const std::vector<double> values = BenchmarkDoubles();
+    char buffer[512];
+    for (auto _ : state) {
+        for (double value : values) {
+            benchmark::DoNotOptimize(snprintf(buffer, sizeof(buffer), "%.3f", value));
+        }
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(values.size()));
+}
+
+template<class Str>
+static void BM_ToStringFixed3(benchmark::State& state)
+{
+    const std::vector<double> values = BenchmarkDoubles();
+    for (auto _ : state) {
+        for (double value : values) {
+            benchmark::DoNotOptimize(to_string(value, std::chars_format::fixed, 3));
+        }
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(values.size()));
+}
+
+// A comma-separated tuning table of state.range(0) numbers with up to nine significant digits
+template<class Str>
+static Str BenchmarkNumberTable(size_t count)
+{
+    Str table;
+    const std::vector<double> values = BenchmarkDoubles();
+    for (size_t i = 0; i < count; ++i) {
+        to_chars(table, float(values[i % 64]), std::chars_format::general);
+        table += (i % 16 == 15) ? ",\n" : ",";
+    }
+    return table;
+}
+
+// Parses the table with strtof, the way a loader built on the C library would
+template<class Str>
+static void BM_StrtofTable(benchmark::State& state)
+{
+    const Str table = BenchmarkNumberTable<Str>(state.range(0));
+    std::vector<float> values;
+    for (auto _ : state) {
+        values.clear();
+        char* end = nullptr;
+        for (const char* p = table.c_str(); ; p = end + 1) {
+            const float value = ::strtof(p, &end);
+            if (end == p) { break; }
+            values.push_back(value);
+        }
+        benchmark::DoNotOptimize(values.data());
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(state.range(0)));
+}
+
+template<class Str>
+static void BM_ParseNumbersTable(benchmark::State& state)
+{
+    const Str table = BenchmarkNumberTable<Str>(state.range(0));
+    std::vector<float> values;
+    for (auto _ : state) {
+        values.clear();
+        // The newlines are whitespace after the ',' delimiters
+        parse_numbers<float>(table, std::back_inserter(values));
+        benchmark::DoNotOptimize(values.data());
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(state.range(0)));
+}
+
+// A HUD label built from string concatenation and to_string temporaries, snprintf, and format
+template<class Str>
+static void BM_HudConcat(benchmark::State& state)
+{
+    int hp = 0;
+    for (auto _ : state) {
+        hp = (hp + 7) % 1000;
+        const Str label = Str("HP: ") + to_string(hp) + "/" + to_string(1000) + " (" + to_string(hp * 0.1f, std::chars_format::fixed, 1) + "%)";
+        benchmark::DoNotOptimize(label.data());
+    }
+}
+
+template<class Str>
+static void BM_HudSnprintf(benchmark::State& state)
+{
+    int hp = 0;
+    char buffer[64];
+    for (auto _ : state) {
+        hp = (hp + 7) % 1000;
+        snprintf(buffer, sizeof(buffer), "HP: %d/%d (%.1f%%)", hp, 1000, hp * 0.1f);
+        const Str label(buffer);
+        benchmark::DoNotOptimize(label.data());
+    }
+}
+
+#if defined(__cpp_nontype_template_args) && (__cpp_nontype_template_args >= 201911L)
+template<class Str>
+static void BM_HudFormat(benchmark::State& state)
+{
+    int hp = 0;
+    for (auto _ : state) {
+        hp = (hp + 7) % 1000;
+        const Str label = format<"HP: {}/{} ({:.1f}%)", Str>(hp, 1000, hp * 0.1f);
+        benchmark::DoNotOptimize(label.data());
+    }
+}
+#endif
+
+// A row of state.range(0) comma- and tab-separated fields of 0-11 characters, as in ASCII data files
+template<class Str>
+static Str BenchmarkDelimitedRow(size_t fieldCount)
+{
+    Str row;
+    for (size_t i = 0; i < fieldCount; ++i) {
+        row.append(i % 12, char('a' + i % 26));
+        row += (i % 4 == 3) ? '\t' : ',';
+    }
+    return row;
+}
+
+// Splits with find_first_of and substr, creating a string per token
+template<class Str>
+static void BM_SplitSubstr(benchmark::State& state)
+{
+    const Str row = BenchmarkDelimitedRow<Str>(state.range(0));
+    std::vector<Str> fields;
+    for (auto _ : state) {
+        fields.clear();
+        size_t start = 0;
+        while (true) {
+            const size_t end = row.find_first_of(",\t", start);
+            fields.push_back(row.substr(start, (end == Str::npos) ? Str::npos : end - start));
+            if (end == Str::npos) { break; }
+            start = end + 1;
+        }
+        benchmark::DoNotOptimize(fields.data());
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(state.range(0)));
+}
+
+template<class Str>
+static void BM_SplitRange(benchmark::State& state)
+{
+    const Str row = BenchmarkDelimitedRow<Str>(state.range(0));
+    std::vector<std::string_view> fields;
+    for (auto _ : state) {
+        fields.clear();
+        for (std::string_view field : split(row, ",\t")) {
+            fields.push_back(field);
+        }
+        benchmark::DoNotOptimize(fields.data());
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(state.range(0)));
+}
+
+// Short log lines of 0-47 characters
+template<class Str>
+static std::vector<Str> BenchmarkLines(size_t count)
+{
+    std::vector<Str> lines;
+    lines.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        lines.push_back(Str((i * 7919) % 48, char('a' + (i % 26))));
+    }
+    return lines;
+}
+
+template<class Str>
+static void BM_OfstreamLines(benchmark::State& state)
+{
+    const std::vector<Str> lines = BenchmarkLines<Str>(state.range(0));
+    const std::string filename = (std::filesystem::temp_directory_path() / "SIMDStringBenchmark_lines.txt").string();
+    for (auto _ : state) {
+        std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+        for (const Str& line : lines) {
+            out << line << '\n';
+        }
+    }
+    std::filesystem::remove(filename);
+}
+
+#ifndef _WIN32
+template<class Str>
+static void BM_WriteAllLines(benchmark::State& state)
+{
+    const std::vector<Str> lines = BenchmarkLines<Str>(state.range(0));
+    const std::string filename = (std::filesystem::temp_directory_path() / "SIMDStringBenchmark_lines.txt").string();
+    for (auto _ : state) {
+        const int fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        benchmark::DoNotOptimize(write_all(fd, lines, "\n"));
+        ::close(fd);
+    }
+    std::filesystem::remove(filename);
+}
+#endif
+
+// Joins state.range(0) log lines with += in a loop
+template<class Str>
+static void BM_JoinAppendLoop(benchmark::State& state)
+{
+    const std::vector<Str> lines = BenchmarkLines<Str>(state.range(0));
+    for (auto _ : state) {
+        Str result;
+        for (size_t i = 0; i < lines.size(); ++i) {
+            if (i) { result += '\n'; }
+            result += lines[i];
+        }
+        benchmark::DoNotOptimize(result.data());
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(state.range(0)));
+}
+
+template<class Str>
+static void BM_Join(benchmark::State& state)
+{
+    const std::vector<Str> lines = BenchmarkLines<Str>(state.range(0));
+    for (auto _ : state) {
+        Str result = Str::join(lines, "\n");
+        benchmark::DoNotOptimize(result.data());
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(state.range(0)));
+}
+
+// A shader source with state.range(0) uses of a macro name
+template<class Str>
+static Str BenchmarkShaderSource(size_t uses)
+{
+    Str source;
+    for (size_t i = 0; i < uses; ++i) {
+        source += "    color += texture(SAMPLER, uv + offset";
+        source += to_string(int(i));
+        source += ");\n";
+    }
+    return source;
+}
+
+template<class Str>
+static void BM_FindReplaceLoop(benchmark::State& state)
+{
+    const Str source = BenchmarkShaderSource<Str>(state.range(0));
+    for (auto _ : state) {
+        Str result(source);
+        for (size_t pos = result.find("SAMPLER"); pos != Str::npos; pos = result.find("SAMPLER", pos + 10)) {
+            result.replace(pos, 7, "gBloomTex0");
+        }
+        benchmark::DoNotOptimize(result.data());
+    }
+}
+
+template<class Str>
+static void BM_ReplaceAll(benchmark::State& state)
+{
+    const Str source = BenchmarkShaderSource<Str>(state.range(0));
+    for (auto _ : state) {
+        Str result(source);
+        result.replace_all("SAMPLER", "gBloomTex0");
+        benchmark::DoNotOptimize(result.data());
+    }
+}
+
+static const char* const BENCHMARK_TEMPLATE = "Hello ${player}, you have ${n} coins and ${gems} gems. Level ${level}, ${zone}.";
+
+// Fills the template above with find() and replace() for each key
+template<class Str>
+static void BM_SubstituteFindReplace(benchmark::State& state)
+{
+    const std::pair<const char*, Str> values[] = {
+        { "${player}", "Ada" }, { "${n}", "1250" }, { "${gems}", "7" }, { "${level}", "12" }, { "${zone}", "The Sunken Library" } };
+    for (auto _ : state) {
+        Str result(BENCHMARK_TEMPLATE);
+        for (const auto& value : values) {
+            const size_t keyLength = ::strlen(value.first);
+            for (size_t pos = result.find(value.first); pos != Str::npos; pos = result.find(value.first, pos + value.second.size())) {
+                result.replace(pos, keyLength, value.second);
+            }
+        }
+        benchmark::DoNotOptimize(result.data());
+    }
+}
+
+template<class Str>
+static std::unordered_map<std::string_view, Str> BenchmarkTemplateValues()
+{
+    return { { "player", "Ada" }, { "n", "1250" }, { "gems", "7" }, { "level", "12" }, { "zone", "The Sunken Library" } };
+}
+
+template<class Str>
+static void BM_Substitute(benchmark::State& state)
+{
+    const std::unordered_map<std::string_view, Str> values = BenchmarkTemplateValues<Str>();
+    for (auto _ : state) {
+        Str result = substitute<Str>(BENCHMARK_TEMPLATE, values);
+        benchmark::DoNotOptimize(result.data());
+    }
+}
+
+template<class Str>
+static void BM_TemplateSubstitute(benchmark::State& state)
+{
+    const std::unordered_map<std::string_view, Str> values = BenchmarkTemplateValues<Str>();
+    const SIMDStringTemplate compiled(BENCHMARK_TEMPLATE);
+    for (auto _ : state) {
+        Str result = compiled.substitute<Str>(values);
+        benchmark::DoNotOptimize(result.data());
+    }
+}
+
+template<class Str>
+static void BM_TemplateFill(benchmark::State& state)
+{
+    const SIMDStringTemplate compiled(BENCHMARK_TEMPLATE);
+    const std::string_view values[] = { "Ada", "1250", "7", "12", "The Sunken Library" };
+    for (auto _ : state) {
+        Str result = compiled.fill<Str>(values);
+        benchmark::DoNotOptimize(result.data());
+    }
+}
+
+// 2000 distinct shader parameter names
+template<class Str>
+static std::vector<Str> BenchmarkParameterNames()
+{
+    std::vector<Str> names;
+    for (int i = 0; i < 2000; ++i) {
+        names.push_back(Str("u_material") + to_string(i % 50) + Str("_layer") + to_string(i / 50));
+    }
+    return names;
+}
+
+// Binds parameters by looking up their names in a map keyed by string
+template<class Str>
+static void BM_StringKeyLookup(benchmark::State& state)
+{
+    const std::vector<Str> names = BenchmarkParameterNames<Str>();
+    std::unordered_map<Str, int> bindings;
+    for (size_t i = 0; i < names.size(); ++i) {
+        bindings[names[i]] = int(i);
+    }
+    for (auto _ : state) {
+        int sum = 0;
+        for (const Str& name : names) {
+            sum += bindings.find(name)->second;
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(names.size()));
+}
+
+template<class Str>
+static void BM_SymbolKeyLookup(benchmark::State& state)
+{
+    SIMDStringInterner interner;
+    std::vector<Symbol> symbols;
+    std::unordered_map<Symbol, int> bindings;
+    for (const Str& name : BenchmarkParameterNames<Str>()) {
+        symbols.push_back(interner.intern(name));
+        bindings[symbols.back()] = int(symbols.size() - 1);
+    }
+    for (auto _ : state) {
+        int sum = 0;
+        for (Symbol symbol : symbols) {
+            sum += bindings.find(symbol)->second;
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(symbols.size()));
+}
+
+// Interns names that are already in the table, as when loading a scene
+template<class Str>
+static void BM_InternExisting(benchmark::State& state)
+{
+    const std::vector<Str> names = BenchmarkParameterNames<Str>();
+    SIMDStringInterner interner;
+    for (const Str& name : names) {
+        interner.intern(name);
+    }
+    for (auto _ : state) {
+        uint32_t sum = 0;
+        for (const Str& name : names) {
+            sum += interner.intern(name).id();
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(names.size()));
+}
+
+#define BENCHMARK_METHOD_NAMES "getName", "setName", "destroy", "getPosition", "setPosition", "clone", \
+    "getParent", "setParent", "findFirstChild", "isA", "getChildren", "getAttribute", "setAttribute", \
+    "getTags", "addTag", "removeTag", "hasTag", "getFullName", "waitForChild", "isDescendantOf"
+
+// Script calls cycling through the methods above, plus one that is not a method
+template<class Str>
+static std::vector<Str> BenchmarkMethodCalls()
+{
+    std::vector<Str> calls;
+    for (const char* name : { BENCHMARK_METHOD_NAMES, "notAMethod" }) {
+        calls.push_back(Str(std::string(name).c_str()));
+    }
+    return calls;
+}
+
+// Dispatches with a chain of comparisons to literals, as generated bindings do
+template<class Str>
+static void BM_DispatchIfChain(benchmark::State& state)
+{
+    const std::vector<Str> calls = BenchmarkMethodCalls<Str>();
+    static const char* const names[] = { BENCHMARK_METHOD_NAMES };
+    for (auto _ : state) {
+        int sum = 0;
+        for (const Str& name : calls) {
+            int method = -1;
+            for (int i = 0; i < int(sizeof(names) / sizeof(names[0])); ++i) {
+                if (name == names[i]) { method = i; break; }
+            }
+            sum += method;
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(calls.size()));
+}
+
+template<class Str>
+static void BM_DispatchPerfectHash(benchmark::State& state)
+{
+    const std::vector<Str> calls = BenchmarkMethodCalls<Str>();
+    static constexpr auto methods = make_perfect_hash({ BENCHMARK_METHOD_NAMES });
+    for (auto _ : state) {
+        int sum = 0;
+        for (const Str& name : calls) {
+            sum += int(methods.find(name));
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(calls.size()));
+}
+
+#undef BENCHMARK_METHOD_NAMES
+
+// count asset paths spread over 8 categories of 32 folders, in shuffled order
+template<class Str>
+static std::vector<Str> BenchmarkAssetPaths(size_t count)
+{
+    static const char* const categories[] = { "textures", "models", "sounds", "shaders", "animations", "fonts", "scripts", "particles" };
+    std::vector<Str> paths;
+    paths.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        const size_t n = (i * 2654435761u) % count;
+        paths.push_back(Str("assets/") + categories[n % 8] + "/set" + to_string(int(n / 8 % 32)) + "/asset" + to_string(int(n)) + ".bin");
+    }
+    return paths;
+}
+
+static const char* const BENCHMARK_ASSET_PREFIX = "assets/sounds/set17/";
+
+// Autocompletes a folder by testing every path
+template<class Str>
+static void BM_PrefixScan(benchmark::State& state)
+{
+    const std::vector<Str> paths = BenchmarkAssetPaths<Str>(state.range(0));
+    size_t matches = 0;
+    for (auto _ : state) {
+        matches = 0;
+        for (const Str& path : paths) {
+            matches += path.starts_with(BENCHMARK_ASSET_PREFIX);
+        }
+        benchmark::DoNotOptimize(matches);
+    }
+    state.counters["matches"] = double(matches);
+}
+
+template<class Str>
+static void BM_RadixTreePrefix(benchmark::State& state)
+{
+    SIMDStringRadixTree<uint32_t> tree;
+    {
+        const std::vector<Str> paths = BenchmarkAssetPaths<Str>(state.range(0));
+        for (size_t i = 0; i < paths.size(); ++i) {
+            tree.insert(paths[i], uint32_t(i));
+        }
+    }
+    size_t matches = 0;
+    for (auto _ : state) {
+        matches = 0;
+        tree.for_each_prefix(BENCHMARK_ASSET_PREFIX, [&](const SIMDString<>&, uint32_t) { ++matches; });
+        benchmark::DoNotOptimize(matches);
+    }
+    state.counters["matches"] = double(matches);
+
+    const typename SIMDStringRadixTree<uint32_t>::MemoryUsage usage = tree.memory_usage();
+    static const char* const names[] = { "node4", "node16", "node48", "node256", "leaf" };
+    for (int t = 0; t < SIMDStringRadixTree<uint32_t>::NODE_TYPE_COUNT; ++t) {
+        state.counters[names[t]] = double(usage.count[t]);
+    }
+    state.counters["MB"] = double(usage.totalBytes()) / (1024.0 * 1024.0);
+}
+
+// count localization keys with long shared prefixes, in shuffled order
+template<class Str>
+static std::vector<Str> BenchmarkLocalizationKeys(size_t count)
+{
+    static const char* const screens[] = { "ui.menu.options.audio.", "ui.menu.options.video.", "ui.hud.inventory.", "ui.dialog.quest." };
+    std::vector<Str> keys;
+    keys.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        const size_t n = (i * 2654435761u) % count;
+        keys.push_back(Str(screens[n % 4]) + "panel" + to_string(int(n / 4 % 64)) + ".widget" + to_string(int(n / 256)) + ".label");
+    }
+    return keys;
+}
+
+template<class Str>
+static void BM_LocalizationHashMap(benchmark::State& state)
+{
+    const std::vector<Str> keys = BenchmarkLocalizationKeys<Str>(state.range(0));
+    std::unordered_map<Str, uint32_t> table;
+    size_t bytes = 0;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        table[keys[i]] = uint32_t(i);
+        bytes += sizeof(Str) + ((keys[i].size() >= 64) ? keys[i].capacity() : 0);
+    }
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(table.find(keys[i]));
+        i = (i + 7919) % keys.size();
+    }
+    state.counters["keyBytes"] = double(bytes) / double(keys.size());
+}
+
+template<class Str>
+static void BM_LocalizationDictionary(benchmark::State& state)
+{
+    const std::vector<Str> keys = BenchmarkLocalizationKeys<Str>(state.range(0));
+    const SIMDStringDictionary dictionary = SIMDStringDictionary::build(keys);
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(dictionary.find(keys[i]));
+        i = (i + 7919) % keys.size();
+    }
+    state.counters["keyBytes"] = double(dictionary.bytes().size()) / double(keys.size());
+}
+
+// count entity names of 5-14 characters
+template<class Str>
+static std::vector<Str> BenchmarkEntityNames(size_t count)
+{
+    static const char* const kinds[] = { "npc_", "prop_", "light_", "trigger_" };
+    std::vector<Str> names;
+    names.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        names.push_back(Str(kinds[i % 4]) + to_string(int((i * 2654435761u) % 100000)));
+    }
+    return names;
+}
+
+// Filters names with a call per SIMDString, producing the same bitmask as the column
+template<class Str>
+static void BM_FilterStringVector(benchmark::State& state)
+{
+    const std::vector<Str> names = BenchmarkEntityNames<Str>(state.range(0));
+    SIMDStringColumn::Bitmask mask;
+    for (auto _ : state) {
+        mask.assign((names.size() + 63) / 64, 0);
+        for (size_t i = 0; i < names.size(); ++i) {
+            const bool hit = (state.range(1) == 0) ? (names[i] == "light_4242") : names[i].starts_with(std::string_view("trigger_"));
+            mask[i >> 6] |= uint64_t(hit) << (i & 63);
+        }
+        benchmark::DoNotOptimize(mask.data());
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(names.size()));
+}
+
+template<class Str>
+static void BM_FilterColumn(benchmark::State& state)
+{
+    SIMDStringColumn column;
+    for (const Str& name : BenchmarkEntityNames<Str>(state.range(0))) {
+        column.push_back(name);
+    }
+    SIMDStringColumn::Bitmask mask;
+    for (auto _ : state) {
+        if (state.range(1) == 0) {
+            column.equals("light_4242", mask);
+        } else {
+            column.starts_with("trigger_", mask);
+        }
+        benchmark::DoNotOptimize(mask.data());
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(column.size()));
+    state.counters["bytesPerString"] = double(column.bytes()) / double(column.size());
+}
+
+// Hashes the names one at a time, as when rebuilding a hash table keyed by them
+template<class Str>
+static void BM_HashLoop(benchmark::State& state)
+{
+    const std::vector<Str> names = BenchmarkEntityNames<Str>(state.range(0));
+    std::vector<size_t> hashes(names.size());
+    const std::hash<Str> hasher;
+    for (auto _ : state) {
+        for (size_t i = 0; i < names.size(); ++i) {
+            hashes[i] = hasher(names[i]);
+        }
+        benchmark::DoNotOptimize(hashes.data());
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(names.size()));
+}
+
+template<class Str>
+static void BM_HashBatch(benchmark::State& state)
+{
+    const std::vector<Str> names = BenchmarkEntityNames<Str>(state.range(0));
+    std::vector<size_t> hashes(names.size());
+    for (auto _ : state) {
+        hash_batch(names, hashes);
+        benchmark::DoNotOptimize(hashes.data());
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(names.size()));
+}
+
+// Sorts a shuffled asset manifest. The copy is made outside the timed region.
+template<class Str>
+static void BM_SortStd(benchmark::State& state)
+{
+    const std::vector<Str> paths = BenchmarkAssetPaths<Str>(state.range(0));
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::vector<Str> sorted = paths;
+        state.ResumeTiming();
+        std::sort(sorted.begin(), sorted.end());
+        benchmark::DoNotOptimize(sorted.data());
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(paths.size()));
+}
+
+#ifdef BENCHMARK_HAS_EXECUTION
+template<class Str>
+static void BM_SortStdParallel(benchmark::State& state)
+{
+    const std::vector<Str> paths = BenchmarkAssetPaths<Str>(state.range(0));
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::vector<Str> sorted = paths;
+        state.ResumeTiming();
+        std::sort(std::execution::par, sorted.begin(), sorted.end());
+        benchmark::DoNotOptimize(sorted.data());
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(paths.size()));
+}
+#endif
+
+// second argument: thread count
+template<class Str>
+static void BM_RadixSort(benchmark::State& state)
+{
+    const std::vector<Str> paths = BenchmarkAssetPaths<Str>(state.range(0));
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::vector<Str> sorted = paths;
+        state.ResumeTiming();
+        SIMDStringSort::radix_sort(sorted, (unsigned int)state.range(1));
+        benchmark::DoNotOptimize(sorted.data());
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(paths.size()));
+}
+
+// A symbol table in which most names appear several times
+template<class Str>
+static void BM_SortUniqueStd(benchmark::State& state)
+{
+    const std::vector<Str> names = BenchmarkEntityNames<Str>(state.range(0));
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::vector<Str> sorted = names;
+        state.ResumeTiming();
+        std::sort(sorted.begin(), sorted.end());
+        sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+        benchmark::DoNotOptimize(sorted.data());
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(names.size()));
+}
+
+template<class Str>
+static void BM_SortUnique(benchmark::State& state)
+{
+    const std::vector<Str> names = BenchmarkEntityNames<Str>(state.range(0));
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::vector<Str> sorted = names;
+        state.ResumeTiming();
+        SIMDStringSort::sort_unique(sorted, (unsigned int)state.range(1));
+        benchmark::DoNotOptimize(sorted.data());
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(names.size()));
+}
+
+// A multi-megabyte log dump of bytes characters with the needle only in the last line
+template<class Str>
+static Str BenchmarkLogDump(size_t bytes)
+{
+    Str log;
+    log.reserve(bytes + 64);
+    for (int i = 0; log.size() + 64 < bytes; ++i) {
+        log += "[frame ";
+        log += to_string(i);
+        log += "] physics step 1.25 ms, render 6.5 ms, 512 draw calls\n";
+    }
+    log += "[fatal] device lost\n";
+    return log;
+}
+
+// second argument: thread count
+template<class Str>
+static void BM_ParallelFind(benchmark::State& state)
+{
+    const Str log = BenchmarkLogDump<Str>(size_t(state.range(0)));
+    const SIMDStringParallel parallel = { (unsigned int)state.range(1) };
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(log.find("[fatal]", 0, parallel));
+    }
+    state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(log.size()));
+}
+
+template<class Str>
+static void BM_ParallelCount(benchmark::State& state)
+{
+    const Str log = BenchmarkLogDump<Str>(size_t(state.range(0)));
+    const SIMDStringParallel parallel = { (unsigned int)state.range(1) };
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(log.count('\n', parallel));
+    }
+    state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(log.size()));
+}
+
+template<class Str>
+static void BM_ParallelCopy(benchmark::State& state)
+{
+    const Str log = BenchmarkLogDump<Str>(size_t(state.range(0)));
+    const SIMDStringParallel parallel = { (unsigned int)state.range(1) };
+    for (auto _ : state) {
+        const Str copy(log, parallel);
+        benchmark::DoNotOptimize(copy.data());
+    }
+    state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(log.size()));
+}
+
+// count pseudorandom lowercase words of 5 to 10 letters, as a profanity or alert pattern set
+static std::vector<std::string> BenchmarkPatterns(size_t count)
+{
+    std::vector<std::string> patterns;
+    uint32_t r = 12345;
+    for (size_t i = 0; i < count; ++i) {
+        r = r * 1664525u + 1013904223u;
+        std::string word(5 + (r >> 24) % 6, ' ');
+        for (char& c : word) {
+            r = r * 1664525u + 1013904223u;
+            c = char('a' + (r >> 24) % 26);
+        }
+        patterns.push_back(word);
+    }
+    return patterns;
+}
+
+// 1000 chat messages of about 80 characters, every 50th containing one of the patterns
+template<class Str>
+static std::vector<Str> BenchmarkChatMessages(const std::vector<std::string>& patterns)
+{
+    static const char* const words[] = { "hello", "anyone", "up", "for", "a", "raid", "tonight", "lol", "gg", "that", "was", "close", "need", "healer", "brb" };
+    std::vector<Str> messages;
+    uint32_t r = 777;
+    for (int m = 0; m < 1000; ++m) {
+        Str message;
+        while (message.size() < 80) {
+            r = r * 1664525u + 1013904223u;
+            message += words[(r >> 24) % 15];
+            message += " ";
+        }
+        if (m % 50 == 0) {
+            message += patterns[(r >> 8) % patterns.size()].c_str();
+        }
+        messages.push_back(message);
+    }
+    return messages;
+}
+
+// argument: number of patterns
+template<class Str>
+static void BM_MultiPatternFindLoop(benchmark::State& state)
+{
+    const std::vector<std::string> patterns = BenchmarkPatterns(size_t(state.range(0)));
+    const std::vector<Str> messages = BenchmarkChatMessages<Str>(patterns);
+    std::vector<Str> needles;
+    for (const std::string& p : patterns) { needles.push_back(Str(p.c_str())); }
+    for (auto _ : state) {
+        int flagged = 0;
+        for (const Str& message : messages) {
+            for (const Str& needle : needles) {
+                if (message.find(needle) != Str::npos) {
+                    ++flagged;
+                    break;
+                }
+            }
+        }
+        benchmark::DoNotOptimize(flagged);
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(messages.size()));
+}
+
+template<class Str>
+static void BM_MultiPatternSearcher(benchmark::State& state)
+{
+    const std::vector<std::string> patterns = BenchmarkPatterns(size_t(state.range(0)));
+    const std::vector<Str> messages = BenchmarkChatMessages<Str>(patterns);
+    const MultiPatternSearcher searcher(patterns);
+    for (auto _ : state) {
+        int flagged = 0;
+        for (const Str& message : messages) {
+            flagged += searcher.contains_any(std::string_view(message.data(), message.size())) ? 1 : 0;
+        }
+        benchmark::DoNotOptimize(flagged);
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(messages.size()));
+}
+
+// 10000 log lines, and a needle of needleLength bytes that occurs only in the last one
+template<class Str>
+static void BenchmarkLogLines(size_t needleLength, std::vector<Str>& lines, Str& needle)
+{
+    std::string tail = "[fatal] device lost: ";
+    while (tail.size() < needleLength) {
+        tail += "queue 3 fence timeout ";
+    }
+    tail.resize(needleLength);
+    for (int i = 0; i < 10000; ++i) {
+        Str line("[frame ");
+        line += to_string(i);
+        line += "] physics step 1.25 ms, render 6.5 ms, 512 draw calls, textures/characters/hero_diffuse.png";
+        lines.push_back(line);
+    }
+    lines.back() += tail.c_str();
+    needle = Str(tail.c_str());
+}
+
+// argument: needle length
+template<class Str>
+static void BM_FindEach(benchmark::State& state)
+{
+    std::vector<Str> lines;
+    Str needle;
+    BenchmarkLogLines<Str>(size_t(state.range(0)), lines, needle);
+    for (auto _ : state) {
+        size_t found = 0;
+        for (const Str& line : lines) {
+            found += (line.find(needle) != Str::npos) ? 1 : 0;
+        }
+        benchmark::DoNotOptimize(found);
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(lines.size()));
+}
+
+template<class Str>
+static void BM_SearcherFindIn(benchmark::State& state)
+{
+    std::vector<Str> lines;
+    Str needle;
+    BenchmarkLogLines<Str>(size_t(state.range(0)), lines, needle);
+    const SIMDStringSearcher searcher(std::string_view(needle.data(), needle.size()));
+    for (auto _ : state) {
+        size_t found = 0;
+        for (const Str& line : lines) {
+            found += (searcher.find_in(std::string_view(line.data(), line.size())) != SIMDStringSearcher::npos) ? 1 : 0;
+        }
+        benchmark::DoNotOptimize(found);
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(lines.size()));
+}
+
+// Mixed-case asset paths, as typed in configs and console commands
+template<class Str>
+static std::vector<Str> BenchmarkMixedCasePaths(size_t count)
+{
+    static const char* const folders[] = { "Textures/Characters/", "models/Props/", "Shaders/PostFX/", "audio/SFX/" };
+    std::vector<Str> paths;
+    for (size_t i = 0; i < count; ++i) {
+        Str path(folders[i % 4]);
+        path += (i & 1) ? "Hero_Diffuse_" : "hero_NORMAL_";
+        path += to_string(int((i * 2654435761u) % 100000));
+        path += ".PNG";
+        paths.push_back(path);
+    }
+    return paths;
+}
+
+// Lowers a copy one character at a time, as before to_lower()
+template<class Str>
+static Str BenchmarkLowerCopy(const Str& s)
+{
+    Str lower(s);
+    for (size_t i = 0; i < lower.size(); ++i) {
+        lower[i] = char(::tolower((unsigned char)lower[i]));
+    }
+    return lower;
+}
+
+// argument: string length
+template<class Str>
+static void BM_ToLowerScalar(benchmark::State& state)
+{
+    const Str source = BenchmarkLogDump<Str>(size_t(state.range(0)));
+    Str s;
+    for (auto _ : state) {
+        s = source;
+        for (size_t i = 0; i < s.size(); ++i) {
+            s[i] = char(::tolower((unsigned char)s[i]));
+        }
+        benchmark::DoNotOptimize(s.data());
+    }
+    state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(source.size()));
+}
+
+template<class Str>
+static void BM_ToLower(benchmark::State& state)
+{
+    const Str source = BenchmarkLogDump<Str>(size_t(state.range(0)));
+    Str s;
+    for (auto _ : state) {
+        s = source;
+        s.to_lower();
+        benchmark::DoNotOptimize(s.data());
+    }
+    state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(source.size()));
+}
+
+// Case-insensitive equality and hashing of each path against its upper-case form
+template<class Str>
+static void BM_LowerCopyEqualsHash(benchmark::State& state)
+{
+    const std::vector<Str> paths = BenchmarkMixedCasePaths<Str>(1000);
+    std::vector<Str> upper = paths;
+    for (Str& p : upper) { p.to_upper(); }
+    const std::hash<Str> hasher;
+    for (auto _ : state) {
+        size_t matches = 0;
+        for (size_t i = 0; i < paths.size(); ++i) {
+            const Str a = BenchmarkLowerCopy(paths[i]);
+            const Str b = BenchmarkLowerCopy(upper[i]);
+            matches += (a == b) ? hasher(a) & 1 : 0;
+        }
+        benchmark::DoNotOptimize(matches);
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(paths.size()));
+}
+
+template<class Str>
+static void BM_IEqualsIHash(benchmark::State& state)
+{
+    const std::vector<Str> paths = BenchmarkMixedCasePaths<Str>(1000);
+    std::vector<Str> upper = paths;
+    for (Str& p : upper) { p.to_upper(); }
+    for (auto _ : state) {
+        size_t matches = 0;
+        for (size_t i = 0; i < paths.size(); ++i) {
+            matches += paths[i].iequals(upper[i]) ? paths[i].ihash() & 1 : 0;
+        }
+        benchmark::DoNotOptimize(matches);
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(paths.size()));
+}
+
+template <typename Str>
+void RegisterSIMDStringBenchmarks(const char* classname) {
+    char buffer[512];
+
+#   define REGISTER_BENCHMARK(fun) sprintf(buffer, "%s<%s>", #fun, classname);\
+        benchmark::RegisterBenchmark(buffer, fun<Str>)\
+
+    ////////////////////////////////////////////////////////////////////////////////////
+    REGISTER_BENCHMARK(BM_MappedTextFileLines)->Arg(1 << 20)->Arg(1 << 30)->Unit(benchmark::kMillisecond);
+    REGISTER_BENCHMARK(BM_MappedTextFileBorrowedLines)->Arg(1 << 20)->Arg(1 << 30)->Unit(benchmark::kMillisecond);
+    REGISTER_BENCHMARK(BM_MappedTextFileParallelLines)->Arg(1 << 20)->Arg(1 << 30)->Unit(benchmark::kMillisecond);
+
+    ////////////////////////////////////////////////////////////////////////////////////
+    REGISTER_BENCHMARK(BM_OStringStreamCopy);
+    REGISTER_BENCHMARK(BM_SIMDStringStreamTake);
+    REGISTER_BENCHMARK(BM_SIMDStringStreamReuse);
+
+    ////////////////////////////////////////////////////////////////////////////////////
+    REGISTER_BENCHMARK(BM_ToStringCounters)->Arg(100)->Arg(10000)->Arg(100000)->Arg(1000000000);
+    REGISTER_BENCHMARK(BM_AppendToString);
+    REGISTER_BENCHMARK(BM_ToCharsAppend);
+
+    ////////////////////////////////////////////////////////////////////////////////////
+    REGISTER_BENCHMARK(BM_SnprintfRoundTrip);
+#   ifdef __cpp_lib_to_chars
+    REGISTER_BENCHMARK(BM_StdToCharsShortest);
+#   endif
+    REGISTER_BENCHMARK(BM_ToStringShortest);
+    REGISTER_BENCHMARK(BM_SnprintfFixed3);
+    REGISTER_BENCHMARK(BM_ToStringFixed3);
+
+    ////////////////////////////////////////////////////////////////////////////////////
+    REGISTER_BENCHMARK(BM_StrtofTable)->Arg(1 << 20)->Unit(benchmark::kMillisecond);
+    REGISTER_BENCHMARK(BM_ParseNumbersTable)->Arg(1 << 20)->Unit(benchmark::kMillisecond);
+
+    ////////////////////////////////////////////////////////////////////////////////////
+    REGISTER_BENCHMARK(BM_JoinAppendLoop)->RangeMultiplier(10)->Range(10, 100000);
+    REGISTER_BENCHMARK(BM_Join)->RangeMultiplier(10)->Range(10, 100000);
+
+    ////////////////////////////////////////////////////////////////////////////////////
+    REGISTER_BENCHMARK(BM_FindReplaceLoop)->Arg(16)->Arg(1024);
+    REGISTER_BENCHMARK(BM_ReplaceAll)->Arg(16)->Arg(1024);
+    REGISTER_BENCHMARK(BM_SubstituteFindReplace);
+    REGISTER_BENCHMARK(BM_Substitute);
+    REGISTER_BENCHMARK(BM_TemplateSubstitute);
+    REGISTER_BENCHMARK(BM_TemplateFill);
+
+    ////////////////////////////////////////////////////////////////////////////////////
+    REGISTER_BENCHMARK(BM_StringKeyLookup);
+    REGISTER_BENCHMARK(BM_SymbolKeyLookup);
+    REGISTER_BENCHMARK(BM_InternExisting);
+
+    ////////////////////////////////////////////////////////////////////////////////////
+    REGISTER_BENCHMARK(BM_DispatchIfChain);
+    REGISTER_BENCHMARK(BM_DispatchPerfectHash);
+
+    ////////////////////////////////////////////////////////////////////////////////////
+    REGISTER_BENCHMARK(BM_PrefixScan)->Arg(1 << 20)->Unit(benchmark::kMicrosecond);
+    REGISTER_BENCHMARK(BM_RadixTreePrefix)->Arg(1 << 20)->Unit(benchmark::kMicrosecond);
+
+    ////////////////////////////////////////////////////////////////////////////////////
+    REGISTER_BENCHMARK(BM_LocalizationHashMap)->Arg(300000);
+    REGISTER_BENCHMARK(BM_LocalizationDictionary)->Arg(300000);
+
+    ////////////////////////////////////////////////////////////////////////////////////
+    // second argument: 0 for equals, 1 for starts_with
+    REGISTER_BENCHMARK(BM_FilterStringVector)->Args({1 << 20, 0})->Args({1 << 20, 1})->Unit(benchmark::kMicrosecond);
+    REGISTER_BENCHMARK(BM_FilterColumn)->Args({1 << 20, 0})->Args({1 << 20, 1})->Unit(benchmark::kMicrosecond);
+
+    ////////////////////////////////////////////////////////////////////////////////////
+    REGISTER_BENCHMARK(BM_HashLoop)->Arg(1 << 16);
+    REGISTER_BENCHMARK(BM_HashBatch)->Arg(1 << 16);
+
+    ////////////////////////////////////////////////////////////////////////////////////
+    REGISTER_BENCHMARK(BM_SortStd)->Arg(1 << 20)->Unit(benchmark::kMillisecond);
+#   ifdef BENCHMARK_HAS_EXECUTION
+        REGISTER_BENCHMARK(BM_SortStdParallel)->Arg(1 << 20)->Unit(benchmark::kMillisecond)->UseRealTime();
+#   endif
+    REGISTER_BENCHMARK(BM_RadixSort)->Args({1 << 20, 1})->Args({1 << 20, 0})->Unit(benchmark::kMillisecond)->UseRealTime();
+    REGISTER_BENCHMARK(BM_SortUniqueStd)->Arg(1 << 20)->Unit(benchmark::kMillisecond);
+    REGISTER_BENCHMARK(BM_SortUnique)->Args({1 << 20, 1})->Args({1 << 20, 0})->Unit(benchmark::kMillisecond)->UseRealTime();
+
+    ////////////////////////////////////////////////////////////////////////////////////
+    // second argument: thread count
+    REGISTER_BENCHMARK(BM_ParallelFind)->ArgsProduct({{64 << 20}, {1, 2, 4, 8, 16}})->Unit(benchmark::kMillisecond)->UseRealTime();
+    REGISTER_BENCHMARK(BM_ParallelCount)->ArgsProduct({{64 << 20}, {1, 2, 4, 8, 16}})->Unit(benchmark::kMillisecond)->UseRealTime();
+    REGISTER_BENCHMARK(BM_ParallelCopy)->ArgsProduct({{64 << 20}, {1, 2, 4, 8, 16}})->Unit(benchmark::kMillisecond)->UseRealTime();
+
+    ////////////////////////////////////////////////////////////////////////////////////
+    // argument: number of patterns
+    REGISTER_BENCHMARK(BM_MultiPatternFindLoop)->Arg(10)->Arg(1000)->Arg(100000)->Unit(benchmark::kMicrosecond);
+    REGISTER_BENCHMARK(BM_MultiPatternSearcher)->Arg(10)->Arg(1000)->Arg(100000)->Unit(benchmark::kMicrosecond);
+
+    ////////////////////////////////////////////////////////////////////////////////////
+    // argument: needle length
+    REGISTER_BENCHMARK(BM_FindEach)->Arg(4)->Arg(16)->Arg(64);
+    REGISTER_BENCHMARK(BM_SearcherFindIn)->Arg(4)->Arg(16)->Arg(64);
+
+    ////////////////////////////////////////////////////////////////////////////////////
+    // argument: string length
+    REGISTER_BENCHMARK(BM_ToLowerScalar)->Arg(64)->Arg(4096)->Arg(1 << 20);
+    REGISTER_BENCHMARK(BM_ToLower)->Arg(64)->Arg(4096)->Arg(1 << 20);
+    REGISTER_BENCHMARK(BM_LowerCopyEqualsHash);
+    REGISTER_BENCHMARK(BM_IEqualsIHash);
+
+    ////////////////////////////////////////////////////////////////////////////////////
+    REGISTER_BENCHMARK(BM_SplitSubstr)->Arg(16)->Arg(1024);
+    REGISTER_BENCHMARK(BM_SplitRange)->Arg(16)->Arg(1024);
+
+    ////////////////////////////////////////////////////////////////////////////////////
+    REGISTER_BENCHMARK(BM_HudConcat);
+    REGISTER_BENCHMARK(BM_HudSnprintf);
+#   if defined(__cpp_nontype_template_args) && (__cpp_nontype_template_args >= 201911L)
+    REGISTER_BENCHMARK(BM_HudFormat);
+#   endif
+
+    ////////////////////////////////////////////////////////////////////////////////////
+    REGISTER_BENCHMARK(BM_OfstreamLines)->Arg(1 << 20)->Unit(benchmark::kMillisecond);
+#   ifndef _WIN32
+    REGISTER_BENCHMARK(BM_WriteAllLines)->Arg(1 << 20)->Unit(benchmark::kMillisecond);
+#   endif
+
 #undef REGISTER_BENCHMARK
 };
 
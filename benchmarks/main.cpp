@@ -22,6 +22,7 @@
 int main(int argc, char* argv[]) {
     // __VA_ARGS_ is necessary because type templating messes up Macro argument parsing
 #   define REGISTER_CLASS_BENCHMARKS(...) RegisterBenchmarks<__VA_ARGS__>(#__VA_ARGS__)
+#   define REGISTER_SIMDSTRING_BENCHMARKS(...) RegisterSIMDStringBenchmarks<__VA_ARGS__>(#__VA_ARGS__)
 
     // Register benchmarks for each class
     REGISTER_CLASS_BENCHMARKS(std::string);
@@ -31,6 +32,9 @@ int main(int argc, char* argv[]) {
     REGISTER_CLASS_BENCHMARKS(SIMDString<64, G3D::g3d_allocator<char>>); 
 #   endif
 
+    // Register benchmarks for SIMDString-specific extensions
+    REGISTER_SIMDSTRING_BENCHMARKS(SIMDString<64, ::std::allocator<char>>);
+
 #   ifdef TEST_EASTL
     REGISTER_CLASS_BENCHMARKS(eastl::string); 
 #   endif
@@ -40,6 +44,7 @@ int main(int argc, char* argv[]) {
 #   endif 
 
 #   undef REGISTER_CLASS_BENCHMARKS
+#   undef REGISTER_SIMDSTRING_BENCHMARKS
 
     // Run benchmarks
     ::benchmark::Initialize(&argc, argv);
@@ -24,7 +24,28 @@ SOFTWARE.
 
 #include <gtest/gtest.h>
 #include <SIMDString.h>
+#include <MappedTextFile.h>
+#include <SIMDStringStream.h>
+#include <SIMDStringIO.h>
+#include <SIMDStringFormat.h>
+#include <SIMDStringSplit.h>
+#include <SIMDStringTemplate.h>
+#include <SIMDStringInterner.h>
+#include <SIMDStringSwitch.h>
+#include <SIMDStringRadixTree.h>
+#include <SIMDStringDictionary.h>
+#include <SIMDStringColumn.h>
+#include <SIMDStringHash.h>
+#include <SIMDStringSort.h>
+#include <SIMDStringMultiSearch.h>
 #include <string>
+#include <fstream>
+#include <filesystem>
+#include <atomic>
+#include <map>
+#include <set>
+#include <thread>
+#include <unordered_map>
 
 char sampleString[44] = "the quick brown fox jumps over the lazy dog";
 size_t sampleStringSize = strlen(sampleString);
@@ -599,6 +620,42 @@ TEST(SIMDStringTest, Replace)
   EXPECT_EQ(string1.length(), simdstring1.length());
 }
 
+TEST(SIMDStringTest, ReplaceAll){
+  // shrinking, in place
+  SIMDString<64> simdstring1("a--b--c----");
+  simdstring1.replace_all("--", "+");
+  EXPECT_STREQ("a+b+c++", simdstring1.c_str());
+  simdstring1.replace_all("+", "");
+  EXPECT_STREQ("abc", simdstring1.c_str());
+
+  // same length, on a constant segment string
+  SIMDString<64> simdstring2(sampleString);
+  simdstring2.replace_all("o", "0");
+  std::string string2(sampleString);
+  std::replace(string2.begin(), string2.end(), 'o', '0');
+  EXPECT_STREQ(string2.c_str(), simdstring2.c_str());
+
+  // growing, from the buffer into the heap
+  SIMDString<64> simdstring3("x.y.z");
+  simdstring3.replace_all(".", "::");
+  EXPECT_STREQ("x::y::z", simdstring3.c_str());
+  SIMDString<64> simdstring4(40, 'a');
+  simdstring4.replace_all("a", "bc");
+  std::string string4;
+  for (int i = 0; i < 40; ++i) {
+    string4 += "bc";
+  }
+  EXPECT_STREQ(string4.c_str(), simdstring4.c_str());
+
+  // occurrences do not overlap, and missing or empty patterns change nothing
+  SIMDString<64> simdstring5("aaaa");
+  simdstring5.replace_all("aa", "b");
+  EXPECT_STREQ("bb", simdstring5.c_str());
+  simdstring5.replace_all("c", "d");
+  simdstring5.replace_all("", "d");
+  EXPECT_STREQ("bb", simdstring5.c_str());
+}
+
 TEST(SIMDStringTest, ClearErase)
 {
   SIMDString<64> simdstring1(sampleString);
@@ -1177,6 +1234,13 @@ TEST(SIMDStringTest, Conversions)
   EXPECT_STREQ(simdstring1.c_str(), string1.c_str());
   EXPECT_EQ(simdstring1.size(), string1.size());
 
+  // Longer than the internal buffer of a small string
+  SIMDString<16> small = to_string<16>(LLONG_MIN);
+  EXPECT_STREQ(std::to_string(LLONG_MIN).c_str(), small.c_str());
+  small = to_string<16>(INT_MIN);
+  EXPECT_STREQ(std::to_string(INT_MIN).c_str(), small.c_str());
+  EXPECT_EQ(size_t(11), small.size());
+
 
   simdstring1 = to_string(0X1.BC70A3D70A3D7P+6f);
   string1 = std::to_string(0X1.BC70A3D70A3D7P+6f);
@@ -1246,6 +1310,170 @@ TEST(SIMDStringTest, Conversions)
   EXPECT_EQ(posSimdstring, posString);
 }
 
+// Compares to_string and to_chars with std::to_string at every power of ten that IntType can represent
+template<typename IntType>
+static void expectIntegerConversions() {
+  SIMDString<64> appended(sampleString);
+  std::string expected(sampleString);
+  for (IntType value = 1; ; value *= 10) {
+    for (IntType v : {IntType(value - 1), value, IntType(0 - value)}) {
+      EXPECT_STREQ(std::to_string(v).c_str(), to_string(v).c_str());
+      EXPECT_EQ(std::to_string(v).size(), to_string(v).size());
+      to_chars(appended, v);
+      expected += std::to_string(v);
+    }
+    if (value > std::numeric_limits<IntType>::max() / 10) { break; }
+  }
+  for (IntType v : {std::numeric_limits<IntType>::min(), std::numeric_limits<IntType>::max()}) {
+    EXPECT_STREQ(std::to_string(v).c_str(), to_string(v).c_str());
+    to_chars(appended, v);
+    expected += std::to_string(v);
+  }
+  EXPECT_STREQ(expected.c_str(), appended.c_str());
+  EXPECT_EQ(expected.size(), appended.size());
+}
+
+TEST(SIMDStringTest, IntegerConversions){
+  expectIntegerConversions<int>();
+  expectIntegerConversions<long>();
+  expectIntegerConversions<long long>();
+  expectIntegerConversions<unsigned int>();
+  expectIntegerConversions<unsigned long>();
+  expectIntegerConversions<unsigned long long>();
+
+  // to_chars returns the string so that appends can be chained
+  SIMDString<64> simdstring1("x=");
+  to_chars(to_chars(simdstring1, -12), 345u) += '!';
+  EXPECT_STREQ("x=-12345!", simdstring1.c_str());
+}
+
+TEST(SIMDStringTest, SmallIntegerTable){
+#if SIMDSTRING_SMALL_INT_COUNT > 0
+  // values in the table share its storage, like constant segment strings
+  SIMDString<64> simdstring1 = to_string(42);
+  EXPECT_TRUE(simdstring1.is_borrowed());
+  EXPECT_STREQ("42", simdstring1.c_str());
+  EXPECT_EQ(2, simdstring1.size());
+  SIMDString<64> simdstring2(simdstring1);
+  EXPECT_EQ(simdstring1.data(), simdstring2.data());
+  EXPECT_EQ(to_string(42u).data(), to_string(42ll).data());
+
+  // mutation copies out of the table
+  simdstring2 += '!';
+  EXPECT_STREQ("42!", simdstring2.c_str());
+  EXPECT_STREQ("42", to_string(42).c_str());
+
+  for (int value : {0, 9, 10, SIMDSTRING_SMALL_INT_COUNT - 1}) {
+    EXPECT_TRUE(to_string(value).is_borrowed());
+    EXPECT_STREQ(std::to_string(value).c_str(), to_string(value).c_str());
+  }
+  EXPECT_FALSE(to_string(-1).is_borrowed());
+  EXPECT_FALSE(to_string(SIMDSTRING_SMALL_INT_COUNT).is_borrowed());
+#endif
+
+  EXPECT_STREQ("true", bool_to_string(true).c_str());
+  EXPECT_STREQ("false", bool_to_string(false).c_str());
+  EXPECT_TRUE(bool_to_string(false).is_borrowed());
+}
+
+TEST(SIMDStringTest, FloatConversions){
+  // to_string matches std::to_string, including values too long for the internal buffer
+  for (double value : {0.0, -0.0, 1.5, -111.11, 1e-7, 123456789.125, 1e300, -1.7976931348623157e308}) {
+    EXPECT_STREQ(std::to_string(value).c_str(), to_string(value).c_str());
+    EXPECT_STREQ(std::to_string(float(value)).c_str(), to_string(float(value)).c_str());
+    EXPECT_STREQ(std::to_string((long double)value).c_str(), to_string((long double)value).c_str());
+  }
+  EXPECT_STREQ(std::to_string(1e4000L).c_str(), to_string(1e4000L).c_str());
+
+  // shortest round trip
+  EXPECT_STREQ("0.1", to_string(0.1, std::chars_format::general).c_str());
+  EXPECT_STREQ("0.1", to_string(0.1f, std::chars_format::general).c_str());
+  EXPECT_STREQ("1e+300", to_string(1e300, std::chars_format::general).c_str());
+  EXPECT_STREQ("1.25e-05", to_string(1.25e-5, std::chars_format::scientific).c_str());
+  EXPECT_STREQ("100", to_string(100.0, std::chars_format::fixed).c_str());
+  double value = 1.0;
+  for (int i = 0; i < 200; ++i) {
+    value = value * -3.7 + 1.0 / 7.0;
+    EXPECT_EQ(value, ::strtod(to_string(value, std::chars_format::general).c_str(), nullptr));
+  }
+
+  // explicit precision
+  EXPECT_STREQ("3.142", to_string(3.14159, std::chars_format::fixed, 3).c_str());
+  EXPECT_STREQ("3.14e+00", to_string(3.14159, std::chars_format::scientific, 2).c_str());
+  EXPECT_STREQ("3.1", to_string(3.14159f, std::chars_format::general, 2).c_str());
+
+  // to_chars appends
+  SIMDString<64> simdstring1(sampleString);
+  to_chars(to_chars(simdstring1, 0.5) += ' ', 2.5e10, std::chars_format::scientific, 1);
+  EXPECT_STREQ("the quick brown fox jumps over the lazy dog0.5 2.5e+10", simdstring1.c_str());
+  simdstring1.clear();
+  to_chars(simdstring1, 1e200, std::chars_format::fixed);
+  EXPECT_EQ(1e200, ::strtod(simdstring1.c_str(), nullptr));
+  EXPECT_LE(200, simdstring1.size());
+}
+
+TEST(SIMDStringTest, NumberParsing){
+  // same results and positions as the std:: versions
+  for (const char* text : {"0", "  +42abc", "-17", "\t\n 1234567", "7fffffff", "-80000000", "0x1f", "012", "9z"}) {
+    for (int base : {10, 16, 0}) {
+      size_t posSimdstring = 0, posString = 0;
+      EXPECT_EQ(std::stoi(std::string(text), &posString, base), stoi(SIMDString<64>(text), &posSimdstring, base));
+      EXPECT_EQ(posString, posSimdstring);
+      EXPECT_EQ(std::stoll(std::string(text), &posString, base), stoll(SIMDString<64>(text), &posSimdstring, base));
+      EXPECT_EQ(posString, posSimdstring);
+      EXPECT_EQ(std::stoul(std::string(text), &posString, base), stoul(SIMDString<64>(text), &posSimdstring, base));
+      EXPECT_EQ(posString, posSimdstring);
+    }
+  }
+  EXPECT_EQ(INT_MAX, stoi(SIMDString<64>("2147483647")));
+  EXPECT_EQ(INT_MIN, stoi(SIMDString<64>("-2147483648")));
+  for (const char* text : {"12345678901234567890", "0000000000000000000000000042", "18446744073709551615", "-1"}) {
+    size_t posSimdstring = 0, posString = 0;
+    EXPECT_EQ(std::stoull(std::string(text), &posString), stoull(SIMDString<64>(text), &posSimdstring));
+    EXPECT_EQ(posString, posSimdstring);
+  }
+  for (const char* text : {"3.25", "  -0.1e-3xyz", "+1e10", "-0x1.8p1", "0x", "0x-9", "-0x-23", "0x-1p4", "0x+5", "0x.8", "inf", "-nan", "1e-30"}) {
+    size_t posSimdstring = 0, posString = 0;
+    const double expected = std::stod(std::string(text), &posString);
+    const double value = stod(SIMDString<64>(text), &posSimdstring);
+    EXPECT_TRUE((expected == value) || ((expected != expected) && (value != value))) << text;
+    EXPECT_EQ(posString, posSimdstring) << text;
+    EXPECT_EQ(std::to_string(std::stof(std::string(text))), std::to_string(stof(SIMDString<64>(text)))) << text;
+  }
+
+  // errors
+  EXPECT_THROW(stoi(SIMDString<64>("")), std::invalid_argument);
+  EXPECT_THROW(stoi(SIMDString<64>(" - 1")), std::invalid_argument);
+  EXPECT_THROW(stoi(SIMDString<64>("2147483648")), std::out_of_range);
+  EXPECT_THROW(stoll(SIMDString<64>("-9223372036854775809")), std::out_of_range);
+  EXPECT_THROW(stoull(SIMDString<64>("18446744073709551616")), std::out_of_range);
+  EXPECT_THROW(stod(SIMDString<64>("+-1")), std::invalid_argument);
+  EXPECT_THROW(stod(SIMDString<64>("1e400")), std::out_of_range);
+  EXPECT_THROW(stof(SIMDString<64>("1e-50")), std::out_of_range);
+
+  // a stale errno does not leak into the result
+  errno = ERANGE;
+  EXPECT_EQ(5, stoi(SIMDString<64>("5")));
+  EXPECT_EQ(0.5, stod(SIMDString<64>("0.5")));
+
+  // batch parsing
+  std::vector<int> ints;
+  size_t errorPos = 0;
+  parse_numbers<int>(SIMDString<64>(" 1, -2 ,3,12345678901234,"), std::back_inserter(ints), ',', &errorPos);
+  EXPECT_EQ(std::vector<int>({1, -2, 3}), ints);
+  EXPECT_EQ(10, errorPos);
+
+  std::vector<float> floats;
+  parse_numbers<float>(std::string_view("0.5 1e3\n-2.25\n\n"), std::back_inserter(floats), '\n', &errorPos);
+  EXPECT_EQ(std::vector<float>({0.5f, 1e3f, -2.25f}), floats);
+  EXPECT_EQ(std::string_view::npos, errorPos);
+
+  double doubles[4];
+  const char table[] = "1.5;2.5;x";
+  EXPECT_EQ(doubles + 2, parse_numbers<double>(table, table + sizeof(table) - 1, doubles, ';', &errorPos));
+  EXPECT_EQ(8, errorPos);
+}
+
 TEST(SIMDStringTest, IO){
   std::istringstream iss1("Hello there!\nWho are you?");
   std::istringstream iss2("Hello there!\nWho are you?");
@@ -1300,6 +1528,86 @@ TEST(SIMDStringTest, IO){
   EXPECT_STREQ(oss1.str().c_str(), oss2.str().c_str());
 }
 
+// Serves a string through a get area of at most chunkSize characters, or unbuffered if chunkSize is 0
+class ChunkedStreambuf : public std::streambuf {
+  const char* m_next;
+  const char* m_end;
+  size_t      m_chunkSize;
+public:
+  ChunkedStreambuf(const char* s, size_t chunkSize) : m_next(s), m_end(s + strlen(s)), m_chunkSize(chunkSize) {}
+protected:
+  int_type underflow() override {
+    if (m_chunkSize == 0) {
+      return (m_next == m_end) ? traits_type::eof() : traits_type::to_int_type(*m_next);
+    }
+    if (gptr() < egptr()) return traits_type::to_int_type(*gptr());
+    if (m_next == m_end) return traits_type::eof();
+    char* begin = const_cast<char*>(m_next);
+    m_next = std::min(m_end, m_next + m_chunkSize);
+    setg(begin, begin, const_cast<char*>(m_next));
+    return traits_type::to_int_type(*gptr());
+  }
+  int_type uflow() override {
+    if (m_chunkSize != 0) return std::streambuf::uflow();
+    return (m_next == m_end) ? traits_type::eof() : traits_type::to_int_type(*m_next++);
+  }
+};
+
+TEST(SIMDStringTest, BulkIO){
+  const char* input = "  Hello\tthere!\nWho are you?\n\nI am a fairly long line that spans several chunks of the stream buffer\nlast";
+  for (size_t chunkSize : {0, 1, 5, 16, 1024}) {
+    ChunkedStreambuf buf1(input, chunkSize), buf2(input, chunkSize);
+    std::istream is1(&buf1), is2(&buf2);
+    SIMDString<64> simdstring1;
+    std::string string1;
+
+    is1 >> simdstring1;
+    is2 >> string1;
+    EXPECT_STREQ(string1.c_str(), simdstring1.c_str());
+
+    // width limits extraction
+    is1.width(3);
+    is2.width(3);
+    is1 >> simdstring1;
+    is2 >> string1;
+    EXPECT_STREQ(string1.c_str(), simdstring1.c_str());
+    EXPECT_EQ(is1.peek(), is2.peek());
+
+    while (std::getline(is2, string1)) {
+      EXPECT_TRUE(bool(getline(is1, simdstring1)));
+      EXPECT_STREQ(string1.c_str(), simdstring1.c_str());
+    }
+    EXPECT_FALSE(bool(getline(is1, simdstring1)));
+    EXPECT_EQ(is1.eof(), is2.eof());
+  }
+
+  // non-classic locale uses the ctype facet
+  std::istringstream iss1("one\xA0two three");
+  std::istringstream iss2("one\xA0two three");
+  struct NbspSpace : std::ctype<char> {
+    static const mask* makeTable() {
+      static std::vector<mask> table(classic_table(), classic_table() + table_size);
+      table[0xA0] |= space;
+      return table.data();
+    }
+    NbspSpace() : std::ctype<char>(makeTable()) {}
+  };
+  iss1.imbue(std::locale(std::locale::classic(), new NbspSpace));
+  iss2.imbue(std::locale(std::locale::classic(), new NbspSpace));
+  SIMDString<64> simdstring2;
+  std::string string2;
+  iss1 >> simdstring2;
+  iss2 >> string2;
+  EXPECT_STREQ("one", simdstring2.c_str());
+  EXPECT_STREQ(string2.c_str(), simdstring2.c_str());
+
+  // long fills
+  std::ostringstream oss1, oss2;
+  oss1 << std::setfill('.') << std::setw(200) << SIMDString<64>("right") << std::left << std::setw(150) << SIMDString<64>("left") << '|';
+  oss2 << std::setfill('.') << std::setw(200) << std::string("right") << std::left << std::setw(150) << std::string("left") << '|';
+  EXPECT_EQ(oss2.str(), oss1.str());
+}
+
 TEST(SIMDStringTest, Reserve){
   size_t largeSize = 1 << 21; 
   // test that reserve allocates exactly how much is expected + 1
@@ -1343,6 +1651,166 @@ TEST(SIMDStringTest, Reserve){
   EXPECT_STREQ(sampleString, simdstring1.c_str());
 }
 
+TEST(SIMDStringTest, ResizeAndOverwrite){
+  // in buffer, shrink
+  SIMDString<64> simdstring1("0123456789abcdefghijklmnopqrstuvwxyz", 36);
+  simdstring1.resize_and_overwrite(4, [](char* p, size_t) { p[0] = 'a'; return 1; });
+  EXPECT_EQ(1, simdstring1.size());
+  EXPECT_STREQ("a", simdstring1.c_str());
+
+  // in const segment, the original characters are still visible to op
+  simdstring1 = SIMDString<64>(sampleString);
+  simdstring1.resize_and_overwrite(sampleStringSize + 4, [](char* p, size_t n) {
+    ::memcpy(p + n - 4, "!!!!", 4);
+    return n;
+  });
+  EXPECT_EQ(sampleStringSize + 4, simdstring1.size());
+  EXPECT_EQ(0, ::memcmp(simdstring1.c_str(), sampleString, sampleStringSize));
+  EXPECT_STREQ("!!!!", simdstring1.c_str() + sampleStringSize);
+  EXPECT_STREQ(sampleString, "the quick brown fox jumps over the lazy dog");
+
+  // in const segment, shrinking must not copy past the new size
+  simdstring1 = SIMDString<64>(sampleStringLarge);
+  simdstring1.resize_and_overwrite(3, [](char*, size_t n) { return n; });
+  EXPECT_STREQ("Lor", simdstring1.c_str());
+
+  // A borrowed string shrunk in place is copied only up to the new size, which fits in the buffer
+  SIMDString<64> borrowed = SIMDString<64>::borrow(sampleStringLarge, sampleStringLargeSize);
+  borrowed.resize_and_overwrite(5, [](char*, size_t n) { return n; });
+  EXPECT_STREQ("Lorem", borrowed.c_str());
+  EXPECT_EQ(size_t(64), borrowed.capacity());
+
+  // grow to heap, allocating exactly the requested size
+  simdstring1.resize_and_overwrite(1000, [](char* p, size_t n) { ::memset(p + 3, '-', n - 3); return n; });
+  EXPECT_EQ(1000, simdstring1.size());
+  EXPECT_EQ(1001, simdstring1.capacity());
+  EXPECT_EQ(0, ::memcmp(simdstring1.c_str(), "Lor---", 6));
+  EXPECT_EQ('\0', simdstring1.c_str()[1000]);
+
+  // exactly INTERNAL_SIZE characters need one more byte than the buffer, and get exactly that
+  SIMDString<64> full("0123");
+  full.resize_and_overwrite(64, [](char* p, size_t n) { ::memset(p + 4, 'x', n - 4); return n; });
+  EXPECT_EQ(64, full.size());
+  EXPECT_EQ(65, full.capacity());
+  EXPECT_EQ(0, ::memcmp(full.c_str(), "0123xxxx", 8));
+
+  // append_uninitialized and commit_append
+  SIMDString<64> simdstring2(sampleString);
+  char* out = simdstring2.append_uninitialized(500);
+  EXPECT_EQ(sampleStringSize, simdstring2.size());
+  EXPECT_STREQ(sampleString, simdstring2.c_str());
+  ::memcpy(out, " and the cat", 12);
+  simdstring2.commit_append(12);
+  EXPECT_EQ(sampleStringSize + 12, simdstring2.size());
+  EXPECT_STREQ("the quick brown fox jumps over the lazy dog and the cat", simdstring2.c_str());
+  EXPECT_LE(sampleStringSize + 500, simdstring2.capacity());
+
+  SIMDString<64> simdstring3;
+  out = simdstring3.append_uninitialized(2);
+  out[0] = 'x';
+  simdstring3.commit_append(1);
+  EXPECT_STREQ("x", simdstring3.c_str());
+}
+
+TEST(SIMDStringTest, Borrow){
+  // simulate a string table loaded from an asset pack
+  const size_t tableSize = sampleStringLargeSize + 1 + 6;
+  char* table = new char[tableSize];
+  ::memcpy(table, sampleStringLarge, sampleStringLargeSize + 1);
+  ::memcpy(table + sampleStringLargeSize + 1, "hello", 6);
+  registerBorrowedBuffer(table, tableSize);
+
+  SIMDString<64> simdstring1 = SIMDString<64>::borrow(table, sampleStringLargeSize);
+  EXPECT_TRUE(simdstring1.is_borrowed());
+  EXPECT_EQ(table, simdstring1.c_str());
+  EXPECT_EQ(sampleStringLargeSize, simdstring1.size());
+
+  SIMDString<64> simdstring2 = SIMDString<64>::borrow(table + sampleStringLargeSize + 1);
+  EXPECT_EQ(table + sampleStringLargeSize + 1, simdstring2.c_str());
+  EXPECT_STREQ("hello", simdstring2.c_str());
+
+  // copies share the borrowed pointer
+  SIMDString<64> simdstring3(simdstring1);
+  EXPECT_EQ(table, simdstring3.c_str());
+  simdstring3 = simdstring2;
+  EXPECT_EQ(simdstring2.c_str(), simdstring3.c_str());
+
+  // mutation copies and leaves the table untouched
+  simdstring3 += " world";
+  EXPECT_FALSE(simdstring3.is_borrowed());
+  EXPECT_STREQ("hello world", simdstring3.c_str());
+  EXPECT_STREQ("hello", table + sampleStringLargeSize + 1);
+
+  simdstring1[0] = 'l';
+  EXPECT_NE(table, simdstring1.c_str());
+  EXPECT_EQ('L', table[0]);
+  EXPECT_EQ('l', simdstring1[0]);
+
+  // not null terminated, so it must be copied
+  SIMDString<64> simdstring4 = SIMDString<64>::borrow(table, 5);
+  EXPECT_FALSE(simdstring4.is_borrowed());
+  EXPECT_STREQ("Lorem", simdstring4.c_str());
+
+#if SIMDSTRING_TRACK_BORROWS && GTEST_HAS_DEATH_TEST
+  unregisterBorrowedBuffer(table);
+  EXPECT_DEATH(simdstring2.c_str(), "");
+  EXPECT_STREQ("hello world", simdstring3.c_str());
+  registerBorrowedBuffer(table, tableSize);
+  EXPECT_STREQ("hello", simdstring2.c_str());
+#endif
+
+  unregisterBorrowedBuffer(table);
+  delete[] table;
+
+#if SIMDSTRING_TRACK_BORROWS
+  // Only the most recently unloaded buffers are remembered
+  static char chunks[300][8];
+  for (auto& chunk : chunks) {
+    registerBorrowedBuffer(chunk, sizeof(chunk) - 1);
+    unregisterBorrowedBuffer(chunk);
+  }
+  EXPECT_TRUE(borrowedPointerIsLive(chunks[0]));
+  EXPECT_TRUE(borrowedPointerIsLive(chunks[43] + 3));
+  EXPECT_FALSE(borrowedPointerIsLive(chunks[44] + 3));
+  EXPECT_FALSE(borrowedPointerIsLive(chunks[150] + 7));
+  EXPECT_FALSE(borrowedPointerIsLive(chunks[299]));
+  EXPECT_TRUE(borrowedPointerIsLive(sampleString));
+#endif
+}
+
+TEST(SIMDStringTest, Join){
+  std::vector<SIMDString<64>> fields = { "x", "y", "z" };
+  SIMDString<64> simdstring1 = SIMDString<64>::join(fields, ", ");
+  EXPECT_STREQ("x, y, z", simdstring1.c_str());
+  // fits, so it is in the internal buffer
+  EXPECT_EQ(64, simdstring1.capacity());
+
+  std::vector<std::string_view> views = { "a", "", "b" };
+  EXPECT_STREQ("a--b", SIMDString<64>::join(views, "-").c_str());
+  EXPECT_STREQ("ab", SIMDString<64>::join(views).c_str());
+
+  std::vector<const char*> literals = { "only" };
+  EXPECT_STREQ("only", SIMDString<64>::join(literals, ", ").c_str());
+  EXPECT_TRUE(SIMDString<64>::join(std::vector<std::string>(), ", ").empty());
+
+  // mixed element types, including a SIMDString of another size
+  SIMDString<16> directory("shaders");
+  std::string name("blur");
+  SIMDString<64> simdstring2 = SIMDString<64>::join({ directory, std::string_view("common"), name, "frag.glsl" }, "/");
+  EXPECT_STREQ("shaders/common/blur/frag.glsl", simdstring2.c_str());
+
+  // large results are allocated exactly once
+  std::vector<SIMDString<64>> lines(1000, SIMDString<64>(sampleString));
+  SIMDString<64> simdstring3 = SIMDString<64>::join(lines, "\n");
+  EXPECT_EQ(1000 * sampleStringSize + 999, simdstring3.size());
+  EXPECT_EQ(simdstring3.size() + 1, simdstring3.capacity());
+  EXPECT_EQ('\n', simdstring3[sampleStringSize]);
+
+  // a result of exactly INTERNAL_SIZE characters
+  std::vector<std::string_view> eights(8, "01234567");
+  EXPECT_EQ(65, SIMDString<64>::join(eights).capacity());
+}
+
 TEST(SIMDStringTest, Hash){
   SIMDString<64> simdstring1(sampleString);
   std::string string1(sampleString);
@@ -1369,4 +1837,1007 @@ TEST(SIMDStringTest, RangeLoops){
   }
 
   EXPECT_STREQ(result1.c_str(), result2.c_str());
-}
\ No newline at end of file
+}
+
+TEST(MappedTextFileTest, Lines){
+  const std::string filename = (std::filesystem::temp_directory_path() / "SIMDStringTest_MappedTextFile.txt").string();
+  const char* contents = "first line\r\n\nthe quick brown fox jumps over the lazy dog\n,comma,separated,\nlast";
+  {
+    std::ofstream out(filename, std::ios::binary);
+    out << contents;
+  }
+
+  std::vector<std::string> expected;
+  {
+    std::ifstream in(filename, std::ios::binary);
+    std::string line;
+    while (std::getline(in, line)) {
+      if (!line.empty() && line.back() == '\r') line.pop_back();
+      expected.push_back(line);
+    }
+  }
+
+  MappedTextFile file;
+  EXPECT_FALSE(file.open("this file does not exist"));
+  ASSERT_TRUE(file.open(filename.c_str()));
+  EXPECT_EQ(strlen(contents), file.size());
+  ASSERT_EQ(expected.size(), file.lineCount());
+  for (size_t i = 0; i < expected.size(); ++i) {
+    EXPECT_EQ(expected[i], file.line(i));
+    EXPECT_STREQ(expected[i].c_str(), file.lineString(i).c_str());
+  }
+  EXPECT_EQ(expected.size(), size_t(std::distance(file.begin(), file.end())));
+  EXPECT_EQ("first line", *file.begin());
+
+  // terminated lines are borrowed from the private mapping, except for the unterminated last line
+  MappedTextFile::Options options;
+  options.terminateLines = true;
+  options.access = MappedTextFile::ACCESS_RANDOM;
+  MappedTextFile terminated(filename.c_str(), options);
+  ASSERT_EQ(expected.size(), terminated.lineCount());
+  for (size_t i = 0; i < expected.size(); ++i) {
+    SIMDString<64> simdstring1 = terminated.lineString<SIMDString<64>>(i);
+    EXPECT_STREQ(expected[i].c_str(), simdstring1.c_str());
+    EXPECT_EQ(i + 1 < expected.size(), simdstring1.is_borrowed());
+  }
+  terminated.close();
+
+  // the file itself is unchanged
+  std::ifstream in(filename, std::ios::binary);
+  std::string reread((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+  EXPECT_EQ(contents, reread);
+
+  std::atomic<size_t> totalSize(0), lineCount(0);
+  file.parallelForEachLine([&](size_t i, std::string_view line) {
+    EXPECT_EQ(expected[i], line);
+    totalSize += line.size();
+    ++lineCount;
+  }, 3);
+  EXPECT_EQ(expected.size(), lineCount.load());
+  size_t expectedSize = 0;
+  for (const std::string& line : expected) expectedSize += line.size();
+  EXPECT_EQ(expectedSize, totalSize.load());
+
+  // a long file exercises the SIMD scan across blocks
+  {
+    std::ofstream out(filename, std::ios::binary);
+    for (int i = 0; i < 1000; ++i) out << std::string(i % 37, 'a' + (i % 26)) << '\n';
+  }
+  ASSERT_TRUE(file.open(filename.c_str()));
+  ASSERT_EQ(1000, file.lineCount());
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_EQ(std::string(i % 37, 'a' + (i % 26)), file.line(i));
+  }
+  file.close();
+
+  std::filesystem::remove(filename);
+}
+
+TEST(SIMDStringStreamTest, Format){
+  SIMDStringStream<SIMDString<64>> ss1;
+  std::ostringstream oss1;
+
+  ss1 << "Frame " << 42 << " took " << 16.5 << " ms" << std::setw(8) << std::setfill('.') << 'x';
+  oss1 << "Frame " << 42 << " took " << 16.5 << " ms" << std::setw(8) << std::setfill('.') << 'x';
+  EXPECT_EQ(oss1.str(), ss1.view());
+
+  SIMDString<64> simdstring1 = ss1.take();
+  EXPECT_STREQ(oss1.str().c_str(), simdstring1.c_str());
+  EXPECT_EQ(0, ss1.view().size());
+
+  // long messages grow through the heap
+  std::string expected;
+  for (int i = 0; i < 1000; ++i) {
+    ss1 << i << ',';
+    expected += std::to_string(i) + ',';
+  }
+  ss1 << SIMDString<64>(sampleStringLarge);
+  expected += sampleStringLarge;
+  ss1.write(sampleStringLarge, sampleStringLargeSize);
+  expected.append(sampleStringLarge, sampleStringLargeSize);
+  EXPECT_EQ(expected, ss1.view());
+
+  // reset keeps capacity
+  ss1.reset();
+  EXPECT_EQ(0, ss1.view().size());
+  const char* heapData = ss1.view().data();
+  ss1 << "again";
+  EXPECT_EQ("again", ss1.view());
+  EXPECT_EQ(heapData, ss1.view().data());
+
+  SIMDString<64> simdstring2 = ss1.take();
+  EXPECT_STREQ("again", simdstring2.c_str());
+  EXPECT_EQ(heapData, simdstring2.c_str());
+
+  ss1 << std::flush << "after take";
+  EXPECT_STREQ("after take", ss1.take().c_str());
+}
+
+#ifndef _WIN32
+TEST(SIMDStringIOTest, WriteAll){
+  const std::string filename = (std::filesystem::temp_directory_path() / "SIMDStringTest_WriteAll.txt").string();
+
+  // const segment, internal buffer and heap strings, with enough entries to need several writev calls
+  std::vector<SIMDString<64>> lines;
+  std::string expected;
+  for (int i = 0; i < 3000; ++i) {
+    switch (i % 4) {
+      case 0: lines.push_back(SIMDString<64>("const segment")); break;
+      case 1: lines.push_back(to_string(i)); break;
+      case 2: lines.push_back(SIMDString<64>(sampleStringLarge, sampleStringLargeSize)); break;
+      default: lines.push_back(SIMDString<64>()); break;
+    }
+    expected.append(lines.back().data(), lines.back().size());
+    expected += "\n";
+  }
+
+  int fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  ASSERT_GE(fd, 0);
+  EXPECT_TRUE(write_all(fd, lines, "\n"));
+  std::vector<std::string_view> views = { "no", " ", "separator" };
+  EXPECT_TRUE(write_all(fd, views));
+  // Short pieces that follow a long one in memory extend its iovec instead of being staged
+  const std::string_view large(sampleStringLarge, sampleStringLargeSize);
+  std::vector<std::string_view> adjacent = { large.substr(0, 200) };
+  for (size_t i = 200; i + 10 <= large.size(); i += 10) { adjacent.push_back(large.substr(i, 10)); }
+  EXPECT_TRUE(write_all(fd, adjacent));
+  ::close(fd);
+  expected += "no separator";
+  expected.append(large.data(), 200 + (large.size() - 200) / 10 * 10);
+
+  std::ifstream in(filename, std::ios::binary);
+  std::string actual((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+  EXPECT_EQ(expected, actual);
+
+  EXPECT_FALSE(write_all(-1, lines));
+  EXPECT_EQ(EBADF, errno);
+
+  std::filesystem::remove(filename);
+}
+#endif
+
+template<class Range>
+static std::vector<std::string> collectTokens(const Range& range) {
+  std::vector<std::string> result;
+  for (std::string_view token : range) { result.push_back(std::string(token)); }
+  return result;
+}
+
+TEST(SIMDStringSplitTest, Split){
+  typedef std::vector<std::string> Tokens;
+
+  EXPECT_EQ(Tokens({"a", "b", "", "c"}), collectTokens(split("a,b,,c", ",")));
+  EXPECT_EQ(Tokens({"a", "b", "c"}), collectTokens(split("a,b;;c", ",;", SplitOptions{true})));
+  EXPECT_EQ(Tokens({""}), collectTokens(split("", ",")));
+  EXPECT_EQ(Tokens({"", ""}), collectTokens(split(",", ",")));
+  EXPECT_EQ(Tokens({}), collectTokens(split("", ",", SplitOptions{true})));
+  EXPECT_EQ(Tokens({"no delimiters"}), collectTokens(split("no delimiters", ",")));
+
+  // trimming and quoting
+  SplitOptions options;
+  options.trim = true;
+  EXPECT_EQ(Tokens({"x", "y z", ""}), collectTokens(split("  x , y z\t,  ", ",", options)));
+  options.quote = '\'';
+  EXPECT_EQ(Tokens({"1", "a, b", "", "3"}), collectTokens(split("1, 'a, b' ,'', 3", ",", options)));
+  EXPECT_EQ(Tokens({"say", "hello world", "", "now"}), collectTokens(tokens(SIMDString<64>("  say \"hello world\"  \"\" now\n"))));
+
+  // long strings take the vectorized paths, with delimiters at every offset in a 16-byte block: the
+  // per-member compare for up to four delimiters, and the nibble lookup or scalar bitmap for more
+  for (const char* delimiters : {"|#\x7f", "|#\x7f;:/", "|#\x7f;:\xe9"}) {
+    const size_t count = ::strlen(delimiters);
+    std::string text;
+    Tokens expected;
+    for (int i = 0; i < 40; ++i) {
+      expected.push_back(std::string(size_t(i), char('a' + i % 26)));
+      text += expected.back();
+      text += delimiters[size_t(i) % count];
+    }
+    expected.push_back("");
+    EXPECT_EQ(expected, collectTokens(split(SIMDString<64>(text.c_str()), delimiters)));
+  }
+
+  // non-ASCII delimiters
+  EXPECT_EQ(Tokens({"caf", "", "x"}), collectTokens(split("caf\xc3\xa9x", "\xc3\xa9")));
+
+  // iterators
+  SplitRange range = split(sampleString, " ");
+  EXPECT_EQ(9, std::distance(range.begin(), range.end()));
+  SplitRange::iterator it = range.begin();
+  EXPECT_EQ("quick", *++it);
+  EXPECT_EQ(5, it->size());
+  EXPECT_TRUE(range.begin() != it);
+  EXPECT_EQ(sampleString + 4, it->data());
+}
+
+TEST(SIMDStringTemplateTest, Substitute){
+  std::unordered_map<std::string_view, SIMDString<64>> values;
+  values["player"] = "Ada";
+  values["n"] = "12";
+
+  EXPECT_STREQ("Hello Ada, you have 12 coins",
+    substitute("Hello ${player}, you have ${n} coins", values).c_str());
+  // unknown keys and unterminated placeholders are copied
+  EXPECT_STREQ("${who} has 12 and ${n", substitute("${who} has ${n} and ${n", values).c_str());
+  EXPECT_STREQ("", substitute("", values).c_str());
+
+  std::map<std::string, std::string> stdValues = { { "a", "1" }, { "b", std::string(100, 'b') } };
+  EXPECT_EQ(SIMDString<>("1-" + std::string(100, 'b') + "-1"), substitute("${a}-${b}-${a}", stdValues));
+
+  // more replacements than are recorded on the stack
+  std::string many, manyExpected;
+  for (int i = 0; i < 100; ++i) {
+    many += (i % 3) ? "${n}," : "${x},";
+    manyExpected += (i % 3) ? "12," : "${x},";
+  }
+  EXPECT_EQ(manyExpected, std::string(substitute(many, values).c_str()));
+
+  SIMDStringTemplate hud("Hello ${player}, you have ${n} coins. Bye ${player}${missing}");
+  EXPECT_EQ(3, hud.key_count());
+  EXPECT_EQ("n", hud.key(1));
+  EXPECT_EQ(2, hud.key_index("missing"));
+  EXPECT_EQ(SIMDStringTemplate::npos, hud.key_index("nope"));
+  EXPECT_STREQ("Hello Ada, you have 12 coins. Bye Ada${missing}", hud.substitute(values).c_str());
+
+  const std::string_view bound[] = { "Bo", "0", "!" };
+  EXPECT_STREQ("Hello Bo, you have 0 coins. Bye Bo!", hud.fill(bound).c_str());
+
+  SIMDStringTemplate literal("no placeholders");
+  EXPECT_EQ(0, literal.key_count());
+  EXPECT_STREQ("no placeholders", literal.substitute(values).c_str());
+}
+
+TEST(SIMDStringInternerTest, Intern){
+  SIMDStringInterner interner;
+  const Symbol albedo = interner.intern("albedoTexture");
+  const Symbol normal = interner.intern(std::string("normalTexture"));
+  EXPECT_TRUE(albedo);
+  EXPECT_FALSE(Symbol());
+  EXPECT_NE(albedo, normal);
+  EXPECT_EQ(albedo, interner.intern(SIMDString<16>("albedoTexture")));
+  EXPECT_EQ(albedo, interner.find("albedoTexture"));
+  EXPECT_FALSE(interner.find("albedo"));
+  EXPECT_EQ(2, interner.size());
+
+  // the empty string is a symbol too
+  const Symbol empty = interner.intern("");
+  EXPECT_TRUE(empty);
+  EXPECT_EQ(empty, interner.intern(std::string_view()));
+  EXPECT_EQ(0, interner.view(empty).size());
+
+  // strings point into the arena without copying
+  EXPECT_EQ("normalTexture", interner.view(normal));
+  SIMDString<64> simdstring1 = interner.str<SIMDString<64>>(normal);
+  EXPECT_TRUE(simdstring1.is_borrowed());
+  EXPECT_EQ(interner.view(normal).data(), simdstring1.data());
+  EXPECT_STREQ("normalTexture", simdstring1.c_str());
+
+  // enough strings to grow every shard's table, and one larger than an arena chunk
+  std::vector<Symbol> symbols;
+  for (int i = 0; i < 5000; ++i) {
+    symbols.push_back(interner.intern("name" + std::to_string(i)));
+  }
+  const std::string large(100000, 'x');
+  const Symbol largeSymbol = interner.intern(large);
+  for (int i = 0; i < 5000; ++i) {
+    EXPECT_EQ(symbols[i], interner.find("name" + std::to_string(i)));
+    EXPECT_EQ("name" + std::to_string(i), interner.view(symbols[i]));
+  }
+  EXPECT_EQ(large, interner.view(largeSymbol));
+  EXPECT_EQ(5004, interner.size());
+
+  std::unordered_map<Symbol, int> bindings;
+  bindings[albedo] = 1;
+  EXPECT_EQ(1, bindings[interner.intern("albedoTexture")]);
+}
+
+TEST(SIMDStringInternerTest, Threads){
+  SIMDStringInterner interner;
+  const int threadCount = 4;
+  // a power of two, so that each odd stride below visits every name
+  const int nameCount = 2048;
+  std::vector<std::vector<Symbol>> results(threadCount, std::vector<Symbol>(nameCount));
+  std::vector<std::thread> threads;
+  for (int t = 0; t < threadCount; ++t) {
+    threads.emplace_back([&, t]() {
+      // each thread interns the same names in a different order
+      for (int i = 0; i < nameCount; ++i) {
+        const int n = (i * (2 * t + 1) + t * 101) % nameCount;
+        results[t][n] = interner.intern("u_param" + std::to_string(n));
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(nameCount, interner.size());
+  for (int t = 1; t < threadCount; ++t) {
+    EXPECT_EQ(results[0], results[t]);
+  }
+  EXPECT_EQ("u_param17", interner.view(results[0][17]));
+}
+
+enum TestBlendMode { TEST_BLEND_OPAQUE, TEST_BLEND_ALPHA, TEST_BLEND_ADDITIVE };
+
+// Script-binding style names "bind_0" through "bind_<N - 1>", generated at compile time
+template<size_t N>
+struct TestBindingNames {
+  char chars[N][12] = {};
+
+  constexpr TestBindingNames() {
+    for (size_t i = 0; i < N; ++i) {
+      char digits[8] = {};
+      size_t length = 0;
+      for (size_t v = i; (length == 0) || (v > 0); v /= 10) { digits[length++] = char('0' + v % 10); }
+      size_t k = 0;
+      for (const char c : { 'b', 'i', 'n', 'd', '_' }) { chars[i][k++] = c; }
+      while (length > 0) { chars[i][k++] = digits[--length]; }
+    }
+  }
+};
+
+template<size_t N>
+struct TestBindingViews {
+  std::string_view views[N] = {};
+
+  constexpr TestBindingViews(const TestBindingNames<N>& names) {
+    for (size_t i = 0; i < N; ++i) { views[i] = std::string_view(names.chars[i]); }
+  }
+};
+
+static constexpr TestBindingNames<500> testBindingNames;
+static constexpr TestBindingViews<500> testBindingViews(testBindingNames);
+
+TEST(SIMDStringSwitchTest, PerfectHash){
+  static constexpr auto methods = make_perfect_hash({ "getName", "setName", "destroy", "getPosition",
+    "setPosition", "", "clone", "getParent", "setParent", "findFirstChild", "isA", "getChildren" });
+  static_assert(methods.find("destroy") == 2, "evaluated at compile time");
+  static_assert(methods.find("destroyed") == methods.npos, "evaluated at compile time");
+
+  for (size_t i = 0; i < methods.size(); ++i) {
+    EXPECT_EQ(i, methods.find(methods.key(i)));
+    EXPECT_EQ(i, methods.find(SIMDString<64>(methods.key(i))));
+  }
+  EXPECT_EQ(methods.npos, methods.find("getname"));
+  EXPECT_EQ(methods.npos, methods.find(SIMDString<64>(sampleString)));
+  EXPECT_EQ(5, methods.find(std::string_view()));
+
+  int dispatched = -1;
+  switch (methods.find(SIMDString<64>("clone"))) {
+  case methods.find("getName"): dispatched = 0; break;
+  case methods.find("clone"): dispatched = 1; break;
+  default: break;
+  }
+  EXPECT_EQ(1, dispatched);
+
+  // hundreds of keys stay within the compiler's constant-evaluation limits
+  static constexpr auto bindings = make_perfect_hash(testBindingViews.views);
+  for (size_t i = 0; i < 500; ++i) {
+    EXPECT_EQ(i, bindings.find(testBindingViews.views[i]));
+  }
+  EXPECT_EQ(bindings.npos, bindings.find("bind_500"));
+
+  static constexpr auto single = make_perfect_hash({ "only" });
+  EXPECT_EQ(0, single.find("only"));
+  EXPECT_EQ(single.npos, single.find("other"));
+
+  static constexpr auto blendModes = make_enum_names<TestBlendMode>({ "OPAQUE", "ALPHA", "ADDITIVE" });
+  SIMDString<64> simdstring1 = blendModes.to_string<SIMDString<64>>(TEST_BLEND_ALPHA);
+  EXPECT_STREQ("ALPHA", simdstring1.c_str());
+  EXPECT_TRUE(simdstring1.is_borrowed());
+  EXPECT_EQ(blendModes.name(TEST_BLEND_ALPHA).data(), simdstring1.data());
+
+  TestBlendMode mode = TEST_BLEND_OPAQUE;
+  EXPECT_TRUE(blendModes.from_string(SIMDString<64>("ADDITIVE"), mode));
+  EXPECT_EQ(TEST_BLEND_ADDITIVE, mode);
+  EXPECT_FALSE(blendModes.from_string("additive", mode));
+  EXPECT_EQ(TEST_BLEND_ADDITIVE, mode);
+}
+
+TEST(SIMDStringRadixTreeTest, Queries){
+  SIMDStringRadixTree<int> tree;
+  std::map<std::string, int> expected;
+  // keys that are prefixes of each other, share long prefixes, and branch on every byte value
+  const char* const words[] = { "a", "ab", "abc", "abd", "b", "assets/textures/brick.png",
+    "assets/textures/brick_normal.png", "assets/sounds/step.wav", "", "assets/" };
+  for (const char* word : words) {
+    expected[word] = int(expected.size());
+    EXPECT_TRUE(tree.insert(word, expected[word]));
+  }
+  for (int i = 0; i < 256; ++i) {
+    const std::string key = std::string("bytes/") + char(i) + std::to_string(i);
+    expected[key] = i;
+    EXPECT_TRUE(tree.insert(key, i));
+  }
+  for (int i = 0; i < 2000; ++i) {
+    const std::string key = "assets/models/" + std::to_string(i * 7919 % 2000) + ".mesh";
+    expected[key] = i;
+    tree[key] = i;
+  }
+  EXPECT_FALSE(tree.insert("ab", 100));
+  EXPECT_EQ(expected.size(), tree.size());
+
+  for (const auto& entry : expected) {
+    ASSERT_NE(nullptr, tree.find(entry.first)) << entry.first;
+    EXPECT_EQ(entry.second, *tree.find(entry.first));
+  }
+  EXPECT_EQ(nullptr, tree.find("abe"));
+  EXPECT_EQ(nullptr, tree.find("assets"));
+  EXPECT_FALSE(tree.contains("assets/textures/brick"));
+  EXPECT_TRUE(tree.contains(""));
+
+  // ordered traversal
+  std::vector<std::string> all;
+  tree.for_each([&](const SIMDString<>& key, int) { all.push_back(std::string(key.data(), key.size())); });
+  std::vector<std::string> sorted;
+  for (const auto& entry : expected) {
+    sorted.push_back(entry.first);
+  }
+  EXPECT_EQ(sorted, all);
+
+  // prefix queries, including one that ends inside a compressed prefix, and early exit
+  std::vector<std::string> textures;
+  tree.for_each_prefix("assets/tex", [&](const SIMDString<>& key, int) { textures.push_back(key.c_str()); });
+  EXPECT_EQ(std::vector<std::string>({ "assets/textures/brick.png", "assets/textures/brick_normal.png" }), textures);
+  std::vector<std::string> ab;
+  tree.for_each_prefix("ab", [&](const SIMDString<>& key, int) { ab.push_back(key.c_str()); });
+  EXPECT_EQ(std::vector<std::string>({ "ab", "abc", "abd" }), ab);
+  size_t models = 0;
+  tree.for_each_prefix("assets/models/1", [&](const SIMDString<>&, int) { return ++models < 5; });
+  EXPECT_EQ(5, models);
+  size_t none = 0;
+  tree.for_each_prefix("assets/texturez", [&](const SIMDString<>&, int) { ++none; });
+  tree.for_each_prefix("zzz", [&](const SIMDString<>&, int) { ++none; });
+  EXPECT_EQ(0, none);
+
+  // longest prefix match
+  EXPECT_STREQ("abc", tree.longest_prefix("abcdef").first->c_str());
+  EXPECT_EQ(expected["abc"], *tree.longest_prefix("abcdef").second);
+  EXPECT_STREQ("assets/", tree.longest_prefix("assets/textures/brick").first->c_str());
+  EXPECT_STREQ("", tree.longest_prefix("zzz").first->c_str());
+  SIMDStringRadixTree<int> emptyTree;
+  EXPECT_EQ(nullptr, emptyTree.longest_prefix("a").first);
+
+  // every node type is in use
+  const SIMDStringRadixTree<int>::MemoryUsage usage = tree.memory_usage();
+  EXPECT_EQ(tree.size(), usage.count[SIMDStringRadixTree<int>::LEAF]);
+  EXPECT_LT(0, usage.count[SIMDStringRadixTree<int>::NODE_4]);
+  EXPECT_LT(0, usage.count[SIMDStringRadixTree<int>::NODE_16]);
+  EXPECT_LT(0, usage.count[SIMDStringRadixTree<int>::NODE_256]);
+  EXPECT_LT(0, usage.totalBytes());
+
+  tree.clear();
+  EXPECT_TRUE(tree.empty());
+  EXPECT_EQ(nullptr, tree.find("a"));
+}
+
+TEST(SIMDStringDictionaryTest, Lookup){
+  std::vector<SIMDString<64>> keys;
+  for (int i = 0; i < 500; ++i) {
+    keys.push_back(SIMDString<64>("ui.menu.options.") + to_string(i % 7) + ".item" + to_string(i * 37 % 500));
+  }
+  // unsorted, with duplicates, prefixes of other keys, and a key longer than the internal buffer
+  keys.push_back("ui.menu.options.3");
+  keys.push_back("ui.menu.options.3.item1");
+  keys.push_back("");
+  keys.push_back(sampleString);
+  std::set<std::string> expected;
+  for (const SIMDString<64>& key : keys) {
+    expected.insert(std::string(key.c_str()));
+  }
+  const std::vector<std::string> sorted(expected.begin(), expected.end());
+
+  for (uint32_t blockSize : { 1u, 3u, 16u }) {
+    const SIMDStringDictionary dictionary = SIMDStringDictionary::build(keys, blockSize);
+    ASSERT_EQ(sorted.size(), dictionary.size());
+
+    SIMDString<64> buffer;
+    for (size_t i = 0; i < sorted.size(); ++i) {
+      EXPECT_EQ(i, dictionary.find(sorted[i])) << sorted[i];
+      dictionary.get(i, buffer);
+      EXPECT_STREQ(sorted[i].c_str(), buffer.c_str());
+    }
+    EXPECT_STREQ(sorted[5].c_str(), dictionary[5].c_str());
+
+    for (const char* missing : { " ", "a", "ui.menu.options.", "ui.menu.options.3.", "ui.menu.options.3.item10x",
+                                 "ui.menu.options.3.item1 ", "ui.menu.options.9", "zzz" }) {
+      EXPECT_EQ(SIMDStringDictionary::npos, dictionary.find(missing)) << missing;
+    }
+
+    size_t visited = 0;
+    dictionary.for_each([&](size_t index, const SIMDString<>& str) {
+      EXPECT_EQ(visited++, index);
+      EXPECT_STREQ(sorted[index].c_str(), str.c_str());
+    });
+    EXPECT_EQ(sorted.size(), visited);
+
+    // the serialized form is used in place
+    const std::string file(dictionary.bytes());
+    SIMDStringDictionary loaded;
+    EXPECT_TRUE(loaded.open(file));
+    EXPECT_EQ(sorted.size(), loaded.size());
+    EXPECT_EQ(17, loaded.find(sorted[17]));
+    EXPECT_EQ(SIMDStringDictionary::npos, loaded.find("zzz"));
+  }
+
+  const SIMDStringDictionary compact = SIMDStringDictionary::build(keys);
+  EXPECT_GT(sorted.size() * 10, compact.bytes().size());
+
+  SIMDStringDictionary invalid;
+  EXPECT_FALSE(invalid.open("not a dictionary"));
+  EXPECT_TRUE(invalid.empty());
+  EXPECT_EQ(SIMDStringDictionary::npos, invalid.find(""));
+
+  // truncated and corrupted buffers are rejected, or if still consistent, decode within their bounds
+  const std::string serialized(compact.bytes());
+  for (size_t size = 0; size < serialized.size(); ++size) {
+    EXPECT_FALSE(invalid.open(std::string_view(serialized.data(), size))) << size;
+  }
+  for (size_t i = 0; i < serialized.size(); ++i) {
+    std::vector<char> corrupt(serialized.begin(), serialized.end());
+    corrupt[i] = char(0xFF);
+    if (invalid.open(std::string_view(corrupt.data(), corrupt.size()))) {
+      invalid.for_each([](size_t, const SIMDString<>&) {});
+      invalid.find("ui.menu.options.3.item1");
+    }
+  }
+  EXPECT_TRUE(invalid.open(serialized));
+  EXPECT_EQ(sorted.size(), invalid.size());
+
+  const SIMDStringDictionary empty = SIMDStringDictionary::build(std::vector<std::string>());
+  EXPECT_EQ(0, empty.size());
+  EXPECT_EQ(SIMDStringDictionary::npos, empty.find(""));
+}
+
+TEST(SIMDStringColumnTest, BatchQueries){
+  std::vector<SIMDString<64>> names;
+  for (int i = 0; i < 300; ++i) {
+    names.push_back(SIMDString<64>((i % 3) ? "npc_" : "prop_") + to_string(i % 40));
+  }
+  names.push_back("");
+  names.push_back("npc_0123456789ab");
+  names.push_back("npc_0123456789abc");
+  names.push_back(sampleString);
+
+  for (bool padded : { true, false }) {
+    SIMDStringColumn column(padded);
+    for (const SIMDString<64>& name : names) {
+      column.push_back(name);
+    }
+    ASSERT_EQ(names.size(), column.size());
+    EXPECT_EQ("npc_0123456789ab", column[names.size() - 3]);
+
+    SIMDStringColumn::Bitmask mask;
+    for (const char* literal : { "npc_7", "prop_0", "", "npc_0123456789ab", "npc_0123456789abc", "missing" }) {
+      column.equals(literal, mask);
+      size_t expected = 0;
+      for (size_t i = 0; i < names.size(); ++i) {
+        EXPECT_EQ(names[i] == literal, SIMDStringColumn::test(mask, i)) << literal << " " << i;
+        expected += (names[i] == literal);
+      }
+      EXPECT_EQ(expected, SIMDStringColumn::count(mask));
+    }
+
+    for (const char* prefix : { "npc_", "prop_3", "", "npc_0123456789ab", "npc_0123456789abc", "Lorem ipsum dolor sit" }) {
+      column.starts_with(prefix, mask);
+      for (size_t i = 0; i < names.size(); ++i) {
+        EXPECT_EQ(names[i].starts_with(prefix), SIMDStringColumn::test(mask, i)) << prefix << " " << i;
+      }
+    }
+
+    for (char c : { '7', 'c', '\0', 'Z' }) {
+      column.contains(c, mask);
+      for (size_t i = 0; i < names.size(); ++i) {
+        EXPECT_EQ(names[i].find(c) != SIMDString<64>::npos, SIMDStringColumn::test(mask, i)) << c << " " << i;
+      }
+    }
+
+    std::vector<size_t> hashes;
+    column.hash_all(hashes);
+    for (size_t i = 0; i < names.size(); ++i) {
+      EXPECT_EQ(std::hash<SIMDString<64>>{}(names[i]), hashes[i]);
+    }
+  }
+}
+
+TEST(SIMDStringTest, Parallel){
+  const SIMDStringParallel parallel = { 4 };
+  const size_t length = 4 * SIMDSTRING_PARALLEL_THRESHOLD + 5;
+  SIMDString<64> big(length, 'a');
+  for (size_t i = 0; i < length; i += 1000) {
+    big[i] = '\n';
+  }
+
+  // Four slices of about SIMDSTRING_PARALLEL_THRESHOLD starting positions each. Put needles across
+  // the slice boundaries and at both ends.
+  const std::string_view needle = "needle";
+  const size_t slice = (length - needle.size() + 1 + 3) / 4;
+  for (size_t at : { size_t(1), slice - 3, 2 * slice - 1, 3 * slice - 5, length - needle.size() }) {
+    ::memcpy(&big[at], needle.data(), needle.size());
+  }
+  const std::string reference(big.data(), big.size());
+
+  for (size_t pos : { size_t(0), size_t(2), slice - 2, 3 * slice, length - 3, length + 1 }) {
+    EXPECT_EQ(reference.find(needle, pos), big.find(needle, pos, parallel)) << pos;
+    EXPECT_EQ(reference.rfind(needle, pos), big.rfind(needle, pos, parallel)) << pos;
+    EXPECT_EQ(reference.find("missing", pos), big.find("missing", pos, parallel)) << pos;
+    EXPECT_EQ(reference.rfind("missing", pos), big.rfind("missing", pos, parallel)) << pos;
+  }
+  EXPECT_EQ(reference.rfind(needle), big.rfind(needle, SIMDString<64>::npos, parallel));
+  EXPECT_EQ(size_t(3), big.find("", 3, parallel));
+
+  const size_t newlines = size_t(std::count(reference.begin(), reference.end(), '\n'));
+  EXPECT_EQ(newlines, big.count('\n'));
+  EXPECT_EQ(newlines, big.count('\n', parallel));
+  EXPECT_EQ(size_t(2), SIMDString<64>("a\nb\n").count('\n', parallel));
+
+  const SIMDString<64> copy(big, parallel);
+  EXPECT_TRUE(copy == big);
+
+  SIMDString<64> appended("head");
+  appended.append(big, parallel);
+  appended.append(std::string_view(big.data(), 100), parallel);
+  EXPECT_EQ("head" + reference + reference.substr(0, 100), std::string(appended.data(), appended.size()));
+
+  // Growing while appending itself
+  SIMDString<64> doubled = big;
+  doubled.append(doubled, parallel);
+  doubled.append(doubled, parallel);
+  EXPECT_EQ(reference + reference + reference + reference, std::string(doubled.data(), doubled.size()));
+
+  // Growing out of the internal buffer while appending itself from it
+  SIMDString<64> inlineString;
+  for (int i = 0; i < 40; ++i) { inlineString += char('a' + i % 26); }
+  const std::string inlineReference(inlineString.data(), inlineString.size());
+  inlineString.append(inlineString, SIMDStringParallel{});
+  EXPECT_EQ(inlineReference + inlineReference, std::string(inlineString.data(), inlineString.size()));
+}
+
+TEST(SIMDStringTest, Searcher){
+  // Two-letter alphabets make many partial matches, and runs of one letter make periodic needles.
+  // Needles from the random bytes in between select Horspool and Two-Way.
+  uint32_t r = 1;
+  auto next = [&]() { r = r * 1664525u + 1013904223u; return r >> 16; };
+  std::string haystack;
+  std::vector<size_t> randomStarts;
+  for (int i = 0; i < 3000; ++i) {
+    haystack += (next() % 7 == 0) ? std::string(size_t(next() % 300), 'a') : std::string(1, char('a' + next() % 2));
+    if (i % 1000 == 0) {
+      randomStarts.push_back(haystack.size());
+      for (int k = 0; k < 1000; ++k) { haystack += char(next()); }
+    }
+  }
+  std::set<SIMDStringSearcher::Strategy> strategies;
+  const SIMDString<64> simdHaystack(haystack.data(), haystack.size());
+
+  for (size_t length : { 0, 1, 2, 3, 7, 16, 17, 31, 32, 33, 64, 255, 256, 300, 600 }) {
+    std::vector<std::string> needles = { std::string(length, 'a'), std::string(length, 'b') };
+    for (int k = 0; k < 4; ++k) {
+      needles.push_back(haystack.substr(next() % (haystack.size() - length), length));
+    }
+    for (size_t start : randomStarts) {
+      needles.push_back(haystack.substr(start + next() % 300, length));
+    }
+    if (length > 1) { needles.push_back(std::string(length - 1, 'a') + "b"); }
+
+    for (const std::string& needle : needles) {
+      const SIMDString<64>::Searcher searcher(needle);
+      EXPECT_EQ(needle, searcher.needle());
+      strategies.insert(searcher.strategy());
+      for (size_t pos : { size_t(0), size_t(1), size_t(100), haystack.size() / 2, haystack.size() - length, haystack.size(), haystack.size() + 5 }) {
+        ASSERT_EQ(haystack.find(needle, pos), searcher.find_in(simdHaystack, pos)) << length << " " << pos;
+        ASSERT_EQ(haystack.rfind(needle, pos), searcher.rfind_in(std::string_view(haystack), pos)) << length << " " << pos;
+        ASSERT_EQ(haystack.find(needle, pos), simdHaystack.find(needle.data(), pos, needle.size())) << length << " " << pos;
+        if (pos < haystack.size()) {
+          ASSERT_EQ(haystack.rfind(needle, pos), simdHaystack.rfind(needle.data(), pos, needle.size())) << length << " " << pos;
+        }
+      }
+      ASSERT_EQ(haystack.rfind(needle), searcher.rfind_in(haystack)) << length;
+
+      size_t count = 0;
+      for (size_t i = haystack.find(needle); (i != std::string::npos) && ! needle.empty(); i = haystack.find(needle, i + needle.size())) {
+        ++count;
+      }
+      EXPECT_EQ(needle.empty() ? haystack.size() + 1 : count, searcher.count_in(simdHaystack)) << length;
+    }
+  }
+
+  EXPECT_EQ(5u, strategies.size());
+
+  std::string distinct;
+  for (int c = 0; c < 256; ++c) { distinct += char(c); }
+  EXPECT_EQ(SIMDStringSearcher::Strategy::BYTE, SIMDStringSearcher("x").strategy());
+  EXPECT_EQ(SIMDStringSearcher::Strategy::FILTER, SIMDStringSearcher("[fatal]").strategy());
+  EXPECT_EQ(SIMDStringSearcher::Strategy::FILTER, SIMDStringSearcher(std::string(SIMDStringSearcher::TWO_WAY_MIN_LENGTH, 'x')).strategy());
+  EXPECT_EQ(SIMDStringSearcher::Strategy::HORSPOOL, SIMDStringSearcher(distinct.substr(0, 100)).strategy());
+  EXPECT_EQ(SIMDStringSearcher::Strategy::TWO_WAY, SIMDStringSearcher(distinct).strategy());
+
+  const SIMDStringSearcher fatal(SIMDString<64>("[fatal]"));
+  EXPECT_EQ(size_t(4), fatal.find_in("log [fatal] x"));
+  EXPECT_EQ(SIMDStringSearcher::npos, fatal.find_in(""));
+  EXPECT_EQ(SIMDStringSearcher::npos, fatal.rfind_in("[fatal"));
+  EXPECT_EQ(size_t(2), fatal.count_in(SIMDString<64>("[fatal][fatal][fatal")));
+}
+
+TEST(SIMDStringTest, CaseInsensitive){
+  auto lower = [](std::string s) {
+    for (char& c : s) { c = ((c >= 'A') && (c <= 'Z')) ? char(c + 32) : c; }
+    return s;
+  };
+  auto sign = [](int x) { return (x > 0) - (x < 0); };
+
+  // Runs of every byte value, long enough for the SIMD loops and their tails
+  std::string all;
+  for (int c = 0; c < 256; ++c) { all += char(c); }
+  for (size_t length : { 0, 1, 15, 16, 17, 31, 32, 33, 100, 256 }) {
+    const std::string original = all.substr((length * 37) % (257 - length), length);
+    SIMDString<64> s(original.data(), original.size());
+    s.to_lower();
+    ASSERT_EQ(lower(original), std::string(s.data(), s.size())) << length;
+    s.to_upper();
+    std::string upper = original;
+    for (char& c : upper) { c = ((c >= 'a') && (c <= 'z')) ? char(c - 32) : c; }
+    ASSERT_EQ(upper, std::string(s.data(), s.size())) << length;
+  }
+
+  // Constant strings are copied before conversion
+  SIMDString<64> constant("Textures/Hero_Diffuse.PNG");
+  EXPECT_EQ("textures/hero_diffuse.png", constant.to_lower());
+  EXPECT_EQ("TEXTURES/HERO_DIFFUSE.PNG", constant.to_upper());
+  EXPECT_EQ(SIMDString<64>(), SIMDString<64>().to_lower());
+
+  const std::vector<std::string> words = {
+    "", "a", "A", "b", "B", "[", "_", "`", "@", "Z", "z", "\xC3\x89", "\xC3\xA9",
+    "textures/Characters/Hero.png", "TEXTURES/characters/hero.PNG", "textures/characters/hero.png2",
+    "Graphics.VSync", "graphics.vsync", "graphics.vsynd", std::string("nul\0L", 5), std::string("NUL\0l", 5) };
+  for (const std::string& a : words) {
+    const SIMDString<64> s(a.data(), a.size());
+    for (const std::string& b : words) {
+      const bool equal = (lower(a) == lower(b));
+      EXPECT_EQ(equal, s.iequals(b)) << a << " " << b;
+      EXPECT_EQ(sign(lower(a).compare(lower(b))), sign(s.icompare(b))) << a << " " << b;
+      EXPECT_EQ(equal, CaseInsensitiveEqual()(b, s));
+      EXPECT_EQ(lower(a) < lower(b), CaseInsensitiveLess()(s, b));
+      if (equal) {
+        EXPECT_EQ(s.ihash(), CaseInsensitiveHash()(b)) << a << " " << b;
+      }
+      EXPECT_EQ(lower(a).find(lower(b)), s.ifind(b)) << a << " " << b;
+    }
+  }
+
+  // ifind at every alignment of a long haystack
+  std::string haystack;
+  for (int i = 0; i < 200; ++i) { haystack += (i % 3) ? "Log Line " : "lOG lINE "; }
+  const std::string needle = "line LOG LINE log";
+  const SIMDString<64> simdHaystack(haystack.data(), haystack.size());
+  for (size_t pos = 0; pos <= haystack.size() + 1; pos += 7) {
+    ASSERT_EQ(lower(haystack).find(lower(needle), pos), simdHaystack.ifind(needle, pos)) << pos;
+    ASSERT_EQ(lower(haystack).find("e", pos), simdHaystack.ifind("E", pos)) << pos;
+  }
+  EXPECT_NE(SIMDString<64>("Graphics.VSync").ihash(), SIMDString<64>("graphics.vsynd").ihash());
+
+  std::map<SIMDString<64>, int, CaseInsensitiveLess> settings;
+  settings["Graphics.VSync"] = 1;
+  settings["graphics.vsync"] = 2;
+  EXPECT_EQ(size_t(1), settings.size());
+  ASSERT_TRUE(settings.find("GRAPHICS.VSYNC") != settings.end());
+  EXPECT_EQ(2, settings.find(std::string_view("graphics.VSYNC"))->second);
+
+  std::unordered_map<SIMDString<64>, int, CaseInsensitiveHash, CaseInsensitiveEqual> commands;
+  commands[SIMDString<64>("Quit")] = 7;
+  EXPECT_EQ(7, commands[SIMDString<64>("QUIT")]);
+  EXPECT_EQ(size_t(1), commands.size());
+#if defined(__cpp_lib_generic_unordered_lookup) && (__cpp_lib_generic_unordered_lookup >= 201811L)
+  ASSERT_TRUE(commands.find("quit") != commands.end());
+  EXPECT_EQ(7, commands.find(std::string_view("qUIT"))->second);
+#endif
+}
+
+TEST(SIMDStringHashTest, HashBatch){
+  // Every length up to past the inline buffer, in all four lanes and the remainder
+  std::vector<SIMDString<64>> strings;
+  std::vector<std::string_view> views;
+  for (size_t length = 0; length <= 100; ++length) {
+    strings.push_back(SIMDString<64>(sampleString).substr(length % 7, length));
+    strings.push_back(SIMDString<64>(length, char('a' + length % 26)));
+  }
+  strings.push_back(SIMDString<64>("embedded\0null", 13));
+  strings.push_back("const");
+  for (const SIMDString<64>& s : strings) {
+    views.push_back(std::string_view(s.data(), s.size()));
+  }
+
+  std::vector<size_t> hashes;
+  hash_batch(strings, hashes);
+  ASSERT_EQ(strings.size(), hashes.size());
+  for (size_t i = 0; i < strings.size(); ++i) {
+    EXPECT_EQ(std::hash<SIMDString<64>>{}(strings[i]), hashes[i]) << i;
+    EXPECT_EQ(std::hash<std::string>{}(std::string(strings[i].data(), strings[i].size())), hashes[i]) << i;
+  }
+
+  std::vector<size_t> viewHashes(views.size());
+  hash_batch(views.data(), views.size(), viewHashes.data());
+  EXPECT_EQ(hashes, viewHashes);
+
+  hash_batch(strings.data(), 0, viewHashes.data());
+}
+
+TEST(SIMDStringSortTest, RadixSort){
+  // Enough strings for four threads, with shared 8-byte prefixes, short keys, embedded nulls, and duplicates
+  std::vector<SIMDString<64>> strings;
+  const char* const roots[] = { "textures/", "tex", "", "models/characters/", "a\0b" };
+  for (uint32_t i = 0; i < 4 * SIMDStringSort::PARALLEL_THRESHOLD + 17; ++i) {
+    const uint32_t r = i * 2654435761u;
+    SIMDString<64> s(roots[r % 5], (r % 5 == 4) ? 3 : strlen(roots[r % 5]));
+    s += to_string((r >> 8) % 50000);
+    if (r & 0x100000) { s += sampleString; }
+    strings.push_back(s);
+  }
+
+  std::vector<SIMDString<64>> expected = strings;
+  std::stable_sort(expected.begin(), expected.end());
+
+  std::vector<SIMDString<64>> sorted = strings;
+  SIMDStringSort::radix_sort(sorted, 4);
+  ASSERT_EQ(expected.size(), sorted.size());
+  EXPECT_TRUE(expected == sorted);
+
+  // Stable, so equal strings keep their original order
+  const std::vector<uint32_t> order = SIMDStringSort::radix_sort_order(strings.data(), strings.size(), 4);
+  for (size_t i = 1; i < order.size(); ++i) {
+    ASSERT_TRUE((strings[order[i - 1]] < strings[order[i]]) || ((strings[order[i - 1]] == strings[order[i]]) && (order[i - 1] < order[i]))) << i;
+  }
+
+  expected.erase(std::unique(expected.begin(), expected.end()), expected.end());
+  SIMDStringSort::sort_unique(strings, 4);
+  EXPECT_TRUE(expected == strings);
+
+  // Long runs that differ only past a shared prefix, or only in trailing nulls
+  std::vector<std::string> padded;
+  for (int i = 0; i < 200; ++i) {
+    padded.push_back(std::string("common/prefix/") + std::string(size_t(i * 7 % 19), '\0'));
+    padded.push_back(std::string("common/prefix/") + std::string(size_t(i % 3), 'x') + to_string(i % 50).c_str());
+  }
+  std::vector<std::string> paddedExpected = padded;
+  std::sort(paddedExpected.begin(), paddedExpected.end());
+  SIMDStringSort::radix_sort(padded);
+  EXPECT_EQ(paddedExpected, padded);
+
+  std::vector<std::string> small = { "b", "", "ab", "a", "abcdefghij", "abcdefghi", "b" };
+  SIMDStringSort::sort_unique(small);
+  EXPECT_EQ((std::vector<std::string>{ "", "a", "ab", "abcdefghi", "abcdefghij", "b" }), small);
+
+  std::vector<SIMDString<64>> empty;
+  SIMDStringSort::radix_sort(empty);
+  EXPECT_TRUE(empty.empty());
+}
+
+TEST(SIMDStringMultiSearchTest, MultiPatternSearcher){
+  // Reference: every occurrence of every pattern, found one pattern and one position at a time
+  auto naive = [](const std::vector<std::string>& patterns, const std::string& text, const MultiPatternOptions& options) {
+    auto lower = [](std::string s) {
+      for (char& c : s) { c = ((c >= 'A') && (c <= 'Z')) ? char(c + 32) : c; }
+      return s;
+    };
+    auto isWord = [](char c) { return isalnum((unsigned char)c) || (c == '_') || ((unsigned char)c >= 0x80); };
+    const std::string t = options.caseInsensitive ? lower(text) : text;
+    std::vector<std::pair<size_t, uint32_t>> matches;
+    for (uint32_t i = 0; i < patterns.size(); ++i) {
+      const std::string p = options.caseInsensitive ? lower(patterns[i]) : patterns[i];
+      if (p.empty()) { continue; }
+      for (size_t pos = t.find(p); pos != std::string::npos; pos = t.find(p, pos + 1)) {
+        if (! options.wholeWord || (((pos == 0) || ! isWord(t[pos - 1])) && ((pos + p.size() == t.size()) || ! isWord(t[pos + p.size()])))) {
+          matches.emplace_back(pos, i);
+        }
+      }
+    }
+    std::sort(matches.begin(), matches.end());
+    return matches;
+  };
+
+  static const char text[] =
+    "The quick brown Fox jumps over the lazy dog. the_end, THE END; theme: foxes and dogs.\n"
+    "Her hers she said he; ushers usher his HISTORY\xC3\xA9he\0he 0123 the";
+  const std::string fullText(text, sizeof(text) - 1);
+
+  std::vector<std::vector<std::string>> sets = {
+    { "he", "she", "his", "hers" },
+    { "fox", "the", "dog", "Her", "e", "", "the", "0123 the", "lazy dog. the_end" },
+    { "quick brown Fox jumps over the lazy dog", "x", "\xC3\xA9" },
+  };
+  // More than TEDDY_MAX_PATTERNS, so that Aho-Corasick is used
+  std::vector<std::string> large = sets[1];
+  for (int i = 0; i < 200; ++i) {
+    large.push_back(std::string("w") + to_string(i).c_str());
+  }
+  large.push_back("he");
+  large.push_back("usher");
+  sets.push_back(large);
+
+  for (const std::vector<std::string>& patterns : sets) {
+    for (int flags = 0; flags < 4; ++flags) {
+      const MultiPatternOptions options = { (flags & 1) != 0, (flags & 2) != 0 };
+      const MultiPatternSearcher searcher(patterns, options);
+      EXPECT_EQ(patterns.size(), searcher.size());
+
+      const auto expected = naive(patterns, fullText, options);
+      std::vector<std::pair<size_t, uint32_t>> actual;
+      for (const MultiPatternSearcher::Match& m : searcher.find_all(fullText)) {
+        ASSERT_EQ(patterns[m.pattern].size(), m.length);
+        actual.emplace_back(m.position, m.pattern);
+      }
+      EXPECT_EQ(expected, actual) << flags << " " << patterns.size();
+
+      // Every suffix, so that matches fall at every position of the SIMD blocks and tail
+      for (size_t start = 0; start < fullText.size(); start += 3) {
+        const std::string suffix = fullText.substr(start);
+        const auto suffixExpected = naive(patterns, suffix, options);
+        size_t count = 0;
+        searcher.for_each_match(SIMDString<>(suffix.data(), suffix.size()), [&](const MultiPatternSearcher::Match&) { ++count; });
+        ASSERT_EQ(suffixExpected.size(), count) << start;
+
+        MultiPatternSearcher::Match first;
+        ASSERT_EQ(! suffixExpected.empty(), searcher.find_first(std::string_view(suffix), first));
+        ASSERT_EQ(! suffixExpected.empty(), searcher.contains_any(suffix));
+        if (! suffixExpected.empty()) {
+          EXPECT_EQ(suffixExpected[0].first, first.position) << start;
+          EXPECT_EQ(suffixExpected[0].second, first.pattern) << start;
+        }
+      }
+    }
+  }
+
+  const MultiPatternSearcher teddy({ "alpha", "beta" });
+  const MultiPatternSearcher automaton(large);
+#ifdef SIMDSTRING_SSSE3
+  EXPECT_EQ(MultiPatternSearcher::Engine::TEDDY, teddy.engine());
+#endif
+  EXPECT_EQ(MultiPatternSearcher::Engine::AHO_CORASICK, automaton.engine());
+  EXPECT_EQ("beta", teddy.pattern(1));
+  EXPECT_FALSE(teddy.contains_any(""));
+  EXPECT_FALSE(automaton.contains_any(""));
+
+  // Stop after the first match
+  size_t calls = 0;
+  teddy.for_each_match("alpha beta alpha", [&](const MultiPatternSearcher::Match&) { ++calls; return false; });
+  EXPECT_EQ(1u, calls);
+
+  const MultiPatternSearcher none(std::vector<std::string>{});
+  EXPECT_FALSE(none.contains_any("anything"));
+}
+
+#if defined(__cpp_nontype_template_args) && (__cpp_nontype_template_args >= 201911L)
+TEST(SIMDStringFormatTest, Format){
+  EXPECT_STREQ("HP: 75/100 (75.0%)", format<"HP: {}/{} ({:.1f}%)">(75, 100, 75.0f).c_str());
+  EXPECT_STREQ("no fields", format<"no fields">().c_str());
+  EXPECT_STREQ("{braces} 1", format<"{{braces}} {}">(1).c_str());
+  EXPECT_STREQ("", format<"{}">("").c_str());
+
+  // integers
+  EXPECT_STREQ("-42 ff FF 17 101", format<"{} {:x} {:X} {:o} {:b}">(-42, 255u, 255, 15, 5).c_str());
+  EXPECT_STREQ("-9223372036854775808 18446744073709551615", format<"{} {}">(LLONG_MIN, ULLONG_MAX).c_str());
+  EXPECT_STREQ("-10000000000000000000000000000000 -20000000000 -80000000",
+    format<"{:b} {:o} {:x}">(INT_MIN, INT_MIN, INT_MIN).c_str());
+  EXPECT_STREQ("-10000000 -200 -80", format<"{:b} {:o} {:x}">(int8_t(INT8_MIN), int8_t(INT8_MIN), int8_t(INT8_MIN)).c_str());
+
+  // floats
+  EXPECT_STREQ("0.1 1e+300 3.14 1.50e+00", format<"{} {} {:.2f} {:.2e}">(0.1, 1e300, 3.14159, 1.5).c_str());
+
+  // strings, bool and char
+  SIMDString<64> name("Zander");
+  EXPECT_STREQ("Zander std view Mor true x", format<"{} {} {} {:.3} {} {}">(name, std::string("std"), std::string_view("view"), "Morgan", true, 'x').c_str());
+
+  // width, fill and alignment
+  EXPECT_STREQ("[   42][42   ][ 42  ][-0042][ab   ][   ab][**ab**]",
+    format<"[{:5}][{:<5}][{:^5}][{:05}][{:5}][{:>5}][{:*^6}]">(42, 42, 42, -42, "ab", "ab", "ab").c_str());
+  EXPECT_STREQ("  1.50", format<"{:6.2f}">(1.5).c_str());
+
+  // format_to appends, and long output moves to the heap
+  SIMDString<64> simdstring1("log: ");
+  format_to<"{} {}">(simdstring1, sampleStringLarge, 7);
+  EXPECT_EQ(std::string("log: ") + sampleStringLarge + " 7", simdstring1.c_str());
+
+  // other internal sizes
+  EXPECT_STREQ("7 seven", (format<"{} {}", SIMDString<16>>(7, "seven")).c_str());
+}
+#endif